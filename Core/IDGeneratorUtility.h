@@ -8,6 +8,12 @@
             mID++;
             return mID;
         }
+
+        // IDs up to aID are taken, by nodes loaded from a file for instance
+        void Reserve(s32 aID)
+        {
+            mID = aID > mID ? aID : mID;
+        }
         private:
         s32 mID = 0;
     };
@@ -32,12 +32,17 @@ public:
 
         va_list args; 
         va_start(args, format); 
+
+        // the size pass consumes its list, the second pass needs a fresh copy
+        va_list argsCopy;
+        va_copy(argsCopy, args);
         
         int size = std::vsnprintf(nullptr, 0, format.c_str(), args) + 1; // +1 for null terminator 
         
          std::vector<char> buffer(size); 
-         std::vsnprintf(buffer.data(), size, format.c_str(), args); 
+         std::vsnprintf(buffer.data(), size, format.c_str(), argsCopy); 
          
+         va_end(argsCopy);
          va_end(args); 
          
          LogEntry newEntry = {};
@@ -0,0 +1,65 @@
+#pragma once
+#include "CoreDefines.h"
+#include <atomic>
+
+/******
+ SPSCQueue
+ =========================
+ - Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+  The capacity is rounded up to a power of two, one slot stays empty to tell a full ring from an empty one.
+  try_push/try_pop never block, the caller decides what to do when the ring is full or empty.
+ */
+template <typename T>
+class SPSCQueue {
+public:
+    explicit SPSCQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity + 1) {
+            size <<= 1;
+        }
+        mSlots.resize(size);
+        mMask = size - 1;
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // producer thread only
+    bool try_push(const T& value)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & mMask;
+        if (next == mHead.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        mSlots[tail] = value;
+        mTail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only
+    bool try_pop(T& outValue)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        outValue = mSlots[head];
+        mHead.store((head + 1) & mMask, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire); }
+    size_t capacity() const { return mMask; }
+
+private:
+    std::vector<T> mSlots;
+    size_t mMask = 0;
+
+    // head and tail are written by different threads, keep them on separate cache lines
+    alignas(64) std::atomic<size_t> mHead { 0 };
+    alignas(64) std::atomic<size_t> mTail { 0 };
+};
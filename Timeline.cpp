@@ -5,6 +5,8 @@
 #include "TimelineData/ImDataController.h"
 #include "TimelineViews/INodeView.h"
 #include "TimelineCore/TimelinePlayer.h"
+#include "TimelineCore/TimelineSerializer.h"
+#include "TimelineCore/TimelineTraceImporter.h"
 
 namespace ImTimeline {
 
@@ -23,6 +25,11 @@ Timeline::Timeline()
         mMainPlayer->Setup(nullptr, 0);
     }
 
+    sPlaybackCursor mainCursor;
+    mainCursor.mName = "Main";
+    mainCursor.mPlayer = mMainPlayer;
+    mCursors.push_back(mainCursor);
+
     if (mMainPlayer->GetViewUI() == nullptr) {
         std::shared_ptr debugView = ImTimelineInternal::CreateDefaultPlayerView();
         SetTimelinePlayerUI(debugView);
@@ -36,6 +43,8 @@ Timeline::Timeline()
 TimelineNode* Timeline::AddNewNode(TimelineNode* node)
 {
     IM_ASSERT(node != nullptr);
+    auto lock = lockForEdit();
+
     if (node->ID == InvalidNodeID) {
         node->ID = mIDGenerator.GetUniqueID();
     }
@@ -72,6 +81,7 @@ TimelineNode* Timeline::AddNewNode(TimelineNode* node)
 
     IM_ASSERT(mTimelines[node->section].mNodeData != nullptr);
 
+    flushDeferredRebuild(node->section);
     mTimelines[node->section].mNodeData->emplace_back_direct(*node, descriptor);
 
     NodeInitDescriptor searchDescriptor;
@@ -80,6 +90,8 @@ TimelineNode* Timeline::AddNewNode(TimelineNode* node)
 
     IM_ASSERT(newlyAddedNode != nullptr);
 
+    mNodeSectionIndex[newlyAddedNode->ID] = newlyAddedNode->section;
+
     if (newlyAddedNode->end > this->mFrameMax)
         this->mFrameMax = newlyAddedNode->end + 50;
 
@@ -87,33 +99,36 @@ TimelineNode* Timeline::AddNewNode(TimelineNode* node)
         mTimelines[newlyAddedNode->section].mProps.mEndTimestamp = newlyAddedNode->end;
     }
 
+    reschedulePlayer(newlyAddedNode->section);
+
     return newlyAddedNode;
 }
 
 TimelineNode& Timeline::AddNewNode(s32 section, s32 start, s32 end, const std::string& text, std::shared_ptr<CustomNodeBase> customNodeUI)
 {
-       NodeID uniqueID = mIDGenerator.GetUniqueID();
+    auto lock = lockForEdit();
+    NodeID uniqueID = mIDGenerator.GetUniqueID();
 
-    auto cmd = std::make_unique<ImTimelineInternal::AddCommand>(this);
-    cmd->mNewNode.ID = uniqueID;
-    cmd->mNewNode.section = section;
-    cmd->mNewNode.start = start;
-    cmd->mNewNode.end = end;
-    cmd->mNewNode.displayText = text;
-    
-    if(customNodeUI)
-    {
+    TimelineNode newNode;
+    newNode.Setup(section, start, end, text);
+    newNode.ID = uniqueID;
+    newNode.mFlags = mEmptyDummyNode.mFlags;
+
+    if (customNodeUI) {
         bool bCustomUI = true;
-        cmd->mNewNode.InitalizeCustomNode(customNodeUI, bCustomUI);
+        newNode.InitalizeCustomNode(customNodeUI, bCustomUI);
     }
 
+    auto cmd = std::make_unique<ImTimelineInternal::AddCommand>(this);
+    cmd->mNodeIDs.push_back(uniqueID);
+    cmd->mRecords.emplace_back();
+    cmd->mRecords.back().Capture(newNode);
     cmd->command_do();
 
     PushCommand(std::move(cmd));
-    // WARNING mNewNode becomes invalidated
 
     if (mTimelines.find(section) == mTimelines.end()) {
-        LOG_WARNING_PRINTF("DeleteItem section %d does not exist", section);
+        LOG_WARNING_PRINTF("AddNewNode section %d does not exist", section);
         return mEmptyDummyNode;
     }
 
@@ -128,14 +143,196 @@ TimelineNode& Timeline::AddNewNode(s32 section, s32 start, s32 end, const std::s
     return mEmptyDummyNode;
 }
 
+size_t Timeline::AddNodesBulk(const NodeInitDescriptor* descriptors, size_t count)
+{
+    return addNodesBulk(descriptors, count, mEmptyDummyNode.mFlags);
+}
+
+size_t Timeline::addNodesBulk(const NodeInitDescriptor* descriptors, size_t count, const std::bitset<eTimelineNodeFlags::TimelineNodeFlags_Max>& flags)
+{
+    if (descriptors == nullptr || count == 0) {
+        return 0;
+    }
+
+    auto lock = lockForEdit();
+    auto cmd = std::make_unique<ImTimelineInternal::AddCommand>(this);
+    cmd->mNodeIDs.reserve(count);
+
+    std::vector<TimelineNode> newNodes(count);
+    for (size_t i = 0; i < count; ++i) {
+        const NodeInitDescriptor& descriptor = descriptors[i];
+        TimelineNode& node = newNodes[i];
+
+        node.Setup(descriptor.section, descriptor.start, descriptor.end, descriptor.label);
+        node.ID = descriptor.ID != InvalidNodeID ? descriptor.ID : mIDGenerator.GetUniqueID();
+        node.mFlags = flags;
+        if (descriptor.bMoveOverlappingNext) {
+            node.mFlags.set(eTimelineNodeFlags::TimelineNodeFlags_MoveSurroundingNodesToTheRight, true);
+        }
+
+        if (descriptor.customNode) {
+            bool bCustomUI = true;
+            node.InitalizeCustomNode(descriptor.customNode, bCustomUI);
+        }
+
+        cmd->mNodeIDs.push_back(node.ID);
+    }
+
+    // added here rather than through command_do, the command only needs the IDs while the nodes are in the timeline
+    size_t addedCount = insertNodesBulk(newNodes);
+
+    PushCommand(std::move(cmd));
+
+    return addedCount;
+}
+
+// the nodes are moved from
+size_t Timeline::insertNodesBulk(std::vector<TimelineNode>& nodes)
+{
+    auto lock = lockForEdit();
+
+    // sections in order of first appearance, so new sections are initialized in the order the caller listed them
+    std::vector<s32> sectionOrder;
+    std::unordered_map<s32, std::vector<TimelineNode>> buckets;
+
+    for (TimelineNode& node : nodes) {
+        auto& bucket = buckets[node.section];
+        if (bucket.empty()) {
+            sectionOrder.push_back(node.section);
+        }
+        bucket.push_back(std::move(node));
+    }
+
+    size_t addedCount = 0;
+
+    for (s32 sectionIndex : sectionOrder) {
+        std::vector<TimelineNode>& bucket = buckets[sectionIndex];
+
+        InitializeTimelineSection(sectionIndex, "Unnamed");
+        sTimelineSection& section = mTimelines[sectionIndex];
+        if (section.mbIsInitialized == false || section.mNodeData == nullptr) {
+            LOG_WARNING_PRINTF("AddNodesBulk section %d could not be initialized", sectionIndex);
+            continue;
+        }
+
+        // stable, nodes starting together keep the order they were listed in, the same as adding them one by one
+        std::stable_sort(bucket.begin(), bucket.end(), [](const TimelineNode& a, const TimelineNode& b) { return a.start < b.start; });
+
+        flushDeferredRebuild(sectionIndex);
+
+        // moving overlapping nodes is up to each node, as if they were added one by one in start order.
+        // Consecutive nodes that agree on it are inserted together
+        bool bAnyMoved = false;
+        std::vector<TimelineNode> run;
+        for (size_t runBegin = 0; runBegin < bucket.size();) {
+            bool bMoveOverlapping = bucket[runBegin].mFlags.test(eTimelineNodeFlags::TimelineNodeFlags_MoveSurroundingNodesToTheRight);
+            size_t runEnd = runBegin + 1;
+            while (runEnd < bucket.size() && bucket[runEnd].mFlags.test(eTimelineNodeFlags::TimelineNodeFlags_MoveSurroundingNodesToTheRight) == bMoveOverlapping) {
+                runEnd++;
+            }
+
+            NodeInitDescriptor descriptor;
+            descriptor.section = sectionIndex;
+            descriptor.bMoveOverlappingNext = bMoveOverlapping;
+            bAnyMoved |= bMoveOverlapping;
+
+            if (runBegin == 0 && runEnd == bucket.size()) {
+                addedCount += section.mNodeData->emplace_bulk(bucket, descriptor);
+            } else {
+                run.assign(bucket.begin() + runBegin, bucket.begin() + runEnd);
+                addedCount += section.mNodeData->emplace_bulk(run, descriptor);
+            }
+
+            runBegin = runEnd;
+        }
+
+        // moving overlapping nodes shifts nodes after the inserts, their new ends come from the data
+        s32 endTimestamp = section.mProps.mEndTimestamp;
+        for (const TimelineNode& node : bucket) {
+            mNodeSectionIndex[node.ID] = sectionIndex;
+
+            const TimelineNode* addedNode = &node;
+            if (bAnyMoved) {
+                addedNode = FindNodeByNodeID(sectionIndex, node.ID);
+            }
+            if (addedNode != nullptr) {
+                endTimestamp = std::max(endTimestamp, addedNode->end);
+            }
+        }
+
+        section.mProps.mEndTimestamp = endTimestamp;
+        if (endTimestamp > mFrameMax) {
+            mFrameMax = endTimestamp + 50;
+        }
+
+        reschedulePlayer(sectionIndex);
+    }
+
+    return addedCount;
+}
+
+size_t Timeline::deleteNodesBulk(const std::vector<NodeID>& ids)
+{
+    auto lock = lockForEdit();
+
+    std::unordered_map<s32, std::vector<NodeID>> buckets;
+    for (NodeID id : ids) {
+        s32 sectionIndex = 0;
+        if (findNodeSection(id, sectionIndex)) {
+            buckets[sectionIndex].push_back(id);
+        }
+    }
+
+    if (mSelectedNode != nullptr && std::find(ids.begin(), ids.end(), mSelectedNode->ID) != ids.end()) {
+        mSelectedNode = nullptr;
+    }
+
+    size_t deleteCount = 0;
+
+    for (auto& bucket : buckets) {
+        if (HasSection(bucket.first) == false) {
+            continue;
+        }
+
+        // the nodes are found in the order by their start
+        flushDeferredRebuild(bucket.first);
+        deleteCount += mTimelines[bucket.first].mNodeData->delete_nodes(bucket.second);
+        for (NodeID id : bucket.second) {
+            mNodeSectionIndex.erase(id);
+        }
+
+        reschedulePlayer(bucket.first);
+    }
+
+    return deleteCount;
+}
+
 /* NODE MOVE & COMMAND LOGIC */
 
 void Timeline::MoveNode(TimelineNode* node, s32 newStart, s32 newSection)
+{
+    if (node == nullptr) {
+        return;
+    }
+
+    MoveNode(node->ID, newStart, newSection);
+}
+
+void Timeline::MoveNode(NodeID nodeID, s32 newStart, s32 newSection)
 {
     LOG_INFO("MoveCommand:");
-    auto cmd = std::make_unique<ImTimelineInternal::MoveNodeCommand>(this);
+    auto lock = lockForEdit();
+
+    TimelineNode* node = FindNodeByNodeID(nodeID);
+    if (node == nullptr) {
+        LOG_WARNING_PRINTF("MoveNode node %d does not exist", nodeID);
+        return;
+    }
 
-    cmd->mNodeToMove = mSelectedNode;
+    auto cmd = std::make_unique<ImTimelineInternal::MoveNodeCommand>(this);
+    cmd->mNodeID = nodeID;
+    cmd->mOldStart = node->start;
+    cmd->mOldSectionID = node->section;
     cmd->mNewStart = newStart;
     cmd->mNewSectionID = newSection;
     cmd->command_do();
@@ -143,21 +340,74 @@ void Timeline::MoveNode(TimelineNode* node, s32 newStart, s32 newSection)
     PushCommand(std::move(cmd));
 }
 
+bool Timeline::moveNodeByID(NodeID nodeID, s32 newStart, s32 newSection)
+{
+    auto lock = lockForEdit();
+
+    TimelineNode* node = FindNodeByNodeID(nodeID);
+    if (node == nullptr) {
+        LOG_WARNING_PRINTF("Node %d to move not found", nodeID);
+        return false;
+    }
+
+    s32 duration = node->end - node->start;
+    bool bIsSelected = mSelectedNode == node;
+
+    if (node->section == newSection) {
+        node->start = newStart;
+        node->end = newStart + duration;
+        LOG_INFO_PRINTF("Move node on same timeline. ID: %d", nodeID);
+    } else {
+        // across sections the node is re-added under the same ID, it keeps its flags and data
+        std::vector<TimelineNode> movedNodes(1, *node);
+        movedNodes[0].section = newSection;
+        movedNodes[0].start = newStart;
+        movedNodes[0].end = newStart + duration;
+
+        deleteNodesBulk({ nodeID });
+        insertNodesBulk(movedNodes);
+    }
+
+    forceRebuild(newSection);
+
+    // the rebuild can move nodes around in the storage
+    if (bIsSelected) {
+        mSelectedNode = FindNodeByNodeID(newSection, nodeID);
+    }
+
+    return true;
+}
+
 TimelineNode* Timeline::FindNodeByNodeID(NodeID nodeID) const
 {
     if (nodeID == InvalidNodeID) {
         return nullptr;
     }
-    NodeInitDescriptor searchDescriptor;
-    searchDescriptor.ID = nodeID;
+    s32 section = 0;
+    if (findNodeSection(nodeID, section) == false || HasSection(section) == false) {
+        return nullptr;
+    }
 
-    for (auto& timeline : mTimelines) {
-        TimelineNode* node = timeline.second.mNodeData->get_node_id(searchDescriptor);
-        if (node != nullptr) {
-            return node;
+    return FindNodeByNodeID(section, nodeID);
+}
+
+bool Timeline::findNodeSection(NodeID nodeID, s32& outSection) const
+{
+    auto it = mNodeSectionIndex.find(nodeID);
+    if (it != mNodeSectionIndex.end()) {
+        outSection = it->second;
+        return true;
+    }
+
+    // nodes that haven't moved since the load are only in their section's ID index, a binary search each
+    for (s32 section : mLoadedSections) {
+        if (HasSection(section) && FindNodeByNodeID(section, nodeID) != nullptr) {
+            outSection = section;
+            return true;
         }
     }
-    return nullptr;
+
+    return false;
 }
 
 TimelineNode* Timeline::FindNodeByNodeID(s32 section, NodeID nodeID) const
@@ -183,23 +433,83 @@ bool Timeline::HasSection(s32 section) const
 
 void Timeline::Undo()
 {
+    auto lock = lockForEdit();
+    if (IsInTransaction()) {
+        LOG_WARNING_PRINTF("Undo of step %d ignored while a transaction is open (depth %d)", mCommandIndex, mTransactionDepth);
+        return;
+    }
+
     if (mCommandIndex >= 0) {
-        mCommandHistory[mCommandIndex]->command_undo();
+        // edits the command makes to undo itself, such as the delete undoing an add, aren't recorded as new steps
+        bool bWasEnabled = mEnableCommands;
+        SetCommandEnable(false);
+        mCommandHistory[mCommandIndex].mCommand->command_undo();
+        SetCommandEnable(bWasEnabled);
+
+        updateCommandFootprint(mCommandIndex);
         --mCommandIndex;
+        enforceUndoBudget();
     }
 }
 
 void Timeline::Redo()
 {
+    auto lock = lockForEdit();
+    if (IsInTransaction()) {
+        LOG_WARNING_PRINTF("Redo of step %d ignored while a transaction is open (depth %d)", mCommandIndex + 1, mTransactionDepth);
+        return;
+    }
+
     if (mCommandIndex + 1 < static_cast<int>(mCommandHistory.size())) {
         ++mCommandIndex;
-        mCommandHistory[mCommandIndex]->command_do();
+        bool bWasEnabled = mEnableCommands;
+        SetCommandEnable(false);
+        mCommandHistory[mCommandIndex].mCommand->command_do();
+        SetCommandEnable(bWasEnabled);
+
+        updateCommandFootprint(mCommandIndex);
+        enforceUndoBudget();
+    }
+}
+
+void Timeline::BeginTransaction()
+{
+    if (mTransactionDepth == 0) {
+        mTransactionLock = lockForEdit();
+        beginDeferredEdits();
+    }
+    mTransactionDepth++;
+}
+
+void Timeline::CommitTransaction()
+{
+    IM_ASSERT(mTransactionDepth > 0);
+    if (mTransactionDepth <= 0) {
+        return;
+    }
+
+    if (--mTransactionDepth > 0) {
+        return;
+    }
+
+    endDeferredEdits();
+
+    if (mTransactionCommands.empty() == false) {
+        auto cmd = std::make_unique<ImTimelineInternal::CompoundCommand>(this);
+        cmd->mCommands = std::move(mTransactionCommands);
+        mTransactionCommands.clear();
+
+        LOG_INFO_PRINTF("Committed transaction of %d command(s)", static_cast<s32>(cmd->mCommands.size()));
+        PushCommand(std::move(cmd));
     }
+
+    mTransactionLock = std::unique_lock<std::recursive_mutex>();
 }
 
 void Timeline::DeleteItem(s32 section, s32 start, s32 end)
 {
     LOG_INFO("DeleteItem Command:");
+    auto lock = lockForEdit();
     auto cmd = std::make_unique<ImTimelineInternal::DeleteCommand>(this);
 
     cmd->section = section;
@@ -224,17 +534,72 @@ void Timeline::DeleteSelection()
 
 void Timeline::DeleteSection(s32 section)
 {
+    auto lock = lockForEdit();
     if (HasSection(section) == false) {
         return;
     }
 
     DeleteItem(section, 0, mTimelines[section].mProps.mEndTimestamp);
+
+    // the section players of every cursor go before the data they play
+    for (auto& cursor : mCursors) {
+        auto itPlayer = cursor.mSectionPlayers.find(section);
+        if (itPlayer == cursor.mSectionPlayers.end())
+            continue;
+
+        cursor.mPlayer->RemovePlayer(itPlayer->second.get());
+        cursor.mSectionPlayers.erase(itPlayer);
+    }
     mTimelines.erase(section);
+
+    for (auto it = mNodeSectionIndex.begin(); it != mNodeSectionIndex.end();) {
+        if (it->second == section) {
+            it = mNodeSectionIndex.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    mLoadedSections.erase(std::remove(mLoadedSections.begin(), mLoadedSections.end(), section), mLoadedSections.end());
+}
+
+void Timeline::clearSections()
+{
+    auto lock = lockForEdit();
+
+    for (auto& cursor : mCursors) {
+        cursor.mPlayer->Stop();
+        for (auto& sectionPlayer : cursor.mSectionPlayers) {
+            cursor.mPlayer->RemovePlayer(sectionPlayer.second.get());
+        }
+        cursor.mSectionPlayers.clear();
+    }
+
+    mTimelines.clear();
+    mNodeSectionIndex.clear();
+    mLoadedSections.clear();
+    mSelectedNode = nullptr;
+    mDragData = DragData();
+    mSelectedTimelineIndex = -1;
+
+    // the commands refer to nodes by ID, which mean nothing in the new sections
+    mCommandHistory.clear();
+    mCommandIndex = -1;
+    mCommandHistoryBytes = 0;
 }
 
+bool Timeline::SaveToFile(const std::string& path)
+{
+    return TimelineSerializer::Save(*this, path);
+}
+
+bool Timeline::LoadFromFile(const std::string& path)
+{
+    return TimelineSerializer::Load(*this, path);
+}
 
 bool Timeline::InitializeTimelineSection(s32 index, std::string name, ImDataController* data /* nullptr */)
 {
+    auto lock = lockForEdit();
     ImU32 bgColor = ImTimelineUtility::Color::LightGray;
 
     auto itr = mTimelines.find(index);
@@ -285,6 +650,7 @@ bool Timeline::InitializeTimelineSection(s32 index, std::string name, ImDataCont
         if (mMainPlayer)
             mMainPlayer->AddPlayer(section.mTimelinePlayer);
     }
+    attachSectionToCursors(section);
 
     if (section.mbIsInitialized == false) {
         section.mbIsInitialized = true;
@@ -296,6 +662,7 @@ bool Timeline::InitializeTimelineSection(s32 index, std::string name, ImDataCont
 
 bool Timeline::InitializeTimelineSectionEx(s32 index, std::string name, ImDataController* data, std::shared_ptr<ITimelinePlayerView> playerViewVUI, std::shared_ptr<INodeView> nodeViewUI)
 {
+    auto lock = lockForEdit();
     ImU32 bgColor = ImTimelineUtility::Color::LightGray;
 
     auto itr = mTimelines.find(index);
@@ -356,6 +723,7 @@ bool Timeline::InitializeTimelineSectionEx(s32 index, std::string name, ImDataCo
         if (mMainPlayer)
             mMainPlayer->AddPlayer(section.mTimelinePlayer);
     }
+    attachSectionToCursors(section);
 
     if (section.mbIsInitialized == false) {
         section.mbIsInitialized = true;
@@ -387,6 +755,7 @@ const sTimelineSection& Timeline::GetTimelineSection(s32 index) const
 
 void Timeline::SetTimelineName(s32 index, std::string name)
 {
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
     mTimelines[index].mProps.mSectionName = name;
 }
 
@@ -404,7 +773,15 @@ void Timeline::SetTimelinePlayerUI(std::shared_ptr<ITimelinePlayerView> uiView)
 {
     // old data might be deleted
     // std::shared_ptr<ITimelinePlayerView> baseView = std::dynamic_pointer_cast<ITimelinePlayerView>(debugView);
+
+    // the playback thread only redirects the views it saw when it started
+    bool bThreaded = IsThreadedPlayback();
+    sPlaybackThreadSettings threadSettings = mPlaybackThread.GetSettings();
+    SetThreadedPlayback(false);
+
     mMainPlayer->SetViewUI(uiView);
+
+    SetThreadedPlayback(bThreaded, threadSettings);
 }
 
 void Timeline::SetNodeViewUI(std::shared_ptr<INodeView> uiView)
@@ -595,11 +972,15 @@ void Timeline::DrawHeader(const ImRect& headerRect)
     ImRect timestampAreaClippingRect = ImRect(headerRect.Min + ImVec2(mStyle.LegendWidth, 0), headerRect.Min + headerSize);
     draw_list->PushClipRect(timestampAreaClippingRect.Min, timestampAreaClippingRect.Max, true);
 
+    // scrubbing: the nodes under the playhead are activated while the mouse drags over the header
     if (timestampAreaClippingRect.Contains(mInputData.MousePos) && mInputData.LeftMouseDown && !IsDragging()) {
         s32 mouseTimestamp = GetTimestampAtPixelPosition(mInputData.MousePos.x);
 
-        if (mMainPlayer)
-            mMainPlayer->SetStartTimestamp(mouseTimestamp);
+        std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+        TimelinePlayer* player = getActiveCursorPlayer();
+        if (player && mouseTimestamp != player->GetCurrentTimestamp()) {
+            player->Seek(mouseTimestamp);
+        }
     }
 
     int useFrameStep = 1;
@@ -729,10 +1110,12 @@ void Timeline::OnCoreDebugGUI()
     // ImGuiTreeNodeFlags_DefaultOpen
     if (ImGui::TreeNodeEx("Navigation")) {
 
-        if (mMainPlayer) {
-            s32 current_timestamp = mMainPlayer->GetCurrentTimestamp();
+        std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+        TimelinePlayer* player = getActiveCursorPlayer();
+        if (player) {
+            s32 current_timestamp = player->GetCurrentTimestamp();
             if (ImGui::DragInt("Current Frame", &current_timestamp, 1.f, 0, mFrameMax)) {
-                mMainPlayer->SetStartTimestamp(current_timestamp);
+                player->Seek(current_timestamp);
             }
         }
 
@@ -835,6 +1218,28 @@ void Timeline::OnCoreDebugGUI()
         ImGui::TreePop();
     }
 
+    if (ImGui::TreeNodeEx("File")) {
+        static char file_path_str[256] = "timeline.imtl";
+        ImGui::InputText("Path:", file_path_str, IM_ARRAYSIZE(file_path_str));
+
+        if (ImGui::Button("Save")) {
+            SaveToFile(file_path_str);
+        }
+
+        ImGui::SameLine();
+
+        if (ImGui::Button("Load")) {
+            LoadFromFile(file_path_str);
+        }
+
+        ImGui::SameLine();
+
+        if (ImGui::Button("Import Chrome Trace")) {
+            TimelineTraceImporter::Import(*this, file_path_str);
+        }
+        ImGui::TreePop();
+    }
+
     if (ImGui::TreeNodeEx("Performance")) {
         OnDebugGUIPerformance();
         ImGui::TreePop();
@@ -927,12 +1332,39 @@ void Timeline::OnDebugGUIPerformance()
     ImGui::Text("Performance Timers:");
     ScopedTimer::DebugPrint();
 
+    ImGui::Text("Player Performance:");
+    if (mMainPlayer) {
+        mMainPlayer->OnDebugGUIPerformance();
+    }
+    {
+        std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+        for (const auto& cursor : mCursors) {
+            ImGui::Text("Cursor [%s]: %.0f events/s", cursor.mName.c_str(), cursor.mEventsPerSecond);
+        }
+    }
+    mPlaybackThread.OnDebugGUIPerformance();
+
+    ImGui::Text("Undo History:");
+    ImGui::Text("Steps: %d / %d, undo memory %.2f KB / %.2f KB, evicted steps %d", GetUndoStepCount(), mUndoSettings.mMaxSteps,
+        static_cast<double>(mCommandHistoryBytes) / 1024, static_cast<double>(mUndoSettings.mMaxBytes) / 1024, mEvictedCommandCount);
+    {
+        sUndoSettings undoSettings = mUndoSettings;
+        s32 maxKilobytes = static_cast<s32>(undoSettings.mMaxBytes / 1024);
+        bool bChanged = ImGui::InputInt("Max undo steps", &undoSettings.mMaxSteps);
+        bChanged |= ImGui::InputInt("Max undo memory (KB)", &maxKilobytes);
+        if (bChanged) {
+            undoSettings.mMaxBytes = static_cast<size_t>(std::max(maxKilobytes, 0)) * 1024;
+            SetUndoSettings(undoSettings);
+        }
+    }
+
     ImGui::Text("NodeView Performance:");
 
     for (auto& timeline : mTimelines) {
         ImGui::Text("[%s]", timeline.second.mProps.mSectionName.c_str());
-        // if(timeline.second.mNodeView)
-        // timeline.second.mNodeView->PerformanceDebugUI();
+        if (timeline.second.mNodeView) {
+            timeline.second.mNodeView->PerformanceDebugUI();
+        }
     }
 
     static s32 toAdd_number = 100;
@@ -947,13 +1379,17 @@ void Timeline::OnDebugGUIPerformance()
     ImGui::InputInt("Add start position:", &add_start);
 
     if (ImGui::Button("Add bulk:")) {
+        std::vector<NodeInitDescriptor> descriptors;
+        descriptors.reserve(std::max(toAdd_number, 0));
+
         for (s32 i = 0; i < toAdd_number; ++i) {
             s32 width = Random::RandomIntRange(1, 4);
-            AddNewNode(toAdd_SectionIndex, add_start, add_start + width, "New Item");
+            descriptors.emplace_back("New Item", toAdd_SectionIndex, add_start, add_start + width, nullptr);
 
             add_start += width + Random::RandomIntRange(1, 3);
-            ++count;
         }
+
+        count += static_cast<s32>(AddNodesBulk(descriptors));
     }
 }
 
@@ -962,8 +1398,77 @@ void Timeline::OnDebugGUIPlayer()
     if (mMainPlayer.get() == nullptr) {
         return;
     }
+
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+
+    bool bThreaded = IsThreadedPlayback();
+    if (ImGui::Checkbox("Play on a dedicated thread", &bThreaded)) {
+        SetThreadedPlayback(bThreaded);
+    }
+
     mMainPlayer->OnDebugGUI();
 
+    if (ImGui::TreeNodeEx("Playback Cursors")) {
+        s32 removeIndex = -1;
+
+        for (s32 i = 0; i < static_cast<s32>(mCursors.size()); ++i) {
+            sPlaybackCursor& cursor = mCursors[i];
+            TimelinePlayer* player = cursor.mPlayer.get();
+            ImGui::PushID(i);
+
+            ImGui::RadioButton("##active", &mActiveCursorIndex, i);
+            ImGui::SameLine();
+            ImGui::Text("%s: frame %d, %.0f events/s, %d loops", cursor.mName.c_str(), player->GetCurrentTimestamp(), cursor.mEventsPerSecond, player->GetLoopCount());
+
+            // the main player has its own controls above
+            if (i > 0) {
+                if (player->IsPlaying()) {
+                    if (ImGui::Button("Pause")) {
+                        player->Pause();
+                    }
+                } else if (ImGui::Button("Play")) {
+                    player->Play();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Stop")) {
+                    player->Stop();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Remove")) {
+                    removeIndex = i;
+                }
+
+                sTimeStepSettings settings = player->GetTimeStepSettings();
+                if (ImGui::DragFloat("Speed", &settings.mPlaybackSpeed, 0.01f, 0.0f, 100.0f)) {
+                    player->SetTimeStepSettings(settings);
+                }
+
+                sLoopRange loopRange = player->GetLoopRange();
+                s32 loop[2] = { loopRange.mStart, loopRange.mEnd };
+                if (ImGui::DragInt2("Loop start/end", loop, 1.0f, 0, mFrameMax)) {
+                    loopRange.mStart = loop[0];
+                    loopRange.mEnd = loop[1];
+                    player->SetLoopRange(loopRange);
+                }
+            }
+
+            ImGui::PopID();
+        }
+
+        static char cursorName[64] = "B";
+        ImGui::InputText("Name", cursorName, IM_ARRAYSIZE(cursorName));
+        ImGui::SameLine();
+        if (ImGui::Button("Add cursor")) {
+            static const ImU32 colors[] = { ImTimelineUtility::Color::LightBlue, ImTimelineUtility::Color::LightGreen, ImTimelineUtility::Color::LightRed };
+            AddPlaybackCursor(cursorName, colors[mCursors.size() % IM_ARRAYSIZE(colors)]);
+        }
+
+        if (removeIndex > 0) {
+            RemovePlaybackCursor(std::string(mCursors[removeIndex].mName));
+        }
+        ImGui::TreePop();
+    }
+
     if (ImGui::TreeNodeEx("Custom TimelinePlayer View UI")) {
         if (mMainPlayer->GetViewUI()) {
             mMainPlayer->GetViewUI()->Draw();
@@ -986,6 +1491,8 @@ bool Timeline::OnDebugGUISelection()
     if (mSelectedNode == nullptr)
         return false;
 
+    auto lock = lockForEdit();
+
     ImGui::Text("ID: %d", mSelectedNode->ID);
     ImGui::Text("Section: %d", mSelectedNode->section);
     ImGui::Text("Text: %s", mSelectedNode->displayText.c_str());
@@ -1034,44 +1541,68 @@ void Timeline::OnDebugGUIRightSidePane()
     ImGui::EndTabBar();
 }
 
-f32 Timeline::getSeekbarPositionX()
+f32 Timeline::getSeekbarPositionX(const sPlaybackCursor& cursor)
 {
-    if (mMainPlayer.get() == nullptr) {
+    if (cursor.mPlayer.get() == nullptr) {
         return 0.0f;
     }
-    f32 timestamp_current = mMainPlayer->GetCurrentTimestamp();
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+    f32 timestamp_current = cursor.mPlayer->GetCurrentTimestamp();
     f32 base = mContentAreaRect.Min.x;
     f32 x = base + mStyle.LegendWidth + (timestamp_current - mStartFrame) * mZoom + mZoom / 2;
     return x;
 }
 void Timeline::drawSeekbarUI()
 {
-    if (mMainPlayer.get() == nullptr) {
-        return;
-    }
-    f32 current_timestamp = mMainPlayer->GetCurrentTimestamp();
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
 
     ImDrawList* draw_list = ImGui::GetWindowDrawList();
     ImVec2 canvas_pos = ImGui::GetCursorScreenPos();
     ImVec2 canvas_size = ImGui::GetContentRegionAvail();
 
-    f32 x = getSeekbarPositionX();
-    f32 y = mContentAreaRect.Min.y;
+    for (size_t i = 0; i < mCursors.size(); ++i) {
+        const sPlaybackCursor& cursor = mCursors[i];
+        if (cursor.mPlayer.get() == nullptr) {
+            continue;
+        }
+
+        // the main player keeps the style's color and a bare frame label
+        ImU32 color = i == 0 ? mStyle.SeekbarColor : cursor.mColor;
+        f32 current_timestamp = cursor.mPlayer->GetCurrentTimestamp();
+
+        f32 x = getSeekbarPositionX(cursor);
+        f32 y = mContentAreaRect.Min.y;
+
+        f32 x2 = x + mStyle.SeekbarWidth;
+        f32 y2 = mContentAreaRect.Max.y;
+        y2 = canvas_pos.y + canvas_size.y;
+
+        // the loop range is a thin band along the top of the content area
+        const sLoopRange& loop = cursor.mPlayer->GetLoopRange();
+        if (loop.IsActive()) {
+            f32 base = mContentAreaRect.Min.x + mStyle.LegendWidth;
+            f32 loopX1 = ImMax(base + (loop.mStart - mStartFrame) * mZoom, base);
+            f32 loopX2 = base + (loop.mEnd - mStartFrame) * mZoom;
+            if (loopX2 > loopX1) {
+                draw_list->AddRectFilled(ImVec2(loopX1, y), ImVec2(loopX2, y + 4.0f), (color & ~IM_COL32_A_MASK) | IM_COL32(0, 0, 0, 128), 0);
+            }
+        }
 
-    f32 x2 = x + mStyle.SeekbarWidth;
-    f32 y2 = mContentAreaRect.Max.y;
-    y2 = canvas_pos.y + canvas_size.y;
+        // don't draw the seekbar when it goes out of view (when the start position shifts)
+        if (current_timestamp < mStartFrame || current_timestamp > mFrameMax) {
+            continue;
+        }
 
-    // don't draw the seekbar when it goes out of view (when the start position shifts)
-    if (current_timestamp >= mStartFrame && current_timestamp <= mFrameMax) {
-        draw_list->AddRectFilled(ImVec2(x, y), ImVec2(x2, y2), mStyle.SeekbarColor, 0);
-    }
+        draw_list->AddRectFilled(ImVec2(x, y), ImVec2(x2, y2), color, 0);
 
-    // timestamp text
-    if (current_timestamp >= mStartFrame && current_timestamp <= mFrameMax) {
+        // timestamp text
         std::string seekbarLabel;
-        ImTimelineUtility::sprint_f(seekbarLabel, "%d", static_cast<s32>(current_timestamp));
-        draw_list->AddText(ImVec2(x + 10, y + 2), mStyle.SeekbarColor, seekbarLabel.c_str());
+        if (i == 0) {
+            ImTimelineUtility::sprint_f(seekbarLabel, "%d", static_cast<s32>(current_timestamp));
+        } else {
+            ImTimelineUtility::sprint_f(seekbarLabel, "%s %d", cursor.mName.c_str(), static_cast<s32>(current_timestamp));
+        }
+        draw_list->AddText(ImVec2(x + 10, y + 2 + i * ImGui::GetTextLineHeight()), color, seekbarLabel.c_str());
     }
 }
 s32 Timeline::GetTimestampAtPixelPosition(f32 pixelPos)
@@ -1088,23 +1619,64 @@ s32 Timeline::GetPixelPositionAtTimestamp(s32 timestamp)
 
 void Timeline::updateTimelinePlayer(f32 deltaTime)
 {
-    for (auto& timeline : mTimelines) {
-        auto player = timeline.second.mTimelinePlayer;
-        if (player == nullptr)
-            continue;
-        player->Update(deltaTime);
+    // the playback thread does the updating, the UI frame only hands over the events it queued
+    if (mPlaybackThread.IsRunning()) {
+        mPlaybackThread.DrainEvents();
+        return;
+    }
+
+    tickTimelinePlayers(deltaTime);
+}
+
+void Timeline::tickTimelinePlayers(f32 deltaTime)
+{
+    // every cursor wakes its sections through its scheduler, only sections played on their own are ticked here
+    bool bMainPlaying = mMainPlayer && mMainPlayer->IsPlaying();
+
+    for (auto& cursor : mCursors) {
+        if (cursor.mPlayer && cursor.mPlayer->IsPlaying()) {
+            cursor.mPlayer->Update(deltaTime);
+        }
+    }
+
+    if (bMainPlaying == false && mMainPlayer) {
+        mMainPlayer->UpdateSoloPlayers(deltaTime);
     }
 
-    if (mMainPlayer && mMainPlayer->IsPlaying()) {
-        mMainPlayer->Update(deltaTime);
+    for (auto& cursor : mCursors) {
+        updateCursorThroughput(cursor, deltaTime);
     }
 }
 
+// Seeks count as well, a scrubbed cursor reports the events its seeks dispatch
+void Timeline::updateCursorThroughput(sPlaybackCursor& cursor, f32 deltaTime)
+{
+    if (cursor.mPlayer == nullptr)
+        return;
+
+    cursor.mWindowSeconds += ImMax(deltaTime, 0.0f);
+    if (cursor.mWindowSeconds < 1.0f)
+        return;
+
+    size_t eventCount = cursor.mPlayer->GetEventCount();
+    cursor.mEventsPerSecond = static_cast<f32>(eventCount - cursor.mWindowEventCount) / cursor.mWindowSeconds;
+    cursor.mWindowEventCount = eventCount;
+    cursor.mWindowSeconds = 0.0f;
+}
+
 void Timeline::forceRebuild(s32 section, NodeInitDescriptor descriptor)
 {
+    auto lock = lockForEdit();
     if (mFlags.test(TimelineFlags_SkipTimelineRebuild))
         return;
 
+    if (mDeferDepth > 0) {
+        if (std::find(mDeferredRebuilds.begin(), mDeferredRebuilds.end(), section) == mDeferredRebuilds.end()) {
+            mDeferredRebuilds.push_back(section);
+        }
+        return;
+    }
+
     if (mTimelines.find(section) == mTimelines.end())
         return;
 
@@ -1112,6 +1684,219 @@ void Timeline::forceRebuild(s32 section, NodeInitDescriptor descriptor)
         return;
 
     mTimelines[section].mNodeData->rebuild(descriptor);
+    reschedulePlayer(section);
+}
+
+// A playing section is only woken at its next node event, after edits that frame has to be looked up again, by every cursor
+void Timeline::reschedulePlayer(s32 section)
+{
+    if (mDeferDepth > 0) {
+        if (std::find(mDeferredReschedules.begin(), mDeferredReschedules.end(), section) == mDeferredReschedules.end()) {
+            mDeferredReschedules.push_back(section);
+        }
+        return;
+    }
+
+    for (auto& cursor : mCursors) {
+        auto itPlayer = cursor.mSectionPlayers.find(section);
+        if (itPlayer == cursor.mSectionPlayers.end())
+            continue;
+
+        cursor.mPlayer->Reschedule(itPlayer->second.get());
+    }
+}
+
+// Every cursor gets a player over the section's data, the main cursor's is the section's own player
+void Timeline::attachSectionToCursors(sTimelineSection& section)
+{
+    if (section.mTimelinePlayer == nullptr || section.mTimelinePlayer->IsSetup() == false)
+        return;
+
+    for (size_t i = 0; i < mCursors.size(); ++i) {
+        sPlaybackCursor& cursor = mCursors[i];
+        if (cursor.mSectionPlayers.count(section.mID) > 0)
+            continue;
+
+        if (i == 0) {
+            cursor.mSectionPlayers[section.mID] = section.mTimelinePlayer;
+            continue;
+        }
+
+        // the root's view is the one the playback thread redirected, when it runs
+        std::shared_ptr<TimelinePlayer> player = std::make_shared<TimelinePlayer>();
+        player->Setup(section.mNodeData, 0);
+        player->SetViewUI(cursor.mView ? cursor.mPlayer->GetViewUI() : section.mTimelinePlayer->GetViewUI());
+        player->SetPlayMode(section.mTimelinePlayer->GetPlayMode());
+        player->SetTimeStepSettings(cursor.mPlayer->GetTimeStepSettings());
+
+        cursor.mPlayer->AddPlayer(player);
+        cursor.mSectionPlayers[section.mID] = player;
+    }
+}
+
+bool Timeline::AddPlaybackCursor(const std::string& name, ImU32 color, std::shared_ptr<ITimelinePlayerView> playerView)
+{
+    // the playback thread only redirects the views it saw when it started
+    bool bThreaded = IsThreadedPlayback();
+    sPlaybackThreadSettings threadSettings = mPlaybackThread.GetSettings();
+    SetThreadedPlayback(false);
+
+    bool bAdded = false;
+    if (findPlaybackCursor(name) != nullptr) {
+        LOG_WARNING_PRINTF("AddPlaybackCursor: cursor %s exists already", name.c_str());
+    } else {
+        auto lock = lockForEdit();
+
+        sPlaybackCursor cursor;
+        cursor.mName = name;
+        cursor.mColor = color;
+        cursor.mView = playerView;
+        cursor.mPlayer = std::make_shared<TimelinePlayer>();
+        cursor.mPlayer->Setup(nullptr, 0);
+        cursor.mPlayer->SetViewUI(playerView ? playerView : mMainPlayer->GetViewUI());
+        cursor.mPlayer->SetTimeStepSettings(mMainPlayer->GetTimeStepSettings());
+        mCursors.push_back(std::move(cursor));
+
+        for (auto& timeline : mTimelines) {
+            attachSectionToCursors(timeline.second);
+        }
+        bAdded = true;
+    }
+
+    SetThreadedPlayback(bThreaded, threadSettings);
+    return bAdded;
+}
+
+void Timeline::RemovePlaybackCursor(const std::string& name)
+{
+    bool bThreaded = IsThreadedPlayback();
+    sPlaybackThreadSettings threadSettings = mPlaybackThread.GetSettings();
+    SetThreadedPlayback(false);
+
+    {
+        auto lock = lockForEdit();
+
+        s32 index = -1;
+        for (s32 i = 1; i < static_cast<s32>(mCursors.size()); ++i) {
+            if (mCursors[i].mName == name) {
+                index = i;
+                break;
+            }
+        }
+
+        if (index < 0) {
+            LOG_WARNING_PRINTF("RemovePlaybackCursor: no removable cursor %s", name.c_str());
+        } else {
+            // the views get the end of the nodes the cursor still plays
+            mCursors[index].mPlayer->Stop();
+            mCursors.erase(mCursors.begin() + index);
+
+            if (mActiveCursorIndex == index) {
+                mActiveCursorIndex = 0;
+            } else if (mActiveCursorIndex > index) {
+                mActiveCursorIndex--;
+            }
+        }
+    }
+
+    SetThreadedPlayback(bThreaded, threadSettings);
+}
+
+TimelinePlayer* Timeline::GetPlaybackCursorPlayer(const std::string& name)
+{
+    sPlaybackCursor* cursor = findPlaybackCursor(name);
+    return cursor != nullptr ? cursor->mPlayer.get() : nullptr;
+}
+
+void Timeline::SetPlaybackCursorLoop(const std::string& name, const sLoopRange& loop)
+{
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+    sPlaybackCursor* cursor = findPlaybackCursor(name);
+    if (cursor == nullptr) {
+        LOG_WARNING_PRINTF("SetPlaybackCursorLoop: no cursor %s", name.c_str());
+        return;
+    }
+
+    cursor->mPlayer->SetLoopRange(loop);
+}
+
+void Timeline::SetPlaybackCursorSpeed(const std::string& name, f32 speed)
+{
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+    sPlaybackCursor* cursor = findPlaybackCursor(name);
+    if (cursor == nullptr) {
+        LOG_WARNING_PRINTF("SetPlaybackCursorSpeed: no cursor %s", name.c_str());
+        return;
+    }
+
+    sTimeStepSettings settings = cursor->mPlayer->GetTimeStepSettings();
+    settings.mPlaybackSpeed = speed;
+    cursor->mPlayer->SetTimeStepSettings(settings);
+}
+
+f32 Timeline::GetPlaybackCursorEventRate(const std::string& name)
+{
+    std::lock_guard<std::recursive_mutex> lock(mPlaybackMutex);
+    sPlaybackCursor* cursor = findPlaybackCursor(name);
+    return cursor != nullptr ? cursor->mEventsPerSecond : 0.0f;
+}
+
+void Timeline::SetActivePlaybackCursor(const std::string& name)
+{
+    for (s32 i = 0; i < static_cast<s32>(mCursors.size()); ++i) {
+        if (mCursors[i].mName == name) {
+            mActiveCursorIndex = i;
+            return;
+        }
+    }
+
+    LOG_WARNING_PRINTF("SetActivePlaybackCursor: no cursor %s", name.c_str());
+}
+
+sPlaybackCursor* Timeline::findPlaybackCursor(const std::string& name)
+{
+    for (auto& cursor : mCursors) {
+        if (cursor.mName == name) {
+            return &cursor;
+        }
+    }
+    return nullptr;
+}
+
+TimelinePlayer* Timeline::getActiveCursorPlayer()
+{
+    if (mActiveCursorIndex < 0 || mActiveCursorIndex >= static_cast<s32>(mCursors.size())) {
+        return mMainPlayer.get();
+    }
+    return mCursors[mActiveCursorIndex].mPlayer.get();
+}
+
+std::unique_lock<std::recursive_mutex> Timeline::lockForEdit()
+{
+    std::unique_lock<std::recursive_mutex> lock(mPlaybackMutex);
+
+    // queued events point at nodes, they're delivered before an edit can move or delete those
+    if (mPlaybackThread.IsRunning()) {
+        mPlaybackThread.DrainAllEvents();
+    }
+    return lock;
+}
+
+void Timeline::SetThreadedPlayback(bool aEnable, const sPlaybackThreadSettings& aSettings)
+{
+    if (aEnable == mPlaybackThread.IsRunning()) {
+        return;
+    }
+
+    if (aEnable) {
+        std::vector<std::shared_ptr<TimelinePlayer>> rootPlayers;
+        for (const auto& cursor : mCursors) {
+            rootPlayers.push_back(cursor.mPlayer);
+        }
+        mPlaybackThread.Start(rootPlayers, &mPlaybackMutex, [this](f32 deltaTime) { tickTimelinePlayers(deltaTime); }, aSettings);
+    } else {
+        mPlaybackThread.Stop();
+    }
 }
 
 void Timeline::CollectInputData(sInputData& a_outInputData, f32 aDeltaTime)
@@ -1164,15 +1949,111 @@ void Timeline::CollectInputData(sInputData& a_outInputData, f32 aDeltaTime)
     }
 }
 
+void Timeline::beginDeferredEdits()
+{
+    mDeferDepth++;
+}
+
+void Timeline::endDeferredEdits()
+{
+    IM_ASSERT(mDeferDepth > 0);
+    if (--mDeferDepth > 0) {
+        return;
+    }
+
+    auto lock = lockForEdit();
+    std::vector<s32> rebuilds;
+    std::vector<s32> reschedules;
+    rebuilds.swap(mDeferredRebuilds);
+    reschedules.swap(mDeferredReschedules);
+
+    // a rebuild reschedules its section too
+    for (s32 section : rebuilds) {
+        forceRebuild(section);
+    }
+    for (s32 section : reschedules) {
+        if (std::find(rebuilds.begin(), rebuilds.end(), section) == rebuilds.end()) {
+            reschedulePlayer(section);
+        }
+    }
+}
+
+// Edits that look nodes up by position need the section sorted, a deferred rebuild of it is run early
+void Timeline::flushDeferredRebuild(s32 section)
+{
+    auto itRebuild = std::find(mDeferredRebuilds.begin(), mDeferredRebuilds.end(), section);
+    if (itRebuild == mDeferredRebuilds.end()) {
+        return;
+    }
+    mDeferredRebuilds.erase(itRebuild);
+
+    if (HasSection(section) && mTimelines[section].mNodeData != nullptr) {
+        mTimelines[section].mNodeData->rebuild(NodeInitDescriptor());
+    }
+    reschedulePlayer(section);
+}
+
 void Timeline::PushCommand(std::unique_ptr<BaseCommand> command)
 {
     if (mEnableCommands == false)
         return;
-    if (mCommandIndex < static_cast<int>(mCommandHistory.size()) - 1) {
-        mCommandHistory.erase(mCommandHistory.begin() + mCommandIndex + 1, mCommandHistory.end());
+    if (IsInTransaction()) {
+        mTransactionCommands.push_back(std::move(command));
+        return;
+    }
+    while (mCommandIndex < static_cast<int>(mCommandHistory.size()) - 1) {
+        mCommandHistoryBytes -= mCommandHistory.back().mBytes;
+        mCommandHistory.pop_back();
     }
-    mCommandHistory.push_back(std::move(command));
+
+    sCommandEntry entry;
+    entry.mBytes = command->GetMemoryFootprint();
+    entry.mCommand = std::move(command);
+
+    mCommandHistoryBytes += entry.mBytes;
+    mCommandHistory.push_back(std::move(entry));
     mCommandIndex++;
+
+    enforceUndoBudget();
+}
+
+void Timeline::SetUndoSettings(const sUndoSettings& settings)
+{
+    auto lock = lockForEdit();
+    mUndoSettings = settings;
+    enforceUndoBudget();
+}
+
+// commands like DeleteCommand hold their nodes only while done
+void Timeline::updateCommandFootprint(size_t index)
+{
+    sCommandEntry& entry = mCommandHistory[index];
+    size_t bytes = entry.mCommand->GetMemoryFootprint();
+
+    mCommandHistoryBytes = mCommandHistoryBytes - entry.mBytes + bytes;
+    entry.mBytes = bytes;
+}
+
+void Timeline::enforceUndoBudget()
+{
+    auto isOverBudget = [this]() {
+        return static_cast<s32>(mCommandHistory.size()) > std::max(mUndoSettings.mMaxSteps, 0) || mCommandHistoryBytes > mUndoSettings.mMaxBytes;
+    };
+
+    // the redo steps furthest away first
+    while (static_cast<s32>(mCommandHistory.size()) > mCommandIndex + 1 && isOverBudget()) {
+        mCommandHistoryBytes -= mCommandHistory.back().mBytes;
+        mCommandHistory.pop_back();
+        mEvictedCommandCount++;
+    }
+
+    // then the oldest undo steps, the newest one stays even when it is over the budget on its own
+    while (mCommandIndex > 0 && isOverBudget()) {
+        mCommandHistoryBytes -= mCommandHistory.front().mBytes;
+        mCommandHistory.pop_front();
+        mCommandIndex--;
+        mEvictedCommandCount++;
+    }
 }
 
 //auto move when dragging a node to the side
@@ -9,6 +9,10 @@
 #pragma once
 #include "TimelineCore/TimelineDefines.h"
 #include "Core/IDGeneratorUtility.h"
+#include "TimelineCore/TimelinePlaybackThread.h"
+#include "TimelineCore/TimelineTimeStep.h"
+#include <deque>
+#include <mutex>
 
 struct ImDrawList;
 struct ImRect;
@@ -18,10 +22,15 @@ class ITimelinePlayerView;
 namespace ImTimelineInternal {
 class MoveNodeCommand;
 class DeleteCommand;
+class NodeSetCommand;
+class CompoundCommand;
 }
 
 namespace ImTimeline
 {
+class TimelineSerializer;
+class TimelineTraceImporter;
+
 class Timeline {
 public:
     Timeline();
@@ -48,14 +57,24 @@ public:
 
     TimelineNode* AddNewNode(TimelineNode* node);
     TimelineNode& AddNewNode(s32 section, s32 start, s32 end, const std::string& text = "", std::shared_ptr<CustomNodeBase> customNodeUI = nullptr);
+    // Adds many nodes as one undo step. The nodes are sorted once per section and merged into its data in a single pass,
+    // the players are rescheduled once per section. Descriptors without an ID get a new one, returns the number of nodes added.
+    size_t AddNodesBulk(const NodeInitDescriptor* descriptors, size_t count);
+    size_t AddNodesBulk(const std::vector<NodeInitDescriptor>& descriptors) { return AddNodesBulk(descriptors.data(), descriptors.size()); }
     void DeleteItem(s32 section, s32 start, s32 end);
     void DeleteSelection();
     void DeleteSection(s32 section);
     void MoveNode(TimelineNode* node, s32 newStart, s32 newSection);
+    void MoveNode(NodeID nodeID, s32 newStart, s32 newSection);
 
     TimelineNode* FindNodeByNodeID(NodeID nodeID) const;
     TimelineNode* FindNodeByNodeID(s32 section, NodeID nodeID) const;
 
+    // Native binary format, see TimelineSerializer. Loading replaces every section with a read-only view of the mapped
+    // file, the first edit of a section copies it into memory. The undo history is cleared, custom nodes aren't saved.
+    bool SaveToFile(const std::string& path);
+    bool LoadFromFile(const std::string& path);
+
     ////
     bool DrawTimeline();
     void DrawDebugGUI();
@@ -84,6 +103,40 @@ public:
     void Undo();
     void Redo();
 
+    // Collects every edit up to the matching CommitTransaction into one undo step. Section rebuilds and player reschedules
+    // are deferred to the commit and run once per touched section. Transactions nest, only the outermost commit records
+    // the step. The playback mutex is held in between, so commit on the thread that began the transaction, and before the
+    // next DrawTimeline: sections can be out of order until the commit.
+    void BeginTransaction();
+    void CommitTransaction();
+    bool IsInTransaction() const { return mTransactionDepth > 0; }
+
+    // Limits the undo history in steps and in the bytes its commands hold, see BaseCommand::GetMemoryFootprint.
+    // Redo steps are dropped first from the newest, then the oldest undo steps. The newest undo step is always kept.
+    void SetUndoSettings(const sUndoSettings& settings);
+    const sUndoSettings& GetUndoSettings() const { return mUndoSettings; }
+    size_t GetUndoMemory() const { return mCommandHistoryBytes; }
+    s32 GetUndoStepCount() const { return static_cast<s32>(mCommandHistory.size()); }
+
+    // Moves the player updates from DrawTimeline to a dedicated timing thread. While it runs, edits through this class are
+    // synchronized with it, code that changes a section's ImDataController directly has to hold GetPlaybackMutex().
+    void SetThreadedPlayback(bool aEnable, const sPlaybackThreadSettings& aSettings = sPlaybackThreadSettings());
+    bool IsThreadedPlayback() const { return mPlaybackThread.IsRunning(); }
+    std::recursive_mutex& GetPlaybackMutex() { return mPlaybackMutex; }
+
+    // Extra playheads for A/B comparisons or looped previews. A cursor plays the same ImDataControllers as the main player
+    // through section players of its own, no node data is copied. The main player is the cursor "Main" and can't be removed.
+    // Without a view, the events of a cursor go to the view of the main player's sections.
+    bool AddPlaybackCursor(const std::string& name, ImU32 color, std::shared_ptr<ITimelinePlayerView> playerView = nullptr);
+    void RemovePlaybackCursor(const std::string& name);
+    TimelinePlayer* GetPlaybackCursorPlayer(const std::string& name);
+    const std::vector<sPlaybackCursor>& GetPlaybackCursors() const { return mCursors; }
+    void SetPlaybackCursorLoop(const std::string& name, const sLoopRange& loop);
+    void SetPlaybackCursorSpeed(const std::string& name, f32 speed);
+    f32 GetPlaybackCursorEventRate(const std::string& name); // node events per second
+    // the cursor moved by scrubbing the header and by the Navigation debug UI
+    void SetActivePlaybackCursor(const std::string& name);
+
     // Debug
     
     void OnCoreDebugGUI();
@@ -112,20 +165,42 @@ public:
 protected:
     void drawSeekbarUI();
     void updateTimelinePlayer(f32 deltaTime);
+    void tickTimelinePlayers(f32 deltaTime);
+    std::unique_lock<std::recursive_mutex> lockForEdit();
     void forceRebuild(s32 section, NodeInitDescriptor descriptor = NodeInitDescriptor());
+    void reschedulePlayer(s32 section);
+    size_t addNodesBulk(const NodeInitDescriptor* descriptors, size_t count, const std::bitset<eTimelineNodeFlags::TimelineNodeFlags_Max>& flags);
+    size_t insertNodesBulk(std::vector<TimelineNode>& nodes);
+    size_t deleteNodesBulk(const std::vector<NodeID>& ids);
+    bool moveNodeByID(NodeID nodeID, s32 newStart, s32 newSection);
+    void beginDeferredEdits();
+    void endDeferredEdits();
+    void flushDeferredRebuild(s32 section);
+    bool findNodeSection(NodeID nodeID, s32& outSection) const;
+    void clearSections();
     virtual void DrawHeader(const ImRect& area);
     virtual void DrawScrollbar();
-    f32 getSeekbarPositionX();
+    f32 getSeekbarPositionX(const sPlaybackCursor& cursor);
+    sPlaybackCursor* findPlaybackCursor(const std::string& name);
+    TimelinePlayer* getActiveCursorPlayer();
+    void attachSectionToCursors(sTimelineSection& section);
+    void updateCursorThroughput(sPlaybackCursor& cursor, f32 deltaTime);
 
     TimelineDataMap mTimelines;
+    std::unordered_map<NodeID, s32> mNodeSectionIndex; // NodeID -> section holding the node
+    std::vector<s32> mLoadedSections; // sections loaded from a file, their nodes are found through the file's ID index instead
     std::bitset<(s32)eNextAction::ActionMax> mNextActionFlags;
 
     std::shared_ptr<TimelinePlayer> mMainPlayer;
+    std::vector<sPlaybackCursor> mCursors; // the main player first
+    s32 mActiveCursorIndex = 0;
     TimelineNode* mSelectedNode = nullptr;
 
 private:
     void CollectInputData(sInputData& a_outInputData, f32 aDeltaTime);
     void PushCommand(std::unique_ptr<BaseCommand> command);
+    void updateCommandFootprint(size_t index);
+    void enforceUndoBudget();
     void SetCommandEnable(bool aEnable) { mEnableCommands = aEnable; }
     void updateSideDragLogic(f32 deltaTime);
 
@@ -144,9 +219,25 @@ private:
     sTimelineSection mEmptyDummySection = sTimelineSection();
 
     // command
-    std::vector<std::unique_ptr<BaseCommand>> mCommandHistory;
+    struct sCommandEntry {
+        std::unique_ptr<BaseCommand> mCommand;
+        size_t mBytes = 0; // footprint after the command was last done or undone
+    };
+
+    std::deque<sCommandEntry> mCommandHistory; // oldest first, evicted from the front
     s32 mCommandIndex = -1;
     bool mEnableCommands = true;
+    sUndoSettings mUndoSettings;
+    size_t mCommandHistoryBytes = 0;
+    s32 mEvictedCommandCount = 0;
+
+    // transaction
+    s32 mTransactionDepth = 0;
+    std::vector<std::unique_ptr<BaseCommand>> mTransactionCommands;
+    std::unique_lock<std::recursive_mutex> mTransactionLock;
+    s32 mDeferDepth = 0; // rebuilds and reschedules are collected while > 0
+    std::vector<s32> mDeferredRebuilds;
+    std::vector<s32> mDeferredReschedules;
 
     // input
     sInputData mInputData;
@@ -154,8 +245,16 @@ private:
     f32 mEdgeMoveAmount = 0.0f;
     f32 mEdgeMoveSpeed = 15.0f;
 
+    // threaded playback, declared last so the thread is joined before anything it uses is destroyed
+    std::recursive_mutex mPlaybackMutex;
+    TimelinePlaybackThread mPlaybackThread;
+
     friend class ::ImTimelineInternal::MoveNodeCommand;
     friend class ::ImTimelineInternal::DeleteCommand;
+    friend class ::ImTimelineInternal::NodeSetCommand;
+    friend class ::ImTimelineInternal::CompoundCommand;
+    friend class TimelineSerializer;
+    friend class TimelineTraceImporter;
 };
 
 } //ImTimeline
\ No newline at end of file
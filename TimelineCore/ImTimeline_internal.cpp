@@ -1,128 +1,217 @@
 #include "ImTimeline_internal.h"
 #include "../Timeline.h"
 #include "../TimelineData/ImDataControllerVector.h"
+#include "../TimelineData/ImDataControllerChunked.h"
 #include "../TimelineViews/DebugPlayerView.h"
 #include "../TimelineViews/HorizontalNodeView.h"
 #include "../dependencies/include/nameof/nameof.hpp"
 
 /*******  COMMAND LOGIC *******/
 
-void ImTimelineInternal::AddCommand::command_do()
+namespace
 {
-    IM_ASSERT(mTimeline != nullptr);
-
-    if(mTimeline->HasSection(this->mNewNode.GetSection()) == false)
+    // the background colours have no default to compare with, a node drawn with its own keeps its properties
+    bool IsDefaultDisplayProperties(const sGenericDisplayProperties& props, bool bOwnBackground)
     {
-        mTimeline->InitializeTimelineSection(this->mNewNode.GetSection(), "Unnamed");
+        if (bOwnBackground) {
+            return false;
+        }
+
+        const sGenericDisplayProperties defaults = sGenericDisplayProperties();
+        return props.mHeight == defaults.mHeight && props.mWidth == defaults.mWidth && props.mForegroundColor == defaults.mForegroundColor
+            && props.AccentThickness == defaults.AccentThickness && props.Spacing == defaults.Spacing && props.BorderRadius == defaults.BorderRadius
+            && props.BorderThickness == defaults.BorderThickness;
     }
-   
-    TimelineNode* newNode = mTimeline->AddNewNode(&mNewNode);
+}
 
-    if(newNode == nullptr)
-    {
-        LOG_WARNING_PRINTF("Failed to add node %d", this->mNewNode.GetID());
-        return;
+void ImTimelineInternal::sNodeRecord::Capture(const TimelineNode& node)
+{
+    mID = node.ID;
+    mSection = node.section;
+    mStart = node.start;
+    mEnd = node.end;
+    mFlags = static_cast<u32>(node.mFlags.to_ulong());
+    mText = node.displayText;
+    mCustomNode = node.CustomNode;
+
+    bool bOwnBackground = node.mFlags.test(eTimelineNodeFlags::TimelineNodeFlags_UseSectionBackground) == false;
+    if (IsDefaultDisplayProperties(node.displayProperties, bOwnBackground) == false) {
+        mDisplayProperties = std::make_unique<sGenericDisplayProperties>(node.displayProperties);
     }
+}
 
-    // update internal data
-    this->mNewNode.start = newNode->start;
-    this->mNewNode.end = newNode->end;
+void ImTimelineInternal::sNodeRecord::MoveTo(TimelineNode& outNode)
+{
+    outNode.Setup(mSection, mStart, mEnd, std::string());
+    outNode.ID = mID;
+    outNode.mFlags = std::bitset<eTimelineNodeFlags::TimelineNodeFlags_Max>(mFlags);
+    outNode.displayText = std::move(mText);
+    outNode.CustomNode = std::move(mCustomNode);
+
+    if (mDisplayProperties != nullptr) {
+        outNode.displayProperties = *mDisplayProperties;
+        mDisplayProperties.reset();
+    }
+}
 
-    IM_ASSERT(this->mNewNode.GetID() == newNode->GetID()); // specified ID should not change internally
+// a custom node nothing but the record holds on to counts in full
+size_t ImTimelineInternal::sNodeRecord::GetMemoryFootprint() const
+{
+    size_t bytes = sizeof(sNodeRecord) + mText.capacity();
+    if (mDisplayProperties != nullptr) {
+        bytes += sizeof(sGenericDisplayProperties);
+    }
+    if (mCustomNode != nullptr && mCustomNode.use_count() == 1) {
+        bytes += mCustomNode->GetMemoryFootprint();
+    }
+    return bytes;
+}
 
-    //add? on delete, the mEndTimestamp should ideally shrink
+void ImTimelineInternal::NodeSetCommand::removeNodes()
+{
+    IM_ASSERT(mTimeline != nullptr);
+
+    mRecords.clear();
+    mRecords.reserve(mNodeIDs.size());
+
+    for (NodeID id : mNodeIDs) {
+        TimelineNode* node = mTimeline->FindNodeByNodeID(id);
+        if (node == nullptr) {
+            LOG_WARNING_PRINTF("Node %d to remove not found", id);
+            continue;
+        }
+
+        mRecords.emplace_back();
+        mRecords.back().Capture(*node);
+    }
+
+    mTimeline->deleteNodesBulk(mNodeIDs);
 }
-void ImTimelineInternal::AddCommand::command_undo()
+
+void ImTimelineInternal::NodeSetCommand::restoreNodes()
 {
     IM_ASSERT(mTimeline != nullptr);
-    mTimeline->DeleteItem(this->mNewNode.GetSection(), this->mNewNode.start, this->mNewNode.end);
+
+    std::vector<TimelineNode> nodes(mRecords.size());
+    for (size_t i = 0; i < mRecords.size(); ++i) {
+        mRecords[i].MoveTo(nodes[i]);
+    }
+
+    size_t addedCount = mTimeline->insertNodesBulk(nodes);
+    if (addedCount != mRecords.size()) {
+        LOG_WARNING_PRINTF("Restored %d of %d nodes", static_cast<s32>(addedCount), static_cast<s32>(mRecords.size()));
+    }
+
+    // released rather than kept around for the undo budget, the IDs are enough to remove the nodes again
+    mRecords.clear();
+    mRecords.shrink_to_fit();
 }
 
-//MoveNode
+size_t ImTimelineInternal::NodeSetCommand::getNodeSetFootprint() const
+{
+    size_t bytes = mNodeIDs.capacity() * sizeof(NodeID) + (mRecords.capacity() - mRecords.size()) * sizeof(sNodeRecord);
+    for (const sNodeRecord& record : mRecords) {
+        bytes += record.GetMemoryFootprint();
+    }
+    return bytes;
+}
 
-void ImTimelineInternal::MoveNodeCommand::command_do()
+void ImTimelineInternal::CompoundCommand::command_do()
 {
-    IM_ASSERT(mNewSectionID != -1);
-    IM_ASSERT(mNodeToMove != nullptr);
-    bool bSectionDifferent = mNewSectionID != mNodeToMove->GetSection();
-    f32 nodeWith = mNodeToMove->end - mNodeToMove->start;
+    IM_ASSERT(mTimeline != nullptr);
 
-    s32 oldStart = mNodeToMove->start;
-    s32 oldCat = mNodeToMove->GetSection();
+    // the recorded commands are replayed, the edits they make must not be recorded again
+    bool bWasEnabled = mTimeline->mEnableCommands;
+    mTimeline->SetCommandEnable(false);
+    mTimeline->beginDeferredEdits();
 
-    if (bSectionDifferent) {
-        AddCommand addCommand(this->mTimeline);
-        addCommand.mNewNode = *mNodeToMove; //copy data -> todo assignment operator override or Clone function
+    for (auto& command : mCommands) {
+        command->command_do();
+    }
 
-        addCommand.mNewNode.section = mNewSectionID;
-        addCommand.mNewNode.start = mNewStart;
-        addCommand.mNewNode.end = mNewStart + static_cast<s32>(round(nodeWith));
-        addCommand.mNewNode.mFlags.set(eTimelineNodeFlags::TimelineNodeFlags_MovedToDifferentTimeline, true);
+    mTimeline->endDeferredEdits();
+    mTimeline->SetCommandEnable(bWasEnabled);
+}
 
-        addCommand.command_do();
+void ImTimelineInternal::CompoundCommand::command_undo()
+{
+    IM_ASSERT(mTimeline != nullptr);
 
-        mTimeline->SetCommandEnable(false);
-        mTimeline->DeleteItem(mNodeToMove->section, oldStart, oldStart + nodeWith); // mNodeToMove gets deleted
-        mTimeline->SetCommandEnable(true);
+    bool bWasEnabled = mTimeline->mEnableCommands;
+    mTimeline->SetCommandEnable(false);
+    mTimeline->beginDeferredEdits();
 
-        NodeInitDescriptor searchDescriptor;
-        searchDescriptor.ID = addCommand.mNewNode.ID;
-        //TimelineNode* node = this->mTimeline->mTimelines[addCommand.mNewNode.section].mNodeData->get_node_id(searchDescriptor); //todo remove
-        TimelineNode* node = this->mTimeline->FindNodeByNodeID(addCommand.mNewNode.section, addCommand.mNewNode.ID);
+    for (auto it = mCommands.rbegin(); it != mCommands.rend(); ++it) {
+        (*it)->command_undo();
+    }
 
-        if (node) {
-            mNodeToMove = node;
-        }
-    } else {
-        mNodeToMove->start = mNewStart;
-        mNodeToMove->end = mNewStart + nodeWith;
+    mTimeline->endDeferredEdits();
+    mTimeline->SetCommandEnable(bWasEnabled);
+}
 
-        LOG_INFO_PRINTF("Move node on same timeline. ID: %d", mNodeToMove->ID);
+size_t ImTimelineInternal::CompoundCommand::GetMemoryFootprint() const
+{
+    size_t bytes = sizeof(CompoundCommand) + mCommands.capacity() * sizeof(std::unique_ptr<BaseCommand>);
+    for (const auto& command : mCommands) {
+        bytes += command->GetMemoryFootprint();
     }
+    return bytes;
+}
 
-    mTimeline->forceRebuild(mNewSectionID);
+//MoveNode
 
-    // For Undo
-    mNewStart = oldStart;
-    mNewSectionID = oldCat;
+void ImTimelineInternal::MoveNodeCommand::command_do()
+{
+    IM_ASSERT(mNewSectionID != -1);
+    mTimeline->moveNodeByID(mNodeID, mNewStart, mNewSectionID);
 }
 
 void ImTimelineInternal::MoveNodeCommand::command_undo()
 {
-    command_do();
+    IM_ASSERT(mOldSectionID != -1);
+    mTimeline->moveNodeByID(mNodeID, mOldStart, mOldSectionID);
 }
 
 void ImTimelineInternal::DeleteCommand::command_do()
 {
+    if (mbHasCollected) {
+        removeNodes();
+        return;
+    }
+
     if (mTimeline->HasSection(section) == false) {
         LOG_WARNING_PRINTF("DeleteItem section %d does not exist", section);
         return;
     }
-    NodeInitDescriptor descriptor;
-    descriptor.start = start;
-    descriptor.end = end;
 
-    mDeletedNodes.clear();
+    // the range lookup needs the section in start order
+    mTimeline->flushDeferredRebuild(section);
 
-    auto nodeList = mTimeline->mTimelines[section].mNodeData->get_node_range(descriptor);
-    mDeletedNodes.reserve(nodeList.size());
-    for (auto node : nodeList) {
-        mDeletedNodes.push_back(*node);
+    // a contained node overlaps the range too, so the range visit only has to filter out nodes sticking out of it
+    mNodeIDs.clear();
+    mTimeline->mTimelines[section].mNodeData->for_each_in_range(start, end, [this](TimelineNode& node) {
+        if (node.start < start || node.end > end) {
+            return;
+        }
+        mNodeIDs.push_back(node.GetID());
+    });
+    mbHasCollected = true;
+
+    if (mNodeIDs.empty()) {
+        LOG_INFO_PRINTF("Trying to delete a node in section %d but no node was deleted...", section);
+        return;
     }
 
-    mTimeline->mTimelines[section].mNodeData->delete_node(descriptor);
+    removeNodes();
 }
+/****************************/
 
-void ImTimelineInternal::DeleteCommand::command_undo()
+// defined here rather than in TimelineDefines.h, deleting the controller needs the complete type to run its destructor
+void sTimelineSection::OnFinalize()
 {
-    for(auto node : mDeletedNodes)
-    {
-        mTimeline->AddNewNode(&node);
-    }
-
-    mDeletedNodes.clear();
+    delete mNodeData;
+    mNodeData = nullptr;
 }
-/****************************/
 
 //utility
 void ImTimelineInternal::ShowTimelineNodeFlagsDebugUI(TimelineNode* node)
@@ -142,7 +231,7 @@ void ImTimelineInternal::ShowTimelineNodeFlagsDebugUI(TimelineNode* node)
 
 ImDataController* ImTimelineInternal::CreateDefaultDataController()
 {
-    auto container = new VectorContainer(ImTimelineInternal::TIMELINE_RESERVE_NODE_COUNT);
+    auto container = new ChunkedContainer(ImTimelineInternal::TIMELINE_CHUNK_NODE_COUNT);
     return container;
 }
 
@@ -3,14 +3,47 @@
 
 namespace ImTimelineInternal
 {
-    static constexpr int TIMELINE_RESERVE_NODE_COUNT = 500;
+    static constexpr int TIMELINE_RESERVE_NODE_COUNT = 500; // fixed capacity when a section uses a VectorContainer
+    static constexpr int TIMELINE_CHUNK_NODE_COUNT = 256; // nodes per chunk of the default ChunkedContainer
    //command
-    class AddCommand : public BaseCommand {
+
+    // What it takes to bring a deleted node back. Display properties are only kept when they were changed from the defaults.
+    struct sNodeRecord {
+        NodeID mID = InvalidNodeID;
+        s32 mSection = 0;
+        s32 mStart = 0;
+        s32 mEnd = 0;
+        u32 mFlags = 0;
+        std::string mText;
+        std::shared_ptr<CustomNodeBase> mCustomNode;
+        std::unique_ptr<sGenericDisplayProperties> mDisplayProperties;
+
+        void Capture(const TimelineNode& node);
+        void MoveTo(TimelineNode& outNode); // the record is left empty
+        size_t GetMemoryFootprint() const;
+    };
+
+    // Base of the commands that add or remove whole nodes. The nodes are referenced by ID, a record of them is only held
+    // while they're out of the timeline, so the entries stay valid whatever the storage does with the nodes in between.
+    class NodeSetCommand : public BaseCommand {
     public:
-        AddCommand(ImTimeline::Timeline* aTimeline) : BaseCommand(aTimeline) {}
-        virtual void command_do() override;
-        virtual void command_undo() override;
-        TimelineNode mNewNode;
+        NodeSetCommand(ImTimeline::Timeline* aTimeline) : BaseCommand(aTimeline) {}
+
+        std::vector<NodeID> mNodeIDs;
+        std::vector<sNodeRecord> mRecords; // while the nodes are removed
+
+    protected:
+        void removeNodes();
+        void restoreNodes();
+        size_t getNodeSetFootprint() const;
+    };
+
+    class AddCommand : public NodeSetCommand {
+    public:
+        AddCommand(ImTimeline::Timeline* aTimeline) : NodeSetCommand(aTimeline) {}
+        virtual void command_do() override { restoreNodes(); }
+        virtual void command_undo() override { removeNodes(); }
+        virtual size_t GetMemoryFootprint() const override { return sizeof(AddCommand) + getNodeSetFootprint(); }
     };
 
     class MoveNodeCommand : public BaseCommand {
@@ -18,23 +51,37 @@ namespace ImTimelineInternal
         MoveNodeCommand(ImTimeline::Timeline* aTimeline) : BaseCommand(aTimeline) {}
         virtual void command_do() override;
         virtual void command_undo() override;
-    
+        virtual size_t GetMemoryFootprint() const override { return sizeof(MoveNodeCommand); }
+
+        NodeID mNodeID = InvalidNodeID;
+        s32 mOldStart = 0;
+        s32 mOldSectionID = -1;
         s32 mNewStart = 0;
         s32 mNewSectionID = -1;
-        TimelineNode* mNodeToMove = nullptr;
     };
 
-   class DeleteCommand : public BaseCommand {
+    // Commands recorded between Timeline::BeginTransaction and CommitTransaction, done and undone as one step
+    class CompoundCommand : public BaseCommand {
     public:
-        DeleteCommand(ImTimeline::Timeline* aTimeline) : BaseCommand(aTimeline) {}
+        CompoundCommand(ImTimeline::Timeline* aTimeline) : BaseCommand(aTimeline) {}
         virtual void command_do() override;
         virtual void command_undo() override;
+        virtual size_t GetMemoryFootprint() const override;
+        std::vector<std::unique_ptr<BaseCommand>> mCommands; // in the order they were done
+    };
+
+   class DeleteCommand : public NodeSetCommand {
+    public:
+        DeleteCommand(ImTimeline::Timeline* aTimeline) : NodeSetCommand(aTimeline) {}
+        virtual void command_do() override;
+        virtual void command_undo() override { restoreNodes(); }
+        virtual size_t GetMemoryFootprint() const override { return sizeof(DeleteCommand) + getNodeSetFootprint(); }
         
+        // the nodes inside the range the first time, a redo deletes the same nodes wherever they are
         s32 section;
         s32 start;
         s32 end;
-
-        std::vector<TimelineNode> mDeletedNodes;
+        bool mbHasCollected = false;
     };
  
 
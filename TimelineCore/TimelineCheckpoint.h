@@ -0,0 +1,38 @@
+#pragma once
+
+#include "TimelineDefines.h"
+
+namespace ImTimeline
+{
+   /******
+    ITimelineCheckpointState
+    =========================
+    - State that custom nodes build up while they're played, saved with every player checkpoint.
+     A seek restores the state of the nearest checkpoint before the target and replays the node callbacks from there.
+    */
+   class ITimelineCheckpointState
+   {
+   public:
+      virtual ~ITimelineCheckpointState() = default;
+
+      virtual void SaveCheckpoint(std::vector<u8>& outState) = 0;
+      virtual void RestoreCheckpoint(const std::vector<u8>& aState) = 0;
+   };
+
+   struct sCheckpointSettings
+   {
+      s32 mIntervalFrames = 0; // a checkpoint every this many frames, 0 turns checkpoints off
+      size_t mMemoryBudgetBytes = 64 * 1024 * 1024; // past the budget every other checkpoint is dropped and the interval doubles
+   };
+
+   struct sCheckpoint
+   {
+      s32 mTimestamp = 0;
+      bool mbIsOrigin = false; // the players start fresh, only the user state is stored
+      std::vector<u32> mDataVersions; // per child player, the checkpoint is stale once a section changed
+      std::vector<s32> mPlayerState;
+      std::vector<u8> mUserState;
+
+      size_t GetSize() const { return sizeof(sCheckpoint) + mDataVersions.size() * sizeof(u32) + mPlayerState.size() * sizeof(s32) + mUserState.size(); }
+   };
+}
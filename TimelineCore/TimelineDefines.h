@@ -2,7 +2,9 @@
 #include "../Core/CoreDefines.h"
 #include "../Core/ImTimelineLog.h"
 
+#include <atomic>
 #include <bitset>
+#include <cstdint>
 
 #define IMTIMELINE_VERSION_STR "0.2.0 WIP"
 #define IMTIMELINE_VERSION_NUM 002010
@@ -68,10 +70,11 @@ class CustomNodeBase;
 
 namespace ImTimeline {
 class Timeline;
+class TimelinePreparePool;
 }
 
 namespace ImTimelineInternal {
-class MoveNodeCommand;
+struct sNodeRecord;
 }
 
 struct TimelineNode {
@@ -121,7 +124,7 @@ private:
     s32 section = 0;
 
     friend class ::ImTimeline::Timeline;
-    friend class ::ImTimelineInternal::MoveNodeCommand;
+    friend struct ::ImTimelineInternal::sNodeRecord;
 };
 
 class CustomNodeBase {
@@ -130,17 +133,49 @@ public:
     {
     }
 
+    // a copy is a different node as far as the prepare pool is concerned, it starts out unprepared
+    CustomNodeBase(const CustomNodeBase&)
+        : mPrepareState(0)
+    {
+    }
+
+    CustomNodeBase& operator=(const CustomNodeBase&)
+    {
+        mPrepareState.store(0);
+        return *this;
+    }
+
     virtual void OnDraw(const TimelineNode& nodeData, ImRect drawArea, bool& refIsSelected) { }
     virtual void OnDebugGUI() { }
 
-    virtual void OnTimelinePlayerSetup() {}; // node is about to be played
-    bool IsReady() { return true; }; // node can be played
+    virtual void OnTimelinePlayerSetup() {}; // node is about to be played, runs on a lookahead worker thread when the player has a lookahead window
+    virtual bool IsReady() { return true; }; // node can be played, polled from the playback thread once OnTimelinePlayerSetup returned
     virtual void OnNodeActivate() {}; // node play
     virtual void OnNodeDeactivate() {}; // node stop play
+    virtual size_t GetMemoryFootprint() const { return sizeof(CustomNodeBase); }; // counted against the undo budget while a deleted node is kept for undo
+
+private:
+    std::atomic<u8> mPrepareState { 0 }; // TimelinePreparePool::ePrepareState
+
+    friend class ::ImTimeline::TimelinePreparePool;
 };
 
 struct sNodePlayProperties {
-    // todo?
+    s32 mTimestamp = 0; // frame the event belongs to, can lie before the player's timestamp when a tick skipped frames
+    f32 mPlayerTimestamp = 0.0f; // player timestamp when the event was dispatched
+    int64_t mClockTicks = -1; // tick of the player's external clock at mTimestamp, -1 without one. Events are dispatched once the
+                              // playhead passed their frame, the difference to the clock's current tick is the sub-frame offset to schedule them with
+};
+
+enum class eNodePlayEventType {
+    Activate,
+    Deactivate,
+};
+
+struct sNodePlayEvent {
+    TimelineNode* mNode = nullptr;
+    eNodePlayEventType mType = eNodePlayEventType::Activate;
+    sNodePlayProperties mProperties;
 };
 
 namespace ImTimeline {
@@ -178,15 +213,25 @@ struct sTimelineSection {
         OnFinalize();
     }
 
-    void OnFinalize()
-    {
-        delete mNodeData;
-        mNodeData = nullptr;
-    }
+    void OnFinalize();
 };
 
 using TimelineDataMap = std::unordered_map<u32, sTimelineSection>;
 
+// A playhead of its own over every section, see Timeline::AddPlaybackCursor
+struct sPlaybackCursor {
+    std::string mName;
+    ImU32 mColor = 0xFF2A2AFF;
+    std::shared_ptr<ImTimeline::TimelinePlayer> mPlayer; // root, the section players are its children
+    std::unordered_map<u32, std::shared_ptr<ImTimeline::TimelinePlayer>> mSectionPlayers; // section ID -> player over the section's data
+    std::shared_ptr<ITimelinePlayerView> mView; // nullptr: the section players share the view of the main player's sections
+
+    // event throughput, measured over about a second
+    size_t mWindowEventCount = 0;
+    f32 mWindowSeconds = 0.0f;
+    f32 mEventsPerSecond = 0.0f;
+};
+
 namespace ImTimeline {
 class Timeline;
 
@@ -196,6 +241,7 @@ public:
     BaseCommand(ImTimeline::Timeline* aTimeline) { mTimeline = aTimeline; }
     virtual void command_do() = 0;
     virtual void command_undo() = 0;
+    virtual size_t GetMemoryFootprint() const = 0; // bytes held for undo and redo, the command itself included
     virtual ~BaseCommand()
     {
     }
@@ -204,6 +250,13 @@ protected:
     ImTimeline::Timeline* mTimeline = nullptr;
 };
 
+// Bounds the undo history, redo steps are dropped first, then the oldest undo steps. The last edit can always be undone,
+// even when its step alone is over the byte budget.
+struct sUndoSettings {
+    s32 mMaxSteps = 1000;
+    size_t mMaxBytes = 64 * 1024 * 1024;
+};
+
 struct NodeInitDescriptor {
     NodeID ID = InvalidNodeID;
     std::string label = "";
@@ -235,6 +288,9 @@ struct ImTimelineStyle {
     bool HasSeekbar = true;
     ImU32 SeekbarColor = 0xFF2A2AFF;
     f32 SeekbarWidth = 3.0f;
+    f32 LodNodePixelThreshold = 3.0f; // sections whose average node is narrower than this are drawn as density bars
+    f32 LodBarMinWidth = 2.0f;
+    ImU32 LodBarColor = IM_COL32(76, 111, 155, 255);
 };
 
 struct sInputData {
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "TimelineDefines.h"
+#include <cstdint>
+#include <type_traits>
+
+/******
+ ImTimelineFile
+ =========================
+ - Native binary format of a timeline, see TimelineSerializer. Every block is a plain array stored in host byte order
+  and aligned to kBlockAlignment, so a memory-mapped file is used in place: nothing is parsed or allocated per node.
+  Layout: header, per section its columns (starts, ends, IDs, node infos, ID index) and summary pyramid entries,
+  string data, string table, display properties table, then the section table. Offsets are from the start of the file.
+  Nodes are sorted by start in every section, like the ImDataController start order.
+ */
+namespace ImTimelineFile
+{
+   static constexpr char kMagic[8] = { 'I', 'M', 'T', 'L', 'B', 'I', 'N', '\0' };
+   static constexpr u32 kVersion = 2;
+   static constexpr u32 kByteOrderMark = 0x01020304; // reads back differently on a host of the other endianness
+   static constexpr u32 kNoIndex = 0xFFFFFFFFu;
+   static constexpr uint64_t kBlockAlignment = 64;
+
+   struct sFileHeader
+   {
+      char mMagic[8];
+      u32 mVersion;
+      u32 mByteOrderMark;
+      uint64_t mFileSize;
+      u32 mHeaderSize;
+      u32 mSectionCount;
+      uint64_t mSectionTableOffset; // sFileSection[mSectionCount]
+      u32 mStringCount;
+      u32 mDisplayPropertiesCount;
+      uint64_t mStringTableOffset; // sFileString[mStringCount]
+      uint64_t mStringDataOffset;
+      uint64_t mStringDataSize;
+      uint64_t mDisplayPropertiesOffset; // sFileDisplayProperties[mDisplayPropertiesCount]
+      s32 mFrameMax;
+      s32 mMaxNodeID;
+   };
+
+   // mLength characters at mStringDataOffset + mOffset, not null terminated
+   struct sFileString
+   {
+      uint64_t mOffset;
+      u32 mLength;
+      u32 mPadding;
+   };
+
+   struct sFileDisplayProperties
+   {
+      f32 mHeight;
+      f32 mWidth;
+      u32 mBackgroundColor;
+      u32 mBackgroundColorTwo;
+      u32 mForegroundColor;
+      s32 mAccentThickness;
+      f32 mSpacing;
+      f32 mBorderRadius;
+      f32 mBorderThickness;
+      u32 mPadding;
+   };
+
+   // the parts of a node a range scan doesn't need, read when the node is handed out
+   struct sFileNodeInfo
+   {
+      u32 mText; // string index
+      u32 mFlags; // eTimelineNodeFlags bits
+      u32 mDisplayProperties; // display properties index, kNoIndex for the defaults
+   };
+
+   struct sFileIDEntry
+   {
+      NodeID mID;
+      u32 mIndex; // position in the start order
+   };
+
+   struct sFileSection
+   {
+      s32 mID;
+      u32 mName; // string index
+      s32 mEndTimestamp;
+      s32 mMaxDuration; // upper bound of end - start, bounds how far back an overlap scan has to look
+      sFileDisplayProperties mDisplayProperties;
+      uint64_t mNodeCount;
+      uint64_t mStartsOffset; // s32[mNodeCount]
+      uint64_t mEndsOffset; // s32[mNodeCount]
+      uint64_t mIDsOffset; // NodeID[mNodeCount]
+      uint64_t mNodeInfoOffset; // sFileNodeInfo[mNodeCount]
+      uint64_t mIDIndexOffset; // sFileIDEntry[mNodeCount], sorted by ID
+
+      // NodeSummaryPyramid, only its non-empty buckets
+      s32 mSummaryBucketFrames;
+      u32 mSummaryLevelCount;
+      uint64_t mSummaryNodeCount;
+      int64_t mSummaryOccupiedFrames;
+      uint64_t mSummaryEntryCount;
+      uint64_t mSummaryOffset; // NodeSummaryPyramid::sEntry[mSummaryEntryCount], sorted by key
+   };
+
+   // the layout is part of the format, a change here needs a new kVersion
+   static_assert(sizeof(sFileHeader) == 88, "sFileHeader layout changed");
+   static_assert(sizeof(sFileString) == 16, "sFileString layout changed");
+   static_assert(sizeof(sFileDisplayProperties) == 40, "sFileDisplayProperties layout changed");
+   static_assert(sizeof(sFileNodeInfo) == 12, "sFileNodeInfo layout changed");
+   static_assert(sizeof(sFileIDEntry) == 8, "sFileIDEntry layout changed");
+   static_assert(sizeof(sFileSection) == 144, "sFileSection layout changed");
+   static_assert(std::is_trivially_copyable_v<sFileSection>, "file blocks are copied as raw bytes");
+
+   inline uint64_t AlignOffset(uint64_t aOffset)
+   {
+      return (aOffset + kBlockAlignment - 1) & ~(kBlockAlignment - 1);
+   }
+
+   inline sFileDisplayProperties ToFile(const sGenericDisplayProperties& aProperties)
+   {
+      sFileDisplayProperties result = {};
+      result.mHeight = aProperties.mHeight;
+      result.mWidth = aProperties.mWidth;
+      result.mBackgroundColor = aProperties.mBackgroundColor;
+      result.mBackgroundColorTwo = aProperties.mBackgroundColorTwo;
+      result.mForegroundColor = aProperties.mForegroundColor;
+      result.mAccentThickness = aProperties.AccentThickness;
+      result.mSpacing = aProperties.Spacing;
+      result.mBorderRadius = aProperties.BorderRadius;
+      result.mBorderThickness = aProperties.BorderThickness;
+      return result;
+   }
+
+   inline sGenericDisplayProperties FromFile(const sFileDisplayProperties& aProperties)
+   {
+      sGenericDisplayProperties result;
+      result.mHeight = aProperties.mHeight;
+      result.mWidth = aProperties.mWidth;
+      result.mBackgroundColor = aProperties.mBackgroundColor;
+      result.mBackgroundColorTwo = aProperties.mBackgroundColorTwo;
+      result.mForegroundColor = aProperties.mForegroundColor;
+      result.AccentThickness = aProperties.mAccentThickness;
+      result.Spacing = aProperties.mSpacing;
+      result.BorderRadius = aProperties.mBorderRadius;
+      result.BorderThickness = aProperties.mBorderThickness;
+      return result;
+   }
+}
@@ -0,0 +1,375 @@
+#include "TimelinePlaybackThread.h"
+#include "TimelinePlayer.h"
+#include "../Core/ImTimelineLog.h"
+#include "../TimelineViews/ITimelinePlayerView.h"
+
+#include <algorithm>
+#include <cmath>
+
+/******
+ TimelinePlaybackThread::ViewProxy
+ =========================
+ - Stands in for a player view while the playback thread runs, every node event goes through the thread's delivery.
+ */
+class ImTimeline::TimelinePlaybackThread::ViewProxy : public ITimelinePlayerView {
+public:
+    ViewProxy(TimelinePlaybackThread* aOwner, std::shared_ptr<ITimelinePlayerView> aTarget)
+        : mOwner(aOwner)
+        , mTarget(std::move(aTarget))
+    {
+    }
+
+    void OnTimelinePlayStart(const sNodePlayProperties& properties = sNodePlayProperties()) override { mTarget->OnTimelinePlayStart(properties); }
+
+    void OnNodeActivate(TimelineNode* node, const sNodePlayProperties& properties = sNodePlayProperties()) override
+    {
+        sNodePlayEvent event;
+        event.mNode = node;
+        event.mType = eNodePlayEventType::Activate;
+        event.mProperties = properties;
+        mOwner->Deliver(mTarget.get(), &event, 1);
+    }
+
+    void OnNodeDeactivate(TimelineNode* node, const sNodePlayProperties& properties = sNodePlayProperties()) override
+    {
+        sNodePlayEvent event;
+        event.mNode = node;
+        event.mType = eNodePlayEventType::Deactivate;
+        event.mProperties = properties;
+        mOwner->Deliver(mTarget.get(), &event, 1);
+    }
+
+    void OnNodeEvents(const sNodePlayEvent* events, size_t count) override { mOwner->Deliver(mTarget.get(), events, count); }
+
+    void Draw() override { mTarget->Draw(); }
+
+    const std::shared_ptr<ITimelinePlayerView>& GetTarget() const { return mTarget; }
+
+private:
+    TimelinePlaybackThread* mOwner = nullptr;
+    std::shared_ptr<ITimelinePlayerView> mTarget;
+};
+
+ImTimeline::TimelinePlaybackThread::~TimelinePlaybackThread()
+{
+    Stop();
+}
+
+void ImTimeline::TimelinePlaybackThread::Start(std::shared_ptr<TimelinePlayer> aRootPlayer, std::recursive_mutex* aDataMutex, UpdateFunction aUpdate, const sPlaybackThreadSettings& aSettings)
+{
+    Start(std::vector<std::shared_ptr<TimelinePlayer>> { std::move(aRootPlayer) }, aDataMutex, std::move(aUpdate), aSettings);
+}
+
+void ImTimeline::TimelinePlaybackThread::Start(std::vector<std::shared_ptr<TimelinePlayer>> aRootPlayers, std::recursive_mutex* aDataMutex, UpdateFunction aUpdate,
+    const sPlaybackThreadSettings& aSettings)
+{
+    IM_ASSERT(aRootPlayers.empty() == false && aRootPlayers.front() != nullptr && aDataMutex != nullptr && aUpdate);
+
+    if (IsRunning()) {
+        LOG_WARNING_PRINTF("TimelinePlaybackThread is already running", 0);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(*aDataMutex);
+
+    mRootPlayers = std::move(aRootPlayers);
+    mDataMutex = aDataMutex;
+    mUpdate = std::move(aUpdate);
+    mSettings = aSettings;
+    mSettings.mTickMicroseconds = std::max(mSettings.mTickMicroseconds, 50);
+    mSettings.mSpinMicroseconds = ImClamp(mSettings.mSpinMicroseconds, 0, mSettings.mTickMicroseconds);
+    mQueue = std::make_unique<SPSCQueue<sQueuedEvent>>(std::max<size_t>(mSettings.mQueueCapacity, 16));
+    mOverflow.clear();
+    mTickTime = std::chrono::steady_clock::now();
+
+    for (const auto& rootPlayer : mRootPlayers) {
+        RedirectViews(rootPlayer.get());
+    }
+
+    // the thread can't reach Deliver before this lock is released, so it always sees its own ID
+    mbRunning.store(true, std::memory_order_release);
+    mThread = std::thread(&TimelinePlaybackThread::ThreadMain, this);
+    mThreadID = mThread.get_id();
+
+    LOG_INFO_PRINTF("TimelinePlaybackThread started, tick %dus", mSettings.mTickMicroseconds);
+}
+
+void ImTimeline::TimelinePlaybackThread::Stop()
+{
+    if (IsRunning() == false) {
+        return;
+    }
+
+    mbRunning.store(false, std::memory_order_release);
+    mThread.join();
+    mThreadID = std::thread::id();
+
+    std::lock_guard<std::recursive_mutex> lock(*mDataMutex);
+
+    // nothing that was dispatched gets lost, the views receive the rest before they're handed back
+    DrainAllEvents();
+    for (const auto& rootPlayer : mRootPlayers) {
+        RestoreViews(rootPlayer.get());
+    }
+
+    mProxies.clear();
+    mQueue.reset();
+    mRootPlayers.clear();
+    mUpdate = nullptr;
+
+    LOG_INFO_PRINTF("TimelinePlaybackThread stopped after %d ticks", static_cast<s32>(mTickCount.load()));
+}
+
+void ImTimeline::TimelinePlaybackThread::ThreadMain()
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto tick = std::chrono::microseconds(mSettings.mTickMicroseconds);
+    const auto spin = std::chrono::microseconds(mSettings.mSpinMicroseconds);
+
+    auto lastTime = Clock::now();
+    auto nextTick = lastTime + tick;
+
+    while (mbRunning.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_until(nextTick - spin);
+        while (Clock::now() < nextTick) {
+            std::this_thread::yield();
+        }
+
+        auto now = Clock::now();
+        double overshoot = std::chrono::duration<double, std::micro>(now - nextTick).count();
+        if (overshoot > mMaxTickOvershootMicroseconds.load(std::memory_order_relaxed)) {
+            mMaxTickOvershootMicroseconds.store(overshoot, std::memory_order_relaxed);
+        }
+
+        // a tick that was missed entirely isn't made up with a burst, the schedule restarts from now
+        nextTick = now - nextTick > tick ? now + tick : nextTick + tick;
+
+        f32 deltaTime = std::chrono::duration<f32>(now - lastTime).count();
+        lastTime = now;
+
+        // Stop can be called by a thread that holds the data mutex, so waiting for it has to keep an eye on mbRunning
+        std::unique_lock<std::recursive_mutex> lock(*mDataMutex, std::defer_lock);
+        while (lock.try_lock() == false) {
+            if (mbRunning.load(std::memory_order_acquire) == false) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        const sTimeStepSettings& timeStep = mRootPlayers.front()->GetTimeStepSettings();
+        mFramesPerSecond = timeStep.mFixedFramesPerUpdate > 0 ? 0.0f : timeStep.mFramesPerSecond * timeStep.mPlaybackSpeed;
+        mTickTime = now;
+
+        FlushOverflow();
+        mUpdate(deltaTime);
+        mTickCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// An event's frame was reached somewhere inside the tick, the fraction of a frame the player is past it says how long ago
+std::chrono::steady_clock::time_point ImTimeline::TimelinePlaybackThread::GetDueTime(const sNodePlayEvent& aEvent, std::chrono::steady_clock::time_point aNow) const
+{
+    if (mFramesPerSecond <= 0.0f) {
+        return aNow;
+    }
+
+    f32 framesLate = ImMax(aEvent.mProperties.mPlayerTimestamp - static_cast<f32>(aEvent.mProperties.mTimestamp), 0.0f);
+    auto late = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(framesLate / mFramesPerSecond));
+    return aNow - late;
+}
+
+// Called with the data mutex held, by the playback thread during an update or by the UI thread when it drives the player
+void ImTimeline::TimelinePlaybackThread::Deliver(ITimelinePlayerView* aView, const sNodePlayEvent* aEvents, size_t aCount)
+{
+    auto now = std::chrono::steady_clock::now();
+    bool bOnPlaybackThread = std::this_thread::get_id() == mThreadID;
+
+    if (mSettings.mDelivery == ePlaybackDelivery::PlaybackThread || bOnPlaybackThread == false) {
+        // the UI thread is the consumer, whatever is still queued is older and goes first
+        if (bOnPlaybackThread == false) {
+            DrainAllEvents();
+        }
+
+        // events raised by a call from the UI thread are due the moment they're raised
+        for (size_t i = 0; i < aCount; ++i) {
+            auto dueTime = bOnPlaybackThread ? GetDueTime(aEvents[i], mTickTime) : now;
+            mLatency.Record(std::chrono::duration<double, std::micro>(now - dueTime).count());
+        }
+        aView->OnNodeEvents(aEvents, aCount);
+        return;
+    }
+
+    FlushOverflow();
+
+    for (size_t i = 0; i < aCount; ++i) {
+        sQueuedEvent queued;
+        queued.mEvent = aEvents[i];
+        queued.mView = aView;
+        queued.mDueTime = GetDueTime(aEvents[i], mTickTime);
+
+        if (mOverflow.empty() == false || mQueue->try_push(queued) == false) {
+            mOverflow.push_back(queued);
+            mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ImTimeline::TimelinePlaybackThread::FlushOverflow()
+{
+    size_t flushed = 0;
+    while (flushed < mOverflow.size() && mQueue->try_push(mOverflow[flushed])) {
+        flushed++;
+    }
+    mOverflow.erase(mOverflow.begin(), mOverflow.begin() + flushed);
+}
+
+void ImTimeline::TimelinePlaybackThread::DeliverQueued(const sQueuedEvent& aQueued)
+{
+    mLatency.Record(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - aQueued.mDueTime).count());
+    aQueued.mView->OnNodeEvents(&aQueued.mEvent, 1);
+}
+
+void ImTimeline::TimelinePlaybackThread::DrainEvents()
+{
+    if (mQueue == nullptr || mbIsDraining) {
+        return;
+    }
+
+    mbIsDraining = true;
+
+    sQueuedEvent queued;
+    while (mQueue->try_pop(queued)) {
+        DeliverQueued(queued);
+    }
+
+    mbIsDraining = false;
+}
+
+void ImTimeline::TimelinePlaybackThread::DrainAllEvents()
+{
+    if (mQueue == nullptr || mbIsDraining) {
+        return;
+    }
+
+    DrainEvents();
+
+    mbIsDraining = true;
+
+    // the playback thread is blocked on the mutex, so the overflow can be taken over directly
+    std::vector<sQueuedEvent> overflow;
+    overflow.swap(mOverflow);
+    for (const sQueuedEvent& queued : overflow) {
+        DeliverQueued(queued);
+    }
+
+    mbIsDraining = false;
+}
+
+void ImTimeline::TimelinePlaybackThread::RedirectViews(TimelinePlayer* aPlayer)
+{
+    if (aPlayer == nullptr) {
+        return;
+    }
+
+    std::shared_ptr<ITimelinePlayerView> view = aPlayer->GetViewUI();
+    if (view != nullptr) {
+        // views shared between players get a shared proxy
+        auto itProxy = std::find_if(mProxies.begin(), mProxies.end(), [&](const std::shared_ptr<ViewProxy>& proxy) { return proxy->GetTarget() == view; });
+
+        if (itProxy == mProxies.end()) {
+            mProxies.push_back(std::make_shared<ViewProxy>(this, view));
+            itProxy = mProxies.end() - 1;
+        }
+
+        aPlayer->SetViewUI(*itProxy);
+    }
+
+    for (const auto& player : aPlayer->GetPlayers()) {
+        RedirectViews(player.get());
+    }
+}
+
+// Players added while running copied a proxy from their parent, so every player is checked, not just the redirected ones
+void ImTimeline::TimelinePlaybackThread::RestoreViews(TimelinePlayer* aPlayer)
+{
+    if (aPlayer == nullptr) {
+        return;
+    }
+
+    std::shared_ptr<ITimelinePlayerView> view = aPlayer->GetViewUI();
+    for (const auto& proxy : mProxies) {
+        if (view == proxy) {
+            aPlayer->SetViewUI(proxy->GetTarget());
+            break;
+        }
+    }
+
+    for (const auto& player : aPlayer->GetPlayers()) {
+        RestoreViews(player.get());
+    }
+}
+
+void ImTimeline::TimelinePlaybackThread::OnDebugGUIPerformance()
+{
+    ImGui::Text("Playback Thread: %s", IsRunning() ? "running" : "stopped");
+    ImGui::Text("Tick: %dus Delivery: %s", mSettings.mTickMicroseconds, mSettings.mDelivery == ePlaybackDelivery::PlaybackThread ? "playback thread" : "UI thread queue");
+    ImGui::Text("Ticks: %d Max Tick Overshoot: %.1fus", static_cast<s32>(mTickCount.load()), mMaxTickOvershootMicroseconds.load());
+
+    u32 count = mLatency.mCount.load();
+    ImGui::Text("Dispatch Latency (%d events):", static_cast<s32>(count));
+    if (count > 0) {
+        ImGui::Text("- Average: %.1fus Max: %.1fus", mLatency.mTotalMicroseconds.load() / count, mLatency.mMaxMicroseconds.load());
+        ImGui::Text("- p50 < %.0fus p99 < %.0fus", mLatency.GetPercentileUpperBound(0.5f), mLatency.GetPercentileUpperBound(0.99f));
+    }
+    ImGui::Text("Queue Overflows: %d", static_cast<s32>(mOverflowCount.load()));
+
+    if (ImGui::Button("Reset Latency Stats")) {
+        mLatency.Reset();
+        mMaxTickOvershootMicroseconds.store(0.0);
+    }
+}
+
+/* LATENCY STATS */
+
+void ImTimeline::TimelinePlaybackThread::sLatencyStats::Record(double aMicroseconds)
+{
+    aMicroseconds = ImMax(aMicroseconds, 0.0);
+
+    s32 bucket = 0;
+    while (bucket < BucketCount - 1 && aMicroseconds >= static_cast<double>(1u << bucket)) {
+        bucket++;
+    }
+
+    mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mTotalMicroseconds.store(mTotalMicroseconds.load(std::memory_order_relaxed) + aMicroseconds, std::memory_order_relaxed);
+    if (aMicroseconds > mMaxMicroseconds.load(std::memory_order_relaxed)) {
+        mMaxMicroseconds.store(aMicroseconds, std::memory_order_relaxed);
+    }
+}
+
+double ImTimeline::TimelinePlaybackThread::sLatencyStats::GetPercentileUpperBound(f32 aPercentile) const
+{
+    u32 count = mCount.load(std::memory_order_relaxed);
+    u32 target = static_cast<u32>(std::ceil(count * aPercentile));
+    u32 seen = 0;
+
+    for (s32 bucket = 0; bucket < BucketCount; ++bucket) {
+        seen += mBuckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return static_cast<double>(1u << bucket);
+        }
+    }
+    return static_cast<double>(1u << (BucketCount - 1));
+}
+
+void ImTimeline::TimelinePlaybackThread::sLatencyStats::Reset()
+{
+    for (auto& bucket : mBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    mCount.store(0, std::memory_order_relaxed);
+    mTotalMicroseconds.store(0.0, std::memory_order_relaxed);
+    mMaxMicroseconds.store(0.0, std::memory_order_relaxed);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "TimelineDefines.h"
+#include "../Core/ImTimelineSPSCQueue.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class ITimelinePlayerView;
+
+namespace ImTimeline
+{
+   class TimelinePlayer;
+
+   enum class ePlaybackDelivery
+   {
+      PlaybackThread, // views are called on the playback thread, they have to synchronize themselves
+      UIThreadQueue, // views are called from DrainEvents on the UI thread
+   };
+
+   struct sPlaybackThreadSettings
+   {
+      s32 mTickMicroseconds = 1000;
+      s32 mSpinMicroseconds = 200; // the end of each tick is waited out by yielding, sleeping alone overshoots by up to a scheduler quantum
+      ePlaybackDelivery mDelivery = ePlaybackDelivery::UIThreadQueue;
+      size_t mQueueCapacity = 4096; // events beyond this wait on the playback thread until the ring has room, nothing is dropped
+   };
+
+   /******
+    TimelinePlaybackThread
+    =========================
+    - Runs the player updates on a dedicated timing thread, so node activations aren't quantized to the UI frame rate.
+     Every tick locks the data mutex the owner also holds for its edits, and then runs the update function.
+     While running, the views of the player tree are replaced by proxies. View callbacks are either made straight
+     on the playback thread, or queued in a lock-free ring that the UI thread drains.
+     Custom node callbacks (CustomNodeBase::OnNodeActivate/OnNodeDeactivate) always run on the playback thread.
+    */
+   class TimelinePlaybackThread
+   {
+   public:
+      using UpdateFunction = std::function<void(f32)>;
+
+      TimelinePlaybackThread() { }
+      TimelinePlaybackThread(const TimelinePlaybackThread&) = delete;
+      TimelinePlaybackThread& operator=(const TimelinePlaybackThread&) = delete;
+      ~TimelinePlaybackThread();
+
+      // aUpdate runs on the playback thread with aDataMutex held and receives the measured delta time
+      void Start(std::shared_ptr<TimelinePlayer> aRootPlayer, std::recursive_mutex* aDataMutex, UpdateFunction aUpdate, const sPlaybackThreadSettings& aSettings = sPlaybackThreadSettings());
+      // several player trees updated by aUpdate, the first one's frame rate times the delivery of queued events
+      void Start(std::vector<std::shared_ptr<TimelinePlayer>> aRootPlayers, std::recursive_mutex* aDataMutex, UpdateFunction aUpdate, const sPlaybackThreadSettings& aSettings = sPlaybackThreadSettings());
+      void Stop();
+      bool IsRunning() const { return mThread.joinable(); }
+      const sPlaybackThreadSettings& GetSettings() const { return mSettings; }
+
+      // UI thread: delivers the queued events in dispatch order, without taking the data mutex
+      void DrainEvents();
+      // UI thread with the data mutex held: also delivers the events still waiting on the playback thread
+      void DrainAllEvents();
+
+      void OnDebugGUIPerformance();
+
+   private:
+      class ViewProxy;
+
+      struct sQueuedEvent
+      {
+         sNodePlayEvent mEvent;
+         ITimelinePlayerView* mView = nullptr;
+         std::chrono::steady_clock::time_point mDueTime;
+      };
+
+      // written by a single thread, read by the debug UI
+      struct sLatencyStats
+      {
+         static constexpr s32 BucketCount = 24; // bucket i counts latencies below 2^i microseconds
+
+         std::atomic<u32> mCount { 0 };
+         std::atomic<double> mTotalMicroseconds { 0.0 };
+         std::atomic<double> mMaxMicroseconds { 0.0 };
+         std::atomic<u32> mBuckets[BucketCount] = {};
+
+         void Record(double aMicroseconds);
+         double GetPercentileUpperBound(f32 aPercentile) const;
+         void Reset();
+      };
+
+      void ThreadMain();
+      void Deliver(ITimelinePlayerView* aView, const sNodePlayEvent* aEvents, size_t aCount);
+      void DeliverQueued(const sQueuedEvent& aQueued);
+      void FlushOverflow();
+      std::chrono::steady_clock::time_point GetDueTime(const sNodePlayEvent& aEvent, std::chrono::steady_clock::time_point aNow) const;
+
+      void RedirectViews(TimelinePlayer* aPlayer);
+      void RestoreViews(TimelinePlayer* aPlayer);
+
+      std::thread mThread;
+      std::thread::id mThreadID;
+      std::atomic<bool> mbRunning { false };
+      std::recursive_mutex* mDataMutex = nullptr;
+      UpdateFunction mUpdate;
+      sPlaybackThreadSettings mSettings;
+      std::vector<std::shared_ptr<TimelinePlayer>> mRootPlayers;
+      std::vector<std::shared_ptr<ViewProxy>> mProxies;
+
+      std::unique_ptr<SPSCQueue<sQueuedEvent>> mQueue;
+      std::vector<sQueuedEvent> mOverflow; // guarded by mDataMutex, newer than everything in mQueue
+      bool mbIsDraining = false;
+      f32 mFramesPerSecond = 0.0f; // of the first root player at the current tick, 0 in fixed step mode
+      std::chrono::steady_clock::time_point mTickTime;
+
+      sLatencyStats mLatency;
+      std::atomic<u32> mTickCount { 0 };
+      std::atomic<double> mMaxTickOvershootMicroseconds { 0.0 };
+      std::atomic<u32> mOverflowCount { 0 };
+   };
+}
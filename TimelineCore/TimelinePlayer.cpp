@@ -2,6 +2,9 @@
 #include "TimelinePlayer.h"
 #include "../Core/ImTimelineLog.h"
 #include "../TimelineData/ImDataController.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
 
 /******
  ImTimeline::TimelinePlayer
@@ -23,13 +26,25 @@ ImTimeline::TimelinePlayer::TimelinePlayer()
 ImTimeline::TimelinePlayer::~TimelinePlayer()
 {
     //mTimelineData should be cleaned up higher-up
+
+    for (auto& player : mPlayers) {
+        if (player != nullptr && player->mParent == this) {
+            player->mParent = nullptr;
+        }
+    }
 }
 
 void ImTimeline::TimelinePlayer::Setup(ImDataController* aTimelineData, s32 aStartTimestamp)
 {
-    mTimeStep = IntTimelineTimeStep(aStartTimestamp);
+    mTimeStep.SetTimestamp(aStartTimestamp);
     mTimelineData = aTimelineData;
-    mPlayingNode = nullptr;
+    SetPlayingNode(nullptr);
+    mPlayCursor.mbIsValid = false;
+    mPrefetchCursor.mbIsValid = false;
+    mActiveNodes.clear();
+    mDelayedNodes.clear();
+    mPendingEvents.clear();
+    mLastEventTimestamp = aStartTimestamp;
     mbIsInitialized = true;
     ChangeState(eTimelineState::eState_None);
 }
@@ -39,6 +54,18 @@ bool ImTimeline::TimelinePlayer::IsRootTimeline() const
     return mTimelineData == nullptr && mPlayers.size() > 0;
 }
 
+void ImTimeline::TimelinePlayer::RemovePlayer(TimelinePlayer* aPlayer)
+{
+    if (aPlayer != nullptr && aPlayer->mParent == this) {
+        aPlayer->mParent = nullptr;
+    }
+    mSoloPlayers.erase(std::remove(mSoloPlayers.begin(), mSoloPlayers.end(), aPlayer), mSoloPlayers.end());
+    mScheduler.RemovePlayer(aPlayer);
+    ClearCheckpoints();
+    mPlayers.erase(std::remove_if(mPlayers.begin(), mPlayers.end(), [aPlayer](const std::shared_ptr<TimelinePlayer>& player) { return player.get() == aPlayer; }),
+        mPlayers.end());
+}
+
 void ImTimeline::TimelinePlayer::SetViewUI(std::shared_ptr<ITimelinePlayerView> newView)
 {
     mPlayerView = newView;
@@ -49,24 +76,34 @@ void ImTimeline::TimelinePlayer::Update(f32 aDeltaTime)
     if (mState != eTimelineState::eState_Playing)
         return;
 
-    mTimeStep.Update(aDeltaTime);
-
-    bool bChildTimelineFinished = true;
+    // after a jump the nodes under the new playhead start at the frame jumped to, not one step later
+    if (mPlayMode == ePlayMode::Concurrent && mTimelineData != nullptr && mPlayCursor.mbIsValid == false) {
+        SeekActiveNodes(GetCurrentTimestamp());
+    }
 
-    for (auto ptr_player : mPlayers) {
-        auto player = ptr_player;
+    double previous = mTimeStep.GetPosition();
 
-        if (player == nullptr)
-            continue;
+    if (mClockSync.HasSource() && mTimeStep.GetSettings().mFixedFramesPerUpdate <= 0) {
+        const sTimeStepSettings& settings = mTimeStep.GetSettings();
+        double predicted = previous + std::max(aDeltaTime, 0.0f) * static_cast<double>(settings.mFramesPerSecond * settings.mPlaybackSpeed);
+        mTimeStep.SetPosition(mClockSync.Correct(previous, predicted));
+    } else {
+        mTimeStep.Update(aDeltaTime);
+    }
 
-        player->Update(aDeltaTime);
+    // only a playhead crossing the end wraps, one that was moved past it plays on
+    if (mLoopRange.IsActive() && previous < mLoopRange.mEnd && mTimeStep.GetPosition() >= mLoopRange.mEnd) {
+        WrapLoop();
+    }
 
-        if (player->mState != eTimelineState::eState_Finished)
-            bChildTimelineFinished = false;
+    // child players are only woken at the frames where one of their nodes starts or ends
+    if (mPlayers.empty() == false) {
+        mScheduler.AdvanceTo(GetCurrentTimestamp());
+        CaptureCheckpointIfDue(GetCurrentTimestamp());
     }
 
     // everything finished playing and self has no timeline attached
-    if (bChildTimelineFinished && mTimelineData == nullptr) {
+    if (mTimelineData == nullptr && mScheduler.IsIdle() && IsLoopPending() == false) {
         LOG_INFO("All timelines finished Playing");
         mState = eTimelineState::eState_Finished;
     }
@@ -74,25 +111,70 @@ void ImTimeline::TimelinePlayer::Update(f32 aDeltaTime)
     if (mTimelineData == nullptr)
         return;
 
+    UpdateNodes();
+}
+
+void ImTimeline::TimelinePlayer::AdvanceTo(s32 aTimestamp)
+{
+    if (mState != eTimelineState::eState_Playing || mTimelineData == nullptr)
+        return;
+
+    if (mPlayMode == ePlayMode::Concurrent && mPlayCursor.mbIsValid == false) {
+        SeekActiveNodes(GetCurrentTimestamp());
+    }
+
+    mTimeStep.SetTimestamp(aTimestamp);
+    UpdateNodes();
+}
+
+void ImTimeline::TimelinePlayer::UpdateNodes()
+{
+    UpdateLookahead(mTimeStep.GetFrame());
+
+    if (mPlayMode == ePlayMode::Concurrent) {
+        UpdateConcurrent();
+        return;
+    }
+
+    RefreshPlayingNode();
+
     if (mPlayingNode == nullptr) {
-        mPlayingNode = GetNextNodeToPlay();
+        SetPlayingNode(GetNextNodeToPlay());
         mPlayingNodeProperties.mState = ePlayingNodeState::None;
+        mPlayingNodeProperties.mbIsDelayed = false;
 
         if (mPlayingNode == nullptr) {
-            mState = eTimelineState::eState_Finished;
+            if (IsLoopPending() == false) {
+                mState = eTimelineState::eState_Finished;
+            }
             return;
         }
     }
 
     if (mPlayingNode && mTimeStep.GetTimestamp() >= (f32)mPlayingNode->start) {
         if (mPlayingNodeProperties.mState == ePlayingNodeState::None) {
+            eActivation activation = PrepareActivation(mPlayingNode, mPlayingNodeProperties.mbIsDelayed);
+
+            // a delayed node that ended before it was ready is skipped as well
+            if (activation == eActivation::Delay && mTimeStep.GetTimestamp() < (f32)mPlayingNode->end) {
+                mPlayingNodeProperties.mbIsDelayed = true;
+                return;
+            }
+
+            if (activation != eActivation::Now) {
+                SetPlayingNode(nullptr);
+                return;
+            }
+
             // play node
             if (mPlayingNode->GetCustomNode()) {
                 mPlayingNode->GetCustomNode()->OnNodeActivate();
             }
+            mEventCount++;
 
-            if (mPlayerView) {
-                sNodePlayProperties nodePlayProperties; // todo current timestamp and metadata
+            if (mPlayerView && mbIsReplaying == false) {
+                sNodePlayProperties nodePlayProperties;
+                FillPlayProperties(nodePlayProperties, GetCurrentTimestamp(), mPlayingNodeProperties.mbIsDelayed ? GetCurrentTimestamp() : mPlayingNode->start);
                 mPlayerView->OnNodeActivate(mPlayingNode, nodePlayProperties);
             }
 
@@ -104,20 +186,83 @@ void ImTimeline::TimelinePlayer::Update(f32 aDeltaTime)
             if (mPlayingNode->GetCustomNode()) {
                 mPlayingNode->GetCustomNode()->OnNodeDeactivate();
             }
+            mEventCount++;
 
-            if (mPlayerView) {
-                sNodePlayProperties nodePlayProperties; // todo current timestamp and metadata
+            if (mPlayerView && mbIsReplaying == false) {
+                sNodePlayProperties nodePlayProperties;
+                FillPlayProperties(nodePlayProperties, GetCurrentTimestamp(), mPlayingNode->end);
                 mPlayerView->OnNodeDeactivate(mPlayingNode, nodePlayProperties);
             }
 
+            if (mPreparePool && mPlayingNode->GetCustomNode()) {
+                mPreparePool->Release(*mPlayingNode->GetCustomNode());
+            }
+
             mPlayingNodeProperties.mState = ePlayingNodeState::IsFinishedPlaying;
-            mPlayingNode = nullptr;
+            SetPlayingNode(nullptr);
         }
     }
 
     // node play logic
 }
 
+// The next frame at which UpdateNodes would do anything. In sequential mode the next node is picked one frame after the
+// previous one ended, the same as with a per-frame update, and only nodes starting after that frame are played.
+s32 ImTimeline::TimelinePlayer::GetNextEventTimestamp()
+{
+    s32 timestamp = GetCurrentTimestamp();
+
+    if (mTimelineData == nullptr || mPlayCursor.mbIsValid == false || mPlayCursor.mDataVersion != mTimelineData->get_version()) {
+        return mPlayMode == ePlayMode::Concurrent ? timestamp : timestamp + 1;
+    }
+
+    if (mPlayMode == ePlayMode::Concurrent) {
+        s32 next = timestamp;
+        bool bHasNext = false;
+
+        if (mActiveNodes.empty() == false) {
+            next = mActiveNodes.front().mEnd;
+            bHasNext = true;
+        }
+
+        if (mPlayCursor.mIndex < mTimelineData->node_count()) {
+            s32 start = mTimelineData->get_node_at(mPlayCursor.mIndex)->start;
+            next = bHasNext ? std::min(next, start) : start;
+        }
+
+        // delayed nodes are polled every frame until they're ready
+        if (mDelayedNodes.empty() == false) {
+            next = std::min(next, timestamp + 1);
+        }
+
+        return GetNextLookaheadTimestamp(next);
+    }
+
+    RefreshPlayingNode();
+
+    s32 next = timestamp + 1;
+    if (mPlayingNode != nullptr && mPlayingNodeProperties.mbIsDelayed == false) {
+        next = mPlayingNodeProperties.mState == ePlayingNodeState::None ? mPlayingNode->start : mPlayingNode->end;
+    }
+
+    return GetNextLookaheadTimestamp(next);
+}
+
+// The player also has to be woken when the next node enters the lookahead window
+s32 ImTimeline::TimelinePlayer::GetNextLookaheadTimestamp(s32 aNext)
+{
+    if (mPreparePool == nullptr || mLookaheadSettings.mFrames <= 0 || mPrefetchCursor.mbIsValid == false) {
+        return aNext;
+    }
+
+    if (mPrefetchCursor.mIndex >= mTimelineData->node_count()) {
+        return aNext;
+    }
+
+    s32 enters = mTimelineData->get_node_at(mPrefetchCursor.mIndex)->start - mLookaheadSettings.mFrames;
+    return std::min(aNext, std::max(enters, GetCurrentTimestamp() + 1));
+}
+
 void ImTimeline::TimelinePlayer::Play()
 {
     if (mbIsInitialized == false) {
@@ -133,15 +278,20 @@ void ImTimeline::TimelinePlayer::Play()
         return;
     }
 
-    f32 timestamp = mTimeStep.GetTimestamp();
-
+    // resuming keeps the fraction of a frame accumulated before the pause
     if (mState == eTimelineState::eState_Stopped) {
-        timestamp = 0.0f;
+        mTimeStep.SetTimestamp(0);
     }
 
-    mTimeStep.SetTimestamp(timestamp);
+    mPlayCursor.mbIsValid = false;
+    mPrefetchCursor.mbIsValid = false;
     mState = eTimelineState::eState_Playing;
 
+    // a parent that plays drives this player through its scheduler, otherwise it's ticked as a solo player
+    if (mParent != nullptr && mParent->IsPlaying() == false) {
+        mParent->mSoloPlayers.push_back(this);
+    }
+
     for (auto ptr_player : mPlayers) {
         auto player = ptr_player;
 
@@ -149,6 +299,9 @@ void ImTimeline::TimelinePlayer::Play()
             continue;
         player->Play();
     }
+
+    mScheduler.Reset(GetCurrentTimestamp());
+    AnchorClock();
 }
 
 void ImTimeline::TimelinePlayer::Pause()
@@ -160,6 +313,30 @@ void ImTimeline::TimelinePlayer::Stop()
 {
     ChangeState(eTimelineState::eState_Stopped);
 
+    // nodes under the playhead get their end event before the player rewinds
+    if (mPlayMode == ePlayMode::Concurrent && mTimelineData != nullptr) {
+        RefreshActiveNodes();
+        for (const sActiveNode& active : mActiveNodes) {
+            PushNodeEvent(active.mNode, eNodePlayEventType::Deactivate, mLastEventTimestamp);
+        }
+        DispatchNodeEvents();
+    } else if (mTimelineData != nullptr) {
+        RefreshPlayingNode();
+        if (mPlayingNode != nullptr && mPlayingNodeProperties.mState == ePlayingNodeState::IsPlayed) {
+            PushNodeEvent(mPlayingNode, eNodePlayEventType::Deactivate, GetCurrentTimestamp());
+            DispatchNodeEvents();
+        }
+    }
+
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        player->Stop();
+    }
+
     Setup(mTimelineData, 0);
     // TODO fire event?
 }
@@ -173,7 +350,9 @@ void ImTimeline::TimelinePlayer::SetStartTimestamp(s32 aStartTimestamp)
 
     mTimeStep.SetTimestamp(aStartTimestamp);
     mState = eTimelineState::eState_Paused;
-    mPlayingNode = nullptr;
+    SetPlayingNode(nullptr);
+    mPlayCursor.mbIsValid = false;
+    mPrefetchCursor.mbIsValid = false;
 
     for (auto ptr_player : mPlayers) {
         auto player = ptr_player;
@@ -185,77 +364,172 @@ void ImTimeline::TimelinePlayer::SetStartTimestamp(s32 aStartTimestamp)
     }
 }
 
-void ImTimeline::TimelinePlayer::DrawPlayer()
+void ImTimeline::TimelinePlayer::Seek(s32 aTimestamp)
 {
-    if (mPlayerView) {
-        mPlayerView->Draw();
-    } else {
-        ImGui::Text("No Player View Attached:");
+    if (mbIsInitialized == false) {
+        LOG_WARNING_PRINTF("TimelinePlayer not initialized", 0);
+        return;
+    }
+
+    if (mState != eTimelineState::eState_Playing) {
+        mState = eTimelineState::eState_Paused;
+    }
+
+    if (mCheckpointSettings.mIntervalFrames > 0 && SeekFromCheckpoint(aTimestamp)) {
+        return;
+    }
+
+    mTimeStep.SetTimestamp(aTimestamp);
+    mPrefetchCursor.mbIsValid = false;
+    mPlayCursor.mScrubCount++;
+
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        // finished sections play again after seeking back
+        player->Seek(aTimestamp);
+        player->mState = mState;
+    }
+
+    if (mTimelineData != nullptr) {
+        if (mPlayMode == ePlayMode::Concurrent) {
+            SeekActiveNodes(aTimestamp);
+        } else {
+            SeekPlayingNode(aTimestamp);
+        }
+        DispatchNodeEvents();
     }
+
+    mScheduler.Reset(aTimestamp);
+    AnchorClock();
 }
 
-void ImTimeline::TimelinePlayer::OnDebugGUI()
+void ImTimeline::TimelinePlayer::SetPlayMode(ePlayMode aMode)
 {
-    if (ImGui::TreeNodeEx("Debug State")) {
-        ImGui::Text("IsInitialized: %d", mbIsInitialized);
-        ImGui::Text("TimelinePlayer Count: %d", (s32)mPlayers.size());
-        ImGui::Text("IsRootTimeline: %d", IsRootTimeline());
-        ImGui::Dummy(ImVec2(0.0f, 6.0f));
-        ImGui::Text("Play State:");
-        ImGui::Text("- IsNoneState: %d", mState == eTimelineState::eState_None);
-        ImGui::Text("- IsStopped: %d", mState == eTimelineState::eState_Stopped);
-        ImGui::Text("- IsPaused: %d", mState == eTimelineState::eState_Paused);
-        ImGui::Text("- IsPlaying: %d", mState == eTimelineState::eState_Playing);
-        ImGui::Text("- IsFinished: %d", mState == eTimelineState::eState_Finished);
+    if (mState == eTimelineState::eState_Playing) {
+        LOG_WARNING_PRINTF("Can't change the play mode while playing", 0);
+        return;
+    }
 
-        ImGui::TreePop();
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        player->SetPlayMode(aMode);
     }
 
-    if (ImGui::TreeNodeEx("Debug Play UI")) {
-        if (mPlayingNode != nullptr) {
-            ImGui::Text("Playing Node: %d", mPlayingNode->GetID());
-        }
+    if (mPlayMode == aMode) {
+        return;
+    }
 
-        if (mState == eTimelineState::eState_None || mState == eTimelineState::eState_Stopped) {
-            if (ImGui::Button("Play from start")) {
-                Play();
-            }
-        }
+    // the other mode starts from a clean state at the current timestamp
+    if (mTimelineData != nullptr) {
+        Setup(mTimelineData, GetCurrentTimestamp());
+    }
+    mPlayMode = aMode;
+}
 
-        if (mState == eTimelineState::eState_Playing && ImGui::Button("Stop")) {
-            Stop();
-        }
+void ImTimeline::TimelinePlayer::SetTimeStepSettings(const sTimeStepSettings& aSettings)
+{
+    mTimeStep.SetSettings(aSettings);
 
-        if (mState == eTimelineState::eState_Playing && ImGui::Button("Pause")) {
-            Pause();
-        }
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
 
-        if (mState == eTimelineState::eState_Paused && ImGui::Button("Play from current frame")) {
-            Play();
-        }
-        ImGui::TreePop();
+        if (player == nullptr)
+            continue;
+
+        player->SetTimeStepSettings(aSettings);
     }
 
-    ImGui::Text("Current Frame: %d", GetCurrentTimestamp());
+    // a new rate or speed applies from the current position on
+    AnchorClock();
+}
 
-    if (mPlayingNode != nullptr) {
-        ImGui::Text("Current/Next Playing Node: %d", mPlayingNode->GetID());
+void ImTimeline::TimelinePlayer::SetClockSource(std::shared_ptr<ITimelineClockSource> aSource, const sClockSyncSettings& aSettings)
+{
+    mClockSync.SetSource(aSource);
+    mClockSync.SetSettings(aSettings);
+
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        player->SetClockSource(aSource, aSettings);
     }
-    ImGui::Text("Child Players: %d", static_cast<s32>(mPlayers.size()));
+
+    AnchorClock();
+}
+
+// The clock maps onto frames from the current position, the children copy the mapping so their events carry the same ticks
+void ImTimeline::TimelinePlayer::AnchorClock()
+{
+    if (mClockSync.HasSource() == false) {
+        return;
+    }
+
+    mClockSync.Anchor(mTimeStep.GetPosition(), mTimeStep.GetSettings());
+
     for (auto ptr_player : mPlayers) {
         auto player = ptr_player;
 
         if (player == nullptr)
             continue;
 
-        ImGui::Text("Child Player: %d Frame: %d", player->mUniqueID, player->GetCurrentTimestamp());
+        player->mClockSync = mClockSync;
     }
 }
 
-void ImTimeline::TimelinePlayer::ChangeState(eTimelineState aState)
+// The playhead is past the end of the loop: the last frame of the loop is played, then the nodes under the start of the
+// loop replace the active ones the way a seek does
+void ImTimeline::TimelinePlayer::WrapLoop()
 {
-    // check for transitions that are impossible
-    //...
+    double length = static_cast<double>(mLoopRange.mEnd - mLoopRange.mStart);
+    double position = mLoopRange.mStart + std::fmod(mTimeStep.GetPosition() - mLoopRange.mEnd, length);
+
+    mTimeStep.SetTimestamp(mLoopRange.mEnd - 1);
+    if (mPlayers.empty() == false) {
+        mScheduler.AdvanceTo(mLoopRange.mEnd - 1);
+    }
+    if (mTimelineData != nullptr) {
+        UpdateNodes();
+    }
+
+    // a section that played its last node in the loop is finished by now, it plays again from the start
+    mState = eTimelineState::eState_Playing;
+    Seek(static_cast<s32>(std::floor(position)));
+    mTimeStep.SetPosition(position);
+    AnchorClock();
+    mLoopCount++;
+}
+
+void ImTimeline::TimelinePlayer::SetLookaheadSettings(const sLookaheadSettings& aSettings)
+{
+    std::shared_ptr<TimelinePreparePool> pool = mPreparePool;
+
+    if (aSettings.mFrames > 0 && pool == nullptr) {
+        pool = std::make_shared<TimelinePreparePool>();
+    }
+
+    SetLookaheadSettings(aSettings, pool);
+}
+
+void ImTimeline::TimelinePlayer::SetLookaheadSettings(const sLookaheadSettings& aSettings, std::shared_ptr<TimelinePreparePool> aPool)
+{
+    mLookaheadSettings = aSettings;
+    mPreparePool = aPool;
+    mPrefetchCursor.mbIsValid = false;
+
+    if (mPreparePool) {
+        mPreparePool->SetWorkerCount(aSettings.mFrames > 0 ? aSettings.mWorkerCount : 0);
+    }
 
     for (auto ptr_player : mPlayers) {
         auto player = ptr_player;
@@ -263,28 +537,1072 @@ void ImTimeline::TimelinePlayer::ChangeState(eTimelineState aState)
         if (player == nullptr)
             continue;
 
-        player->ChangeState(aState);
+        player->SetLookaheadSettings(aSettings, aPool);
     }
 
-    mState = aState;
+    // the players have to be woken when nodes enter the new window
+    mScheduler.Reset(GetCurrentTimestamp());
 }
 
-TimelineNode* ImTimeline::TimelinePlayer::GetNextNodeToPlay()
+ImTimeline::TimelinePlayer::sLookaheadStats ImTimeline::TimelinePlayer::GetLookaheadStats() const
 {
-    TimelineNode* result = nullptr;
-    mTimelineData->iterate([this, &result](TimelineNode& node) {
-        if (result) {
-            return;
+    sLookaheadStats stats = mLookaheadStats;
+
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        sLookaheadStats childStats = player->GetLookaheadStats();
+        stats.mSubmitted += childStats.mSubmitted;
+        stats.mHits += childStats.mHits;
+        stats.mMisses += childStats.mMisses;
+        stats.mSkipped += childStats.mSkipped;
+        stats.mDelayed += childStats.mDelayed;
+        stats.mBlockedMilliseconds += childStats.mBlockedMilliseconds;
+    }
+
+    return stats;
+}
+
+// Submits the custom nodes starting up to mFrames ahead, in start order. After a seek or an edit the cursor starts over
+// at the playhead, nodes that are already prepared are skipped by the pool.
+void ImTimeline::TimelinePlayer::UpdateLookahead(s32 aTimestamp)
+{
+    if (mPreparePool == nullptr || mLookaheadSettings.mFrames <= 0) {
+        return;
+    }
+
+    if (mPrefetchCursor.mbIsValid == false || mPrefetchCursor.mDataVersion != mTimelineData->get_version()) {
+        mPrefetchCursor.mIndex = mTimelineData->find_first_after(aTimestamp - 1);
+        mPrefetchCursor.mDataVersion = mTimelineData->get_version();
+        mPrefetchCursor.mbIsValid = true;
+    }
+
+    s32 horizon = aTimestamp + mLookaheadSettings.mFrames;
+    size_t nodeCount = mTimelineData->node_count();
+
+    while (mPrefetchCursor.mIndex < nodeCount) {
+        TimelineNode* node = mTimelineData->get_node_at(mPrefetchCursor.mIndex);
+        if (node->start > horizon) {
+            break;
         }
 
-        if (mPlayingNode && mPlayingNode->GetID() == node.GetID()) {
-            return;
+        if (node->GetCustomNode()) {
+            mPreparePool->Submit(node->GetCustomNode());
+            mLookaheadStats.mSubmitted++;
+        }
+        mPrefetchCursor.mIndex++;
+    }
+}
+
+// Decides what happens to a node at its start, nodes without a custom node and players without lookahead play right away
+ImTimeline::TimelinePlayer::eActivation ImTimeline::TimelinePlayer::PrepareActivation(TimelineNode* aNode, bool bAlreadyDelayed)
+{
+    std::shared_ptr<CustomNodeBase> customNode = aNode->GetCustomNode();
+
+    if (mPreparePool == nullptr || mLookaheadSettings.mFrames <= 0 || customNode == nullptr) {
+        return eActivation::Now;
+    }
+
+    if (mPreparePool->IsReady(*customNode)) {
+        if (bAlreadyDelayed == false) {
+            mLookaheadStats.mHits++;
         }
+        return eActivation::Now;
+    }
+
+    if (bAlreadyDelayed) {
+        return eActivation::Delay;
+    }
+
+    // nodes that started before the window reached them, after a seek for instance, are prepared from here on
+    mPreparePool->Submit(customNode);
+    mLookaheadStats.mMisses++;
 
-        if ((f32)node.start > mTimeStep.GetTimestamp()) {
-            result = &node;
+    switch (mLookaheadSettings.mPolicy) {
+    case eNotReadyPolicy::Block: {
+        auto startTime = std::chrono::steady_clock::now();
+        if (mPreparePool->WaitUntilReady(*customNode, mLookaheadSettings.mBlockTimeoutMilliseconds) == false) {
+            LOG_WARNING_PRINTF("Node %d wasn't ready after %dms, playing it anyway", aNode->GetID(), mLookaheadSettings.mBlockTimeoutMilliseconds);
         }
-    });
+        std::chrono::duration<double, std::milli> blocked = std::chrono::steady_clock::now() - startTime;
+        mLookaheadStats.mBlockedMilliseconds += blocked.count();
+        return eActivation::Now;
+    }
+    case eNotReadyPolicy::Skip:
+        mLookaheadStats.mSkipped++;
+        return eActivation::Skip;
+    case eNotReadyPolicy::Delay:
+        mLookaheadStats.mDelayed++;
+        return eActivation::Delay;
+    }
+
+    return eActivation::Now;
+}
+
+void ImTimeline::TimelinePlayer::SetCheckpointSettings(const sCheckpointSettings& aSettings, std::shared_ptr<ITimelineCheckpointState> aState)
+{
+    bool bWasEnabled = mCheckpointSettings.mIntervalFrames > 0;
+
+    mCheckpointSettings = aSettings;
+    mCheckpointState = aState;
+    mCheckpointIntervalFrames = aSettings.mIntervalFrames;
+
+    if (aSettings.mIntervalFrames <= 0) {
+        mCheckpoints.clear();
+        mCheckpointBytes = 0;
+        return;
+    }
+
+    if (bWasEnabled) {
+        EnforceCheckpointBudget();
+        return;
+    }
+
+    // checkpoints only describe playback from the start, everything after frame 0 is replayed from the first one
+    Stop();
+    mCheckpoints.clear();
+    mCheckpointBytes = 0;
+    CaptureCheckpoint(0, true);
+}
+
+void ImTimeline::TimelinePlayer::ClearCheckpoints()
+{
+    mCheckpointIntervalFrames = mCheckpointSettings.mIntervalFrames;
+
+    if (mCheckpoints.empty()) {
+        return;
+    }
+
+    if (mCheckpoints.front().mbIsOrigin) {
+        mCheckpoints.resize(1);
+    } else {
+        mCheckpoints.clear();
+    }
+
+    mCheckpointBytes = mCheckpoints.empty() ? 0 : mCheckpoints.front().GetSize();
+}
 
-    return result;
-}
\ No newline at end of file
+ImTimeline::TimelinePlayer::sCheckpointStats ImTimeline::TimelinePlayer::GetCheckpointStats() const
+{
+    sCheckpointStats stats = mCheckpointStats;
+    stats.mCount = static_cast<s32>(mCheckpoints.size());
+    stats.mBytes = mCheckpointBytes;
+    stats.mIntervalFrames = mCheckpointIntervalFrames;
+    return stats;
+}
+
+// Restores the nearest checkpoint before aTimestamp and replays the rest, returns false if there is none
+bool ImTimeline::TimelinePlayer::SeekFromCheckpoint(s32 aTimestamp)
+{
+    ValidateCheckpoints();
+
+    auto itCheckpoint = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(), aTimestamp, [](s32 timestamp, const sCheckpoint& checkpoint) { return timestamp < checkpoint.mTimestamp; });
+    if (itCheckpoint == mCheckpoints.begin()) {
+        return false;
+    }
+    --itCheckpoint;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // the views are told the difference to what was active before, once the replay is done
+    std::vector<std::vector<NodeID>> activeBefore(mPlayers.size());
+    for (size_t i = 0; i < mPlayers.size(); ++i) {
+        mPlayers[i]->CollectActiveNodeIDs(activeBefore[i]);
+    }
+
+    const sCheckpoint& checkpoint = *itCheckpoint;
+    s32 checkpointTimestamp = checkpoint.mTimestamp;
+
+    if (mCheckpointState) {
+        mCheckpointState->RestoreCheckpoint(checkpoint.mUserState);
+    }
+
+    const s32* read = checkpoint.mPlayerState.data();
+    for (auto& player : mPlayers) {
+        if (checkpoint.mbIsOrigin) {
+            player->Setup(player->mTimelineData, checkpointTimestamp);
+            player->mState = eTimelineState::eState_Playing;
+        } else {
+            player->LoadCheckpoint(read, checkpointTimestamp);
+        }
+        player->mbIsReplaying = true;
+    }
+
+    ReplayTo(checkpointTimestamp, aTimestamp);
+
+    for (size_t i = 0; i < mPlayers.size(); ++i) {
+        auto& player = mPlayers[i];
+        player->mbIsReplaying = false;
+        player->mTimeStep.SetTimestamp(aTimestamp);
+        player->mLastEventTimestamp = aTimestamp;
+        player->mPrefetchCursor.mbIsValid = false;
+        if (player->mState != eTimelineState::eState_Finished || mState == eTimelineState::eState_Paused) {
+            player->mState = mState;
+        }
+        player->DispatchViewDiff(activeBefore[i]);
+    }
+
+    mTimeStep.SetTimestamp(aTimestamp);
+    mPlayCursor.mScrubCount++;
+    mScheduler.Reset(aTimestamp);
+    AnchorClock();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    mCheckpointStats.mLastReplayFrames = aTimestamp - checkpointTimestamp;
+    mCheckpointStats.mLastSeekMilliseconds = elapsed.count();
+    return true;
+}
+
+// Plays the children from aFrom to aTo through the scheduler, taking the checkpoints that are due on the way
+void ImTimeline::TimelinePlayer::ReplayTo(s32 aFrom, s32 aTo)
+{
+    mScheduler.Reset(aFrom);
+
+    s32 timestamp = aFrom;
+    while (timestamp < aTo) {
+        timestamp = std::min(aTo, timestamp + mCheckpointIntervalFrames);
+        mScheduler.AdvanceTo(timestamp);
+        CaptureCheckpointIfDue(timestamp);
+    }
+}
+
+void ImTimeline::TimelinePlayer::CaptureCheckpointIfDue(s32 aTimestamp)
+{
+    if (mCheckpointIntervalFrames <= 0 || mCheckpoints.empty()) {
+        return;
+    }
+
+    ValidateCheckpoints();
+
+    auto itCheckpoint = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(), aTimestamp, [](s32 timestamp, const sCheckpoint& checkpoint) { return timestamp < checkpoint.mTimestamp; });
+    if (itCheckpoint != mCheckpoints.begin() && aTimestamp - std::prev(itCheckpoint)->mTimestamp < mCheckpointIntervalFrames) {
+        return;
+    }
+
+    CaptureCheckpoint(aTimestamp);
+}
+
+void ImTimeline::TimelinePlayer::CaptureCheckpoint(s32 aTimestamp, bool bIsOrigin)
+{
+    sCheckpoint checkpoint;
+    checkpoint.mTimestamp = aTimestamp;
+    checkpoint.mbIsOrigin = bIsOrigin;
+
+    for (auto& player : mPlayers) {
+        checkpoint.mDataVersions.push_back(player->mTimelineData ? player->mTimelineData->get_version() : 0);
+        if (bIsOrigin == false) {
+            player->SaveCheckpoint(checkpoint.mPlayerState);
+        }
+    }
+
+    if (mCheckpointState) {
+        mCheckpointState->SaveCheckpoint(checkpoint.mUserState);
+    }
+
+    mCheckpointBytes += checkpoint.GetSize();
+
+    auto itInsert = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(), aTimestamp, [](s32 timestamp, const sCheckpoint& other) { return timestamp < other.mTimestamp; });
+    mCheckpoints.insert(itInsert, std::move(checkpoint));
+
+    EnforceCheckpointBudget();
+}
+
+// Any edit of a section makes every checkpoint after frame 0 stale, the one at frame 0 doesn't depend on the nodes
+void ImTimeline::TimelinePlayer::ValidateCheckpoints()
+{
+    if (mCheckpoints.empty()) {
+        return;
+    }
+
+    const sCheckpoint& latest = mCheckpoints.back();
+    bool bIsValid = latest.mDataVersions.size() == mPlayers.size();
+
+    for (size_t i = 0; bIsValid && i < mPlayers.size(); ++i) {
+        bIsValid = latest.mbIsOrigin || latest.mDataVersions[i] == (mPlayers[i]->mTimelineData ? mPlayers[i]->mTimelineData->get_version() : 0);
+    }
+
+    if (bIsValid == false) {
+        ClearCheckpoints();
+    }
+}
+
+// Thins the checkpoints out to twice the interval until they fit, the seek cost grows with the interval, not the timeline
+void ImTimeline::TimelinePlayer::EnforceCheckpointBudget()
+{
+    while (mCheckpointBytes > mCheckpointSettings.mMemoryBudgetBytes && mCheckpoints.size() > 2) {
+        mCheckpointIntervalFrames *= 2;
+
+        size_t write = 1;
+        mCheckpointBytes = mCheckpoints.front().GetSize();
+        for (size_t read = 1; read < mCheckpoints.size(); ++read) {
+            if (mCheckpoints[read].mTimestamp - mCheckpoints[write - 1].mTimestamp < mCheckpointIntervalFrames) {
+                continue;
+            }
+            mCheckpointBytes += mCheckpoints[read].GetSize();
+            if (write != read) {
+                mCheckpoints[write] = std::move(mCheckpoints[read]);
+            }
+            write++;
+        }
+        mCheckpoints.resize(write);
+
+        LOG_INFO_PRINTF("Checkpoint budget reached, interval is now %d frames", mCheckpointIntervalFrames);
+    }
+}
+
+// Child layout: finished, cursor index (-1 when it has to be sought again), playing node, its state, delayed flag,
+// then the active and the delayed nodes as (ID, end) pairs
+void ImTimeline::TimelinePlayer::SaveCheckpoint(std::vector<s32>& outState)
+{
+    bool bCursorIsValid = mTimelineData != nullptr && mPlayCursor.mbIsValid && mPlayCursor.mDataVersion == mTimelineData->get_version();
+
+    outState.push_back(mState == eTimelineState::eState_Finished ? 1 : 0);
+    outState.push_back(bCursorIsValid ? static_cast<s32>(mPlayCursor.mIndex) : -1);
+    RefreshPlayingNode();
+    outState.push_back(mPlayingNode != nullptr ? mPlayingNodeProperties.mID : InvalidNodeID);
+    outState.push_back(static_cast<s32>(mPlayingNodeProperties.mState));
+    outState.push_back(mPlayingNodeProperties.mbIsDelayed ? 1 : 0);
+
+    for (const std::vector<sActiveNode>* nodes : { &mActiveNodes, &mDelayedNodes }) {
+        outState.push_back(static_cast<s32>(nodes->size()));
+        for (const sActiveNode& active : *nodes) {
+            outState.push_back(active.mID);
+            outState.push_back(active.mEnd);
+        }
+    }
+}
+
+void ImTimeline::TimelinePlayer::LoadCheckpoint(const s32*& aRead, s32 aTimestamp)
+{
+    auto findNode = [this](NodeID nodeID) -> TimelineNode* {
+        if (nodeID == InvalidNodeID || mTimelineData == nullptr) {
+            return nullptr;
+        }
+        NodeInitDescriptor descriptor;
+        descriptor.ID = nodeID;
+        return mTimelineData->get_node_id(descriptor);
+    };
+
+    bool bIsFinished = *aRead++ != 0;
+    s32 cursorIndex = *aRead++;
+    SetPlayingNode(findNode(*aRead++));
+    mPlayingNodeProperties.mState = static_cast<ePlayingNodeState>(*aRead++);
+    mPlayingNodeProperties.mbIsDelayed = *aRead++ != 0;
+
+    for (std::vector<sActiveNode>* nodes : { &mActiveNodes, &mDelayedNodes }) {
+        nodes->clear();
+        s32 count = *aRead++;
+        for (s32 i = 0; i < count; ++i) {
+            sActiveNode active;
+            active.mID = *aRead++;
+            active.mEnd = *aRead++;
+            active.mNode = findNode(active.mID);
+            if (active.mNode != nullptr) {
+                nodes->push_back(active);
+            }
+        }
+    }
+    std::make_heap(mActiveNodes.begin(), mActiveNodes.end(), sActiveNode::EndsLater);
+
+    mTimeStep.SetTimestamp(aTimestamp);
+    mLastEventTimestamp = aTimestamp;
+    mPlayCursor.mIndex = cursorIndex >= 0 ? static_cast<size_t>(cursorIndex) : 0;
+    mPlayCursor.mbIsValid = cursorIndex >= 0;
+    mPlayCursor.mDataVersion = mTimelineData != nullptr ? mTimelineData->get_version() : 0;
+    mPrefetchCursor.mbIsValid = false;
+    mPendingEvents.clear();
+    mState = bIsFinished ? eTimelineState::eState_Finished : eTimelineState::eState_Playing;
+}
+
+void ImTimeline::TimelinePlayer::CollectActiveNodeIDs(std::vector<NodeID>& outIDs)
+{
+    outIDs.clear();
+
+    if (mPlayMode == ePlayMode::Concurrent) {
+        for (const sActiveNode& active : mActiveNodes) {
+            outIDs.push_back(active.mID);
+        }
+    } else {
+        RefreshPlayingNode();
+        if (mPlayingNode != nullptr && mPlayingNodeProperties.mState == ePlayingNodeState::IsPlayed) {
+            outIDs.push_back(mPlayingNodeProperties.mID);
+        }
+    }
+}
+
+// View events for the nodes that became active or inactive across a replay, the custom nodes got theirs during it
+void ImTimeline::TimelinePlayer::DispatchViewDiff(const std::vector<NodeID>& aActiveBefore)
+{
+    if (mPlayerView == nullptr || mTimelineData == nullptr) {
+        return;
+    }
+
+    std::vector<NodeID> activeAfter;
+    CollectActiveNodeIDs(activeAfter);
+
+    std::unordered_set<NodeID> before(aActiveBefore.begin(), aActiveBefore.end());
+    std::unordered_set<NodeID> after(activeAfter.begin(), activeAfter.end());
+    std::vector<sNodePlayEvent> events;
+
+    auto pushEvent = [&](NodeID nodeID, eNodePlayEventType type) {
+        NodeInitDescriptor descriptor;
+        descriptor.ID = nodeID;
+
+        sNodePlayEvent event;
+        event.mNode = mTimelineData->get_node_id(descriptor);
+        event.mType = type;
+        FillPlayProperties(event.mProperties, GetCurrentTimestamp(), GetCurrentTimestamp());
+        if (event.mNode != nullptr) {
+            events.push_back(event);
+        }
+    };
+
+    for (NodeID nodeID : aActiveBefore) {
+        if (after.count(nodeID) == 0) {
+            pushEvent(nodeID, eNodePlayEventType::Deactivate);
+        }
+    }
+    for (NodeID nodeID : activeAfter) {
+        if (before.count(nodeID) == 0) {
+            pushEvent(nodeID, eNodePlayEventType::Activate);
+        }
+    }
+
+    if (events.empty() == false) {
+        mPlayerView->OnNodeEvents(events.data(), events.size());
+    }
+}
+
+// Plays [aFrom, aTo] with a fixed step per update and no ImGui calls, as fast as the callbacks allow.
+// Child players are simulated through the regular Update, so they see the same frames as during interactive playback.
+ImTimeline::TimelinePlayer::sSimulationStats ImTimeline::TimelinePlayer::SimulateRange(s32 aFrom, s32 aTo, s32 aStep)
+{
+    sSimulationStats stats;
+    stats.mFromFrame = aFrom;
+    stats.mToFrame = aFrom;
+
+    if (aStep <= 0 || aTo < aFrom) {
+        LOG_WARNING_PRINTF("SimulateRange: invalid range %d - %d, step %d", aFrom, aTo, aStep);
+        return stats;
+    }
+
+    sTimeStepSettings previousSettings = mTimeStep.GetSettings();
+    size_t previousEventCount = GetEventCount();
+
+    ChangeState(eTimelineState::eState_Paused);
+    SetStartTimestamp(aFrom);
+
+    sTimeStepSettings settings = previousSettings;
+    settings.mFixedFramesPerUpdate = aStep;
+    SetTimeStepSettings(settings);
+
+    Play();
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    while (mState == eTimelineState::eState_Playing && GetCurrentTimestamp() < aTo) {
+        // the last step stops exactly on aTo
+        if (GetCurrentTimestamp() + settings.mFixedFramesPerUpdate > aTo) {
+            settings.mFixedFramesPerUpdate = aTo - GetCurrentTimestamp();
+            SetTimeStepSettings(settings);
+        }
+
+        Update(0.0f);
+        stats.mUpdateCount++;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    SetTimeStepSettings(previousSettings);
+    if (mState == eTimelineState::eState_Playing) {
+        ChangeState(eTimelineState::eState_Paused);
+    }
+
+    stats.mToFrame = GetCurrentTimestamp();
+    stats.mEventCount = GetEventCount() - previousEventCount;
+    stats.mSeconds = elapsed.count();
+
+    LOG_INFO_PRINTF("Simulated frames %d - %d: %d events in %.3fs (%.0f events/s)", stats.mFromFrame, stats.mToFrame, static_cast<s32>(stats.mEventCount), stats.mSeconds,
+        stats.GetEventsPerSecond());
+
+    return stats;
+}
+
+size_t ImTimeline::TimelinePlayer::GetEventCount() const
+{
+    size_t eventCount = mEventCount;
+
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        eventCount += player->GetEventCount();
+    }
+
+    return eventCount;
+}
+
+void ImTimeline::TimelinePlayer::DrawPlayer()
+{
+    if (mPlayerView) {
+        mPlayerView->Draw();
+    } else {
+        ImGui::Text("No Player View Attached:");
+    }
+}
+
+void ImTimeline::TimelinePlayer::OnDebugGUI()
+{
+    if (ImGui::TreeNodeEx("Debug State")) {
+        ImGui::Text("IsInitialized: %d", mbIsInitialized);
+        ImGui::Text("TimelinePlayer Count: %d", (s32)mPlayers.size());
+        ImGui::Text("IsRootTimeline: %d", IsRootTimeline());
+        ImGui::Dummy(ImVec2(0.0f, 6.0f));
+        ImGui::Text("Play State:");
+        ImGui::Text("- IsNoneState: %d", mState == eTimelineState::eState_None);
+        ImGui::Text("- IsStopped: %d", mState == eTimelineState::eState_Stopped);
+        ImGui::Text("- IsPaused: %d", mState == eTimelineState::eState_Paused);
+        ImGui::Text("- IsPlaying: %d", mState == eTimelineState::eState_Playing);
+        ImGui::Text("- IsFinished: %d", mState == eTimelineState::eState_Finished);
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNodeEx("Debug Play UI")) {
+        if (mPlayingNode != nullptr) {
+            ImGui::Text("Playing Node: %d", mPlayingNodeProperties.mID);
+        }
+
+        bool bConcurrent = mPlayMode == ePlayMode::Concurrent;
+        if (mState != eTimelineState::eState_Playing && ImGui::Checkbox("Play overlapping nodes concurrently", &bConcurrent)) {
+            SetPlayMode(bConcurrent ? ePlayMode::Concurrent : ePlayMode::Sequential);
+        }
+
+        if (mState == eTimelineState::eState_None || mState == eTimelineState::eState_Stopped) {
+            if (ImGui::Button("Play from start")) {
+                Play();
+            }
+        }
+
+        if (mState == eTimelineState::eState_Playing && ImGui::Button("Stop")) {
+            Stop();
+        }
+
+        if (mState == eTimelineState::eState_Playing && ImGui::Button("Pause")) {
+            Pause();
+        }
+
+        if (mState == eTimelineState::eState_Paused && ImGui::Button("Play from current frame")) {
+            Play();
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNodeEx("Time Step")) {
+        sTimeStepSettings settings = mTimeStep.GetSettings();
+        bool bChanged = false;
+
+        bChanged |= ImGui::DragFloat("Frames per second", &settings.mFramesPerSecond, 0.1f, 0.0f, 10000.0f);
+        bChanged |= ImGui::DragFloat("Playback speed", &settings.mPlaybackSpeed, 0.01f, 0.0f, 100.0f);
+        bChanged |= ImGui::DragInt("Fixed frames per update (0 = off)", &settings.mFixedFramesPerUpdate, 1.0f, 0, 10000);
+
+        if (bChanged) {
+            SetTimeStepSettings(settings);
+        }
+
+        s32 loop[2] = { mLoopRange.mStart, mLoopRange.mEnd };
+        if (ImGui::DragInt2("Loop start/end (end <= start = off)", loop, 1.0f, 0, 1000000)) {
+            mLoopRange.mStart = loop[0];
+            mLoopRange.mEnd = loop[1];
+        }
+        ImGui::Text("Loops: %d", mLoopCount);
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNodeEx("Lookahead")) {
+        sLookaheadSettings settings = mLookaheadSettings;
+        bool bChanged = false;
+
+        static const char* policyNames[] = { "Block", "Skip", "Delay" };
+        s32 policy = static_cast<s32>(settings.mPolicy);
+
+        bChanged |= ImGui::DragInt("Lookahead frames (0 = off)", &settings.mFrames, 1.0f, 0, 100000);
+        bChanged |= ImGui::DragInt("Worker threads", &settings.mWorkerCount, 0.1f, 0, 16);
+        bChanged |= ImGui::Combo("Not ready policy", &policy, policyNames, IM_ARRAYSIZE(policyNames));
+        bChanged |= ImGui::DragInt("Block timeout (ms)", &settings.mBlockTimeoutMilliseconds, 1.0f, 0, 10000);
+
+        if (bChanged) {
+            settings.mPolicy = static_cast<eNotReadyPolicy>(policy);
+            SetLookaheadSettings(settings);
+        }
+
+        sLookaheadStats stats = GetLookaheadStats();
+        ImGui::Text("Prefetch hit rate: %.1f%% (%d hits, %d misses)", stats.GetHitRate() * 100.0f, static_cast<s32>(stats.mHits), static_cast<s32>(stats.mMisses));
+        ImGui::Text("Submitted: %d Skipped: %d Delayed: %d Blocked: %.2fms", static_cast<s32>(stats.mSubmitted), static_cast<s32>(stats.mSkipped), static_cast<s32>(stats.mDelayed),
+            stats.mBlockedMilliseconds);
+        if (mPreparePool) {
+            ImGui::Text("Queued: %d", static_cast<s32>(mPreparePool->GetQueuedCount()));
+        }
+        ImGui::TreePop();
+    }
+
+    if (mPlayers.empty() == false && ImGui::TreeNodeEx("Checkpoints")) {
+        sCheckpointSettings settings = mCheckpointSettings;
+        s32 budgetMegabytes = static_cast<s32>(settings.mMemoryBudgetBytes / (1024 * 1024));
+        bool bChanged = false;
+
+        bChanged |= ImGui::DragInt("Checkpoint interval (0 = off)", &settings.mIntervalFrames, 1.0f, 0, 100000);
+        bChanged |= ImGui::DragInt("Memory budget (MB)", &budgetMegabytes, 1.0f, 1, 4096);
+
+        if (bChanged) {
+            settings.mMemoryBudgetBytes = static_cast<size_t>(ImMax(budgetMegabytes, 1)) * 1024 * 1024;
+            SetCheckpointSettings(settings, mCheckpointState);
+        }
+
+        sCheckpointStats stats = GetCheckpointStats();
+        ImGui::Text("Checkpoints: %d (%.2f MB) every %d frames", stats.mCount, stats.mBytes / (1024.0 * 1024.0), stats.mIntervalFrames);
+        ImGui::Text("Last seek: %d frames replayed in %.3fms", stats.mLastReplayFrames, stats.mLastSeekMilliseconds);
+        ImGui::TreePop();
+    }
+
+    if (mClockSync.HasSource() && ImGui::TreeNodeEx("Clock")) {
+        sClockSyncSettings settings = mClockSync.GetSettings();
+        bool bChanged = false;
+
+        bChanged |= ImGui::SliderFloat("Correction rate", &settings.mCorrectionRate, 0.0f, 1.0f);
+        bChanged |= ImGui::DragFloat("Max drift (frames)", &settings.mMaxDriftFrames, 0.1f, 0.0f, 1000.0f);
+
+        if (bChanged) {
+            SetClockSource(mClockSync.GetSource(), settings);
+        }
+
+        ImGui::Text("Clock: %lld ticks (%.0f/s) at frame %.3f", static_cast<long long>(mClockSync.GetSource()->GetTicks()), mClockSync.GetSource()->GetTicksPerSecond(),
+            mClockSync.GetClockPosition());
+        ImGui::Text("Drift: %.3f frames (peak %.3f), resyncs: %d", mClockSync.GetLastDriftFrames(), mClockSync.GetPeakDriftFrames(), mClockSync.GetResyncCount());
+        ImGui::TreePop();
+    }
+
+    ImGui::Text("Current Frame: %d (%.2f)", GetCurrentTimestamp(), mTimeStep.GetTimestamp());
+
+    if (mTimelineData != nullptr) {
+        ImGui::Text("Play Cursor: %d (seeks: %d, steps: %d, scrubs: %d)", static_cast<s32>(mPlayCursor.mIndex), mPlayCursor.mSeekCount, mPlayCursor.mStepCount, mPlayCursor.mScrubCount);
+    }
+
+    if (mPlayMode == ePlayMode::Concurrent && mTimelineData != nullptr) {
+        ImGui::Text("Active Nodes: %d Last Event Batch: %d", static_cast<s32>(mActiveNodes.size()), mLastEventBatchSize);
+    }
+
+    if (mPlayingNode != nullptr) {
+        ImGui::Text("Current/Next Playing Node: %d", mPlayingNodeProperties.mID);
+    }
+    ImGui::Text("Child Players: %d", static_cast<s32>(mPlayers.size()));
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        ImGui::Text("Child Player: %d Frame: %d Cursor: %d (seeks: %d, steps: %d)", player->mUniqueID, player->GetCurrentTimestamp(), static_cast<s32>(player->mPlayCursor.mIndex),
+            player->mPlayCursor.mSeekCount, player->mPlayCursor.mStepCount);
+    }
+}
+
+void ImTimeline::TimelinePlayer::OnDebugGUIPerformance()
+{
+    ImGui::Text("Events dispatched: %d", static_cast<s32>(GetEventCount()));
+
+    if (mPlayers.empty() == false) {
+        mScheduler.OnDebugGUIPerformance();
+    }
+}
+
+void ImTimeline::TimelinePlayer::ChangeState(eTimelineState aState)
+{
+    // check for transitions that are impossible
+    //...
+
+    for (auto ptr_player : mPlayers) {
+        auto player = ptr_player;
+
+        if (player == nullptr)
+            continue;
+
+        player->ChangeState(aState);
+    }
+
+    if (aState != eTimelineState::eState_Playing && mParent != nullptr) {
+        auto& soloPlayers = mParent->mSoloPlayers;
+        soloPlayers.erase(std::remove(soloPlayers.begin(), soloPlayers.end(), this), soloPlayers.end());
+    }
+
+    mState = aState;
+}
+
+void ImTimeline::TimelinePlayer::UpdateSoloPlayers(f32 aDeltaTime)
+{
+    // backwards, a player that stops itself while updating only moves the ones already updated
+    for (size_t i = mSoloPlayers.size(); i > 0; --i) {
+        if (i <= mSoloPlayers.size()) {
+            mSoloPlayers[i - 1]->Update(aDeltaTime);
+        }
+    }
+
+    // finished players don't go through ChangeState
+    mSoloPlayers.erase(std::remove_if(mSoloPlayers.begin(), mSoloPlayers.end(), [](TimelinePlayer* player) { return player->IsPlaying() == false; }),
+        mSoloPlayers.end());
+}
+
+TimelineNode* ImTimeline::TimelinePlayer::GetNextNodeToPlay()
+{
+    // starts are whole frames, so "starts after the timestamp" is the same as starting after its floor
+    s32 timestamp = mTimeStep.GetFrame();
+
+    // while playing the cursor only moves forward, it's sought again after a jump or once the section changed
+    if (mPlayCursor.mbIsValid == false || mPlayCursor.mDataVersion != mTimelineData->get_version()) {
+        mPlayCursor.mIndex = mTimelineData->find_first_after(timestamp);
+        mPlayCursor.mDataVersion = mTimelineData->get_version();
+        mPlayCursor.mbIsValid = true;
+        mPlayCursor.mSeekCount++;
+    }
+
+    size_t nodeCount = mTimelineData->node_count();
+    while (mPlayCursor.mIndex < nodeCount) {
+        TimelineNode* node = mTimelineData->get_node_at(mPlayCursor.mIndex);
+        mPlayCursor.mIndex++;
+        mPlayCursor.mStepCount++;
+
+        if (node->start > timestamp && (mPlayingNode == nullptr || mPlayingNodeProperties.mID != node->GetID())) {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+/* CONCURRENT PLAYBACK */
+
+void ImTimeline::TimelinePlayer::UpdateConcurrent()
+{
+    s32 timestamp = mTimeStep.GetFrame();
+
+    if (mPlayCursor.mbIsValid == false) {
+        SeekActiveNodes(timestamp);
+    } else if (mPlayCursor.mDataVersion != mTimelineData->get_version()) {
+        ReconcileActiveNodes(mLastEventTimestamp);
+    }
+
+    if (timestamp > mLastEventTimestamp) {
+        CollectNodeEvents(timestamp);
+        mLastEventTimestamp = timestamp;
+    }
+
+    ActivateDelayedNodes(timestamp);
+    DispatchNodeEvents();
+
+    if (mPlayCursor.mIndex >= mTimelineData->node_count() && mActiveNodes.empty() && mDelayedNodes.empty() && IsLoopPending() == false) {
+        mState = eTimelineState::eState_Finished;
+    }
+}
+
+// Diffs the active nodes against the nodes under aTimestamp, a single stabbing query whatever the distance jumped
+void ImTimeline::TimelinePlayer::SeekActiveNodes(s32 aTimestamp)
+{
+    ReconcileActiveNodes(aTimestamp);
+    mLastEventTimestamp = aTimestamp;
+}
+
+// Sequential mode plays the node under aTimestamp that started first, the next one is picked after it ended
+void ImTimeline::TimelinePlayer::SeekPlayingNode(s32 aTimestamp)
+{
+    RefreshPlayingNode();
+
+    TimelineNode* covering = nullptr;
+    mTimelineData->for_each_in_range(aTimestamp, aTimestamp, [&](TimelineNode& node) {
+        if (node.start > aTimestamp || node.end <= aTimestamp) {
+            return;
+        }
+        if (covering == nullptr || node.start < covering->start) {
+            covering = &node;
+        }
+    });
+
+    bool bWasPlayed = mPlayingNode != nullptr && mPlayingNodeProperties.mState == ePlayingNodeState::IsPlayed;
+    mPlayCursor.mbIsValid = false;
+
+    if (bWasPlayed && mPlayingNode == covering) {
+        return;
+    }
+
+    if (bWasPlayed) {
+        PushNodeEvent(mPlayingNode, eNodePlayEventType::Deactivate, aTimestamp);
+    }
+
+    SetPlayingNode(covering);
+    mPlayingNodeProperties.mState = ePlayingNodeState::None;
+    mPlayingNodeProperties.mbIsDelayed = false;
+
+    if (mPlayingNode == nullptr) {
+        return;
+    }
+
+    eActivation activation = PrepareActivation(mPlayingNode, false);
+    if (activation == eActivation::Now) {
+        PushNodeEvent(mPlayingNode, eNodePlayEventType::Activate, aTimestamp);
+        mPlayingNodeProperties.mState = ePlayingNodeState::IsPlayed;
+    } else if (activation == eActivation::Delay) {
+        mPlayingNodeProperties.mbIsDelayed = true;
+    } else {
+        SetPlayingNode(nullptr);
+    }
+}
+
+// Active node pointers are only valid for the data version they were taken from, after edits they're looked up again.
+// Nodes that were deleted in the meantime are dropped without an event, there is nothing left to send it for.
+void ImTimeline::TimelinePlayer::RefreshActiveNodes()
+{
+    if (mPlayCursor.mDataVersion == mTimelineData->get_version()) {
+        return;
+    }
+
+    auto refresh = [this](std::vector<sActiveNode>& nodes) {
+        size_t write = 0;
+        for (size_t read = 0; read < nodes.size(); ++read) {
+            sActiveNode active = nodes[read];
+
+            NodeInitDescriptor descriptor;
+            descriptor.ID = active.mID;
+            active.mNode = active.mID != InvalidNodeID ? mTimelineData->get_node_id(descriptor) : nullptr;
+
+            if (active.mNode != nullptr) {
+                nodes[write++] = active;
+            }
+        }
+        nodes.resize(write);
+    };
+
+    refresh(mActiveNodes);
+    refresh(mDelayedNodes);
+}
+
+void ImTimeline::TimelinePlayer::SetPlayingNode(TimelineNode* aNode)
+{
+    mPlayingNode = aNode;
+    mPlayingNodeProperties.mID = aNode != nullptr ? aNode->GetID() : InvalidNodeID;
+    mPlayingNodeProperties.mDataVersion = mTimelineData != nullptr ? mTimelineData->get_version() : 0;
+}
+
+// Same as RefreshActiveNodes for the sequential playing node, deleting it frees the memory mPlayingNode points to
+void ImTimeline::TimelinePlayer::RefreshPlayingNode()
+{
+    if (mPlayingNode == nullptr || mTimelineData == nullptr || mPlayingNodeProperties.mDataVersion == mTimelineData->get_version()) {
+        return;
+    }
+
+    NodeInitDescriptor descriptor;
+    descriptor.ID = mPlayingNodeProperties.mID;
+    TimelineNode* node = mPlayingNodeProperties.mID != InvalidNodeID ? mTimelineData->get_node_id(descriptor) : nullptr;
+    SetPlayingNode(node);
+
+    if (node == nullptr) {
+        mPlayingNodeProperties.mState = ePlayingNodeState::None;
+        mPlayingNodeProperties.mbIsDelayed = false;
+    }
+}
+
+// Brings the active set in line with the section at aTimestamp after nodes were added, deleted or moved.
+// Active nodes that are no longer under the playhead end, nodes that moved under it start.
+void ImTimeline::TimelinePlayer::ReconcileActiveNodes(s32 aTimestamp)
+{
+    RefreshActiveNodes();
+
+    std::unordered_set<NodeID> activeIDs;
+    size_t write = 0;
+
+    for (size_t read = 0; read < mActiveNodes.size(); ++read) {
+        sActiveNode active = mActiveNodes[read];
+
+        if (active.mNode->start > aTimestamp || active.mNode->end <= aTimestamp) {
+            PushNodeEvent(active.mNode, eNodePlayEventType::Deactivate, aTimestamp);
+            continue;
+        }
+
+        active.mEnd = active.mNode->end;
+        activeIDs.insert(active.mID);
+        mActiveNodes[write++] = active;
+    }
+    mActiveNodes.resize(write);
+
+    // delayed nodes moved away from the playhead are picked up by the cursor again, if at all
+    mDelayedNodes.erase(std::remove_if(mDelayedNodes.begin(), mDelayedNodes.end(),
+                            [aTimestamp](const sActiveNode& delayed) { return delayed.mNode->start > aTimestamp || delayed.mNode->end <= aTimestamp; }),
+        mDelayedNodes.end());
+
+    for (const sActiveNode& delayed : mDelayedNodes) {
+        activeIDs.insert(delayed.mID);
+    }
+
+    mTimelineData->for_each_in_range(aTimestamp, aTimestamp, [&](TimelineNode& node) {
+        if (node.start > aTimestamp || node.end <= aTimestamp || activeIDs.count(node.GetID()) > 0) {
+            return;
+        }
+
+        sActiveNode active;
+        active.mEnd = node.end;
+        active.mID = node.GetID();
+        active.mNode = &node;
+
+        eActivation activation = PrepareActivation(&node, false);
+        if (activation == eActivation::Delay) {
+            mDelayedNodes.push_back(active);
+        }
+        if (activation != eActivation::Now) {
+            return;
+        }
+
+        PushNodeEvent(&node, eNodePlayEventType::Activate, aTimestamp);
+        mActiveNodes.push_back(active);
+    });
+
+    std::make_heap(mActiveNodes.begin(), mActiveNodes.end(), sActiveNode::EndsLater);
+
+    mPlayCursor.mIndex = mTimelineData->find_first_after(aTimestamp);
+    mPlayCursor.mDataVersion = mTimelineData->get_version();
+    mPlayCursor.mbIsValid = true;
+    mPlayCursor.mSeekCount++;
+}
+
+// Merges the nodes starting in (mLastEventTimestamp, aTimestamp] with the active nodes ending in it, so events come out
+// ordered by time. Only nodes that actually start or end are touched, however far the player jumped.
+void ImTimeline::TimelinePlayer::CollectNodeEvents(s32 aTimestamp)
+{
+    auto byEnd = sActiveNode::EndsLater;
+    size_t nodeCount = mTimelineData->node_count();
+
+    auto nextStarting = [&]() -> TimelineNode* {
+        if (mPlayCursor.mIndex >= nodeCount) {
+            return nullptr;
+        }
+        TimelineNode* node = mTimelineData->get_node_at(mPlayCursor.mIndex);
+        return node->start <= aTimestamp ? node : nullptr;
+    };
+
+    TimelineNode* starting = nextStarting();
+
+    while (true) {
+        bool bHasEnding = mActiveNodes.empty() == false && mActiveNodes.front().mEnd <= aTimestamp;
+
+        if (bHasEnding == false && starting == nullptr) {
+            break;
+        }
+
+        // at equal timestamps nodes end before the next ones start
+        if (bHasEnding && (starting == nullptr || mActiveNodes.front().mEnd <= starting->start)) {
+            std::pop_heap(mActiveNodes.begin(), mActiveNodes.end(), byEnd);
+            const sActiveNode& ending = mActiveNodes.back();
+            PushNodeEvent(ending.mNode, eNodePlayEventType::Deactivate, ending.mEnd);
+            mActiveNodes.pop_back();
+            continue;
+        }
+
+        sActiveNode active;
+        active.mEnd = starting->end;
+        active.mID = starting->GetID();
+        active.mNode = starting;
+
+        eActivation activation = PrepareActivation(starting, false);
+        if (activation == eActivation::Now) {
+            PushNodeEvent(starting, eNodePlayEventType::Activate, starting->start);
+            mActiveNodes.push_back(active);
+            std::push_heap(mActiveNodes.begin(), mActiveNodes.end(), byEnd);
+        } else if (activation == eActivation::Delay && starting->end > aTimestamp) {
+            mDelayedNodes.push_back(active);
+        }
+
+        mPlayCursor.mIndex++;
+        mPlayCursor.mStepCount++;
+        starting = nextStarting();
+    }
+}
+
+// Delayed nodes start at the first frame they're ready on, the ones that ended in the meantime aren't played at all
+void ImTimeline::TimelinePlayer::ActivateDelayedNodes(s32 aTimestamp)
+{
+    if (mDelayedNodes.empty()) {
+        return;
+    }
+
+    auto byEnd = sActiveNode::EndsLater;
+    size_t write = 0;
+
+    for (size_t read = 0; read < mDelayedNodes.size(); ++read) {
+        sActiveNode delayed = mDelayedNodes[read];
+
+        if (delayed.mNode->end <= aTimestamp) {
+            continue;
+        }
+
+        if (mPreparePool == nullptr || mPreparePool->IsReady(*delayed.mNode->GetCustomNode())) {
+            PushNodeEvent(delayed.mNode, eNodePlayEventType::Activate, aTimestamp);
+            delayed.mEnd = delayed.mNode->end;
+            mActiveNodes.push_back(delayed);
+            std::push_heap(mActiveNodes.begin(), mActiveNodes.end(), byEnd);
+            continue;
+        }
+
+        mDelayedNodes[write++] = delayed;
+    }
+    mDelayedNodes.resize(write);
+}
+
+void ImTimeline::TimelinePlayer::FillPlayProperties(sNodePlayProperties& outProperties, s32 aTimestamp, s32 aEventFrame)
+{
+    outProperties.mTimestamp = aTimestamp;
+    outProperties.mPlayerTimestamp = mTimeStep.GetTimestamp();
+    outProperties.mClockTicks = mClockSync.GetTicksAtFrame(aEventFrame);
+}
+
+void ImTimeline::TimelinePlayer::PushNodeEvent(TimelineNode* aNode, eNodePlayEventType aType, s32 aTimestamp)
+{
+    sNodePlayEvent event;
+    event.mNode = aNode;
+    event.mType = aType;
+    FillPlayProperties(event.mProperties, aTimestamp, aTimestamp);
+    mPendingEvents.push_back(event);
+
+    // the next pass prepares the node again
+    if (aType == eNodePlayEventType::Deactivate && mPreparePool && aNode->GetCustomNode()) {
+        mPreparePool->Release(*aNode->GetCustomNode());
+    }
+}
+
+void ImTimeline::TimelinePlayer::DispatchNodeEvents()
+{
+    mLastEventBatchSize = static_cast<s32>(mPendingEvents.size());
+    if (mPendingEvents.empty()) {
+        return;
+    }
+    mEventCount += mPendingEvents.size();
+
+    for (const sNodePlayEvent& event : mPendingEvents) {
+        if (event.mNode->GetCustomNode() == nullptr) {
+            continue;
+        }
+
+        if (event.mType == eNodePlayEventType::Activate) {
+            event.mNode->GetCustomNode()->OnNodeActivate();
+        } else {
+            event.mNode->GetCustomNode()->OnNodeDeactivate();
+        }
+    }
+
+    if (mPlayerView && mbIsReplaying == false) {
+        mPlayerView->OnNodeEvents(mPendingEvents.data(), mPendingEvents.size());
+    }
+
+    mPendingEvents.clear();
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "TimelineTimeStep.h"
+#include "TimelineScheduler.h"
+#include "TimelinePreparePool.h"
+#include "TimelineCheckpoint.h"
 #include "../Core/ImTimelineUtility.h"
 #include "../Core/IDGeneratorUtility.h"
 #include "TimelineDefines.h"
@@ -26,6 +29,12 @@ namespace ImTimeline
          eState_Max,
       };
 
+      enum class ePlayMode
+      {
+         Sequential, // one node at a time, the next one is picked once the current one ends
+         Concurrent, // every node under the playhead is active, overlapping and skipped-over nodes included
+      };
+
       TimelinePlayer();
       TimelinePlayer(const TimelinePlayer &) = delete;
       TimelinePlayer(TimelinePlayer &&) = delete;
@@ -37,18 +46,105 @@ namespace ImTimeline
       bool IsSetup() const { return mbIsInitialized;}
       bool IsRootTimeline() const;
 
-      void AddPlayer(std::shared_ptr<TimelinePlayer> aPlayer) { mPlayers.push_back(aPlayer); }
+      void AddPlayer(std::shared_ptr<TimelinePlayer> aPlayer) { aPlayer->mParent = this; mPlayers.push_back(aPlayer); mScheduler.AddPlayer(aPlayer.get()); }
+      void RemovePlayer(TimelinePlayer* aPlayer);
+      const std::vector<std::shared_ptr<TimelinePlayer>>& GetPlayers() const { return mPlayers; }
+
+      // Children played on their own while this player isn't playing. They join on Play and leave on Stop, Pause or
+      // once they finish, so only they are ticked here instead of every child.
+      void UpdateSoloPlayers(f32 aDeltaTime);
+      const std::vector<TimelinePlayer*>& GetSoloPlayers() const { return mSoloPlayers; }
       void SetViewUI(std::shared_ptr<ITimelinePlayerView> newView);
       std::shared_ptr<ITimelinePlayerView> GetViewUI() { return mPlayerView; }
 
       void Update(f32 aDeltaTime);
+
+      // Child players are driven by the scheduler of their root: woken at the frame GetNextEventTimestamp returned.
+      // Edits to a child's section while playing have to go through Reschedule, so it's woken at the right frame.
+      void AdvanceTo(s32 aTimestamp);
+      s32 GetNextEventTimestamp();
+      void Reschedule(TimelinePlayer* aChild) { mScheduler.MarkDirty(aChild); }
       
       void Play();
       void Pause();
       void Stop();
 
       bool IsPlaying() { return mState == eState_Playing; };
+      void SetPlayMode(ePlayMode aMode);
+      ePlayMode GetPlayMode() const { return mPlayMode; }
       void SetStartTimestamp(s32 aStartTimestamp);
+      // Moves the playhead for scrubbing, while playing or not. The nodes under aTimestamp become active in every section:
+      // nodes that stay under the playhead keep playing, the others get their deactivation and the new ones their activation.
+      void Seek(s32 aTimestamp);
+
+      // frame rate, playback speed and fixed stepping, applied to the child players too
+      void SetTimeStepSettings(const sTimeStepSettings& aSettings);
+      const sTimeStepSettings& GetTimeStepSettings() const { return mTimeStep.GetSettings(); }
+
+      // Applied by the player Update is called on: once the playhead crosses the end, the frames up to it are played and
+      // it seeks back to the start, carrying over the part of the step past the end.
+      void SetLoopRange(const sLoopRange& aLoopRange) { mLoopRange = aLoopRange; }
+      const sLoopRange& GetLoopRange() const { return mLoopRange; }
+      s32 GetLoopCount() const { return mLoopCount; }
+
+      // Slaves the playhead to an external clock instead of the delta time, see TimelineClockSync. The delta time passed to
+      // Update still advances the playhead between clock reads. Fixed step settings take precedence over the clock.
+      void SetClockSource(std::shared_ptr<ITimelineClockSource> aSource, const sClockSyncSettings& aSettings = sClockSyncSettings());
+      const TimelineClockSync& GetClockSync() const { return mClockSync; }
+
+      struct sSimulationStats
+      {
+         s32 mFromFrame = 0;
+         s32 mToFrame = 0; // last frame reached, before aTo when every player finished early
+         s32 mUpdateCount = 0;
+         size_t mEventCount = 0; // activations and deactivations of this player and its children
+         double mSeconds = 0.0;
+
+         double GetEventsPerSecond() const { return mSeconds > 0.0 ? mEventCount / mSeconds : 0.0; }
+      };
+
+      // Headless playback for batch validation: fires every node callback of the range without touching ImGui.
+      // Concurrent mode reports every node, sequential mode plays the nodes the way interactive playback does.
+      // The player is left paused at the end of the range, or finished.
+      sSimulationStats SimulateRange(s32 aFrom, s32 aTo, s32 aStep = 1);
+
+      // Prepares custom nodes on a worker pool before they start, see TimelinePreparePool. Applied to the child players
+      // too, which share the pool of the player it was set on.
+      void SetLookaheadSettings(const sLookaheadSettings& aSettings);
+      const sLookaheadSettings& GetLookaheadSettings() const { return mLookaheadSettings; }
+
+      struct sLookaheadStats
+      {
+         size_t mSubmitted = 0;
+         size_t mHits = 0; // ready when they started
+         size_t mMisses = 0;
+         size_t mSkipped = 0;
+         size_t mDelayed = 0;
+         double mBlockedMilliseconds = 0.0;
+
+         f32 GetHitRate() const { return mHits + mMisses > 0 ? static_cast<f32>(mHits) / (mHits + mMisses) : 1.0f; }
+      };
+      sLookaheadStats GetLookaheadStats() const; // children included
+
+      // Snapshots of the child players and of aState every mIntervalFrames, taken while playing and while seeking. When they
+      // outgrow mMemoryBudgetBytes the interval in effect doubles until the next ClearCheckpoints, the settings keep their value.
+      // With checkpoints, Seek restores the nearest checkpoint before the target and replays the node callbacks from there,
+      // so custom node state is the same as after playing up to the target. Views only get the difference in active nodes.
+      // Turning checkpoints on stops the player, the first checkpoint is frame 0.
+      void SetCheckpointSettings(const sCheckpointSettings& aSettings, std::shared_ptr<ITimelineCheckpointState> aState = nullptr);
+      const sCheckpointSettings& GetCheckpointSettings() const { return mCheckpointSettings; }
+      void ClearCheckpoints(); // all but frame 0
+
+      struct sCheckpointStats
+      {
+         s32 mCount = 0;
+         size_t mBytes = 0;
+         s32 mIntervalFrames = 0; // in effect, wider than the settings' while the budget is reached
+         s32 mLastReplayFrames = 0;
+         double mLastSeekMilliseconds = 0.0;
+      };
+      sCheckpointStats GetCheckpointStats() const;
+      size_t GetEventCount() const; // node events dispatched since construction, children included
 
       void DrawPlayer();
 
@@ -56,29 +152,132 @@ namespace ImTimeline
       void OnDebugGUI();
       void OnDebugGUIPerformance();
 
-      s32 GetCurrentTimestamp() { return mTimeStep.GetTimestamp(); }
+      s32 GetCurrentTimestamp() { return mTimeStep.GetFrame(); }
 
    protected:
       eTimelineState mState = eState_None;
       void ChangeState(eTimelineState aState);
       TimelineNode* GetNextNodeToPlay();
 
+      void UpdateNodes();
+      void UpdateConcurrent();
+      void SeekActiveNodes(s32 aTimestamp);
+      void SeekPlayingNode(s32 aTimestamp);
+      void RefreshActiveNodes();
+      void SetPlayingNode(TimelineNode* aNode);
+      void RefreshPlayingNode();
+      void ReconcileActiveNodes(s32 aTimestamp);
+      void CollectNodeEvents(s32 aTimestamp);
+      void PushNodeEvent(TimelineNode* aNode, eNodePlayEventType aType, s32 aTimestamp);
+      void ActivateDelayedNodes(s32 aTimestamp);
+
+      enum class eActivation
+      {
+         Now,
+         Skip,
+         Delay,
+      };
+
+      void SetLookaheadSettings(const sLookaheadSettings& aSettings, std::shared_ptr<TimelinePreparePool> aPool);
+      void UpdateLookahead(s32 aTimestamp);
+      eActivation PrepareActivation(TimelineNode* aNode, bool bAlreadyDelayed);
+      s32 GetNextLookaheadTimestamp(s32 aNext);
+      void AnchorClock();
+      void WrapLoop();
+      bool IsLoopPending() { return mLoopRange.IsActive() && GetCurrentTimestamp() < mLoopRange.mEnd; } // the playhead still comes back
+      void FillPlayProperties(sNodePlayProperties& outProperties, s32 aTimestamp, s32 aEventFrame);
+
+      bool SeekFromCheckpoint(s32 aTimestamp);
+      void ReplayTo(s32 aFrom, s32 aTo);
+      void CaptureCheckpoint(s32 aTimestamp, bool bIsOrigin = false);
+      void CaptureCheckpointIfDue(s32 aTimestamp);
+      void ValidateCheckpoints();
+      void EnforceCheckpointBudget();
+      // child players
+      void SaveCheckpoint(std::vector<s32>& outState);
+      void LoadCheckpoint(const s32*& aRead, s32 aTimestamp);
+      void CollectActiveNodeIDs(std::vector<NodeID>& outIDs);
+      void DispatchViewDiff(const std::vector<NodeID>& aActiveBefore);
+      void DispatchNodeEvents();
+
       struct sPlayingNodeProperties
       {
          ePlayingNodeState mState = ePlayingNodeState::None;
+         bool mbIsDelayed = false; // waiting for the node to be ready, eNotReadyPolicy::Delay
+         NodeID mID = InvalidNodeID;
+         u32 mDataVersion = 0; // mPlayingNode is valid while the data version doesn't change
+      };
+
+      // Position of the next candidate node in the start order of mTimelineData
+      struct sPlayCursor
+      {
+         size_t mIndex = 0;
+         u32 mDataVersion = 0; // ImDataController::get_version() at the last seek
+         bool mbIsValid = false;
+         s32 mSeekCount = 0;
+         s32 mStepCount = 0;
+         s32 mScrubCount = 0; // Seek calls
       };
 
    TimelineNode* mPlayingNode = nullptr;
    sPlayingNodeProperties mPlayingNodeProperties;
+   sPlayCursor mPlayCursor;
+
+   // concurrent mode
+   struct sActiveNode
+   {
+      s32 mEnd = 0;
+      NodeID mID = InvalidNodeID;
+      TimelineNode* mNode = nullptr; // valid while the data version doesn't change
+
+      // heap order, nodes ending together end by ID so a replay from a checkpoint fires the same callbacks
+      static bool EndsLater(const sActiveNode& a, const sActiveNode& b) { return a.mEnd > b.mEnd || (a.mEnd == b.mEnd && a.mID > b.mID); }
+   };
+
+   ePlayMode mPlayMode = ePlayMode::Sequential;
+   std::vector<sActiveNode> mActiveNodes; // min-heap by end
+   std::vector<sActiveNode> mDelayedNodes; // started but not ready yet, eNotReadyPolicy::Delay
+   std::vector<sNodePlayEvent> mPendingEvents; // reused every update
+   s32 mLastEventTimestamp = 0;
+   s32 mLastEventBatchSize = 0;
+   size_t mEventCount = 0;
+
+   // lookahead
+   struct sPrefetchCursor
+   {
+      size_t mIndex = 0; // first node in start order that wasn't submitted yet
+      u32 mDataVersion = 0;
+      bool mbIsValid = false;
+   };
+
+   sLookaheadSettings mLookaheadSettings;
+   std::shared_ptr<TimelinePreparePool> mPreparePool;
+   sPrefetchCursor mPrefetchCursor;
+   sLookaheadStats mLookaheadStats;
+
+   // checkpoints, on the root player
+   sCheckpointSettings mCheckpointSettings;
+   std::shared_ptr<ITimelineCheckpointState> mCheckpointState;
+   std::vector<sCheckpoint> mCheckpoints; // by timestamp, frame 0 first
+   size_t mCheckpointBytes = 0;
+   s32 mCheckpointIntervalFrames = 0; // the settings' interval, widened while the checkpoints don't fit the budget
+   sCheckpointStats mCheckpointStats;
+   bool mbIsReplaying = false; // node callbacks only, the views are told the outcome afterwards
 
 private:
       IDGenerator mIDGenerator;
       s32 mUniqueID = -1;
       f32 mStartTimeStamp = 0.f;
-      IntTimelineTimeStep mTimeStep = IntTimelineTimeStep(0);
+      DeltaTimelineTimeStep mTimeStep;
+      TimelineClockSync mClockSync; // children get a copy of the root's on every anchor
+      sLoopRange mLoopRange;
+      s32 mLoopCount = 0;
       ImDataController* mTimelineData = nullptr;
 
       std::vector<std::shared_ptr<TimelinePlayer>> mPlayers;
+      std::vector<TimelinePlayer*> mSoloPlayers; // children playing while this player doesn't, see UpdateSoloPlayers
+      TimelinePlayer* mParent = nullptr;
+      TimelineScheduler mScheduler;
       std::shared_ptr<ITimelinePlayerView> mPlayerView;
 
        bool mbIsInitialized = false;
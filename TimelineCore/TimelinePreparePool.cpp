@@ -0,0 +1,133 @@
+#include "TimelinePreparePool.h"
+
+#include <algorithm>
+#include <chrono>
+
+ImTimeline::TimelinePreparePool::~TimelinePreparePool()
+{
+    SetWorkerCount(0);
+}
+
+void ImTimeline::TimelinePreparePool::SetWorkerCount(s32 aWorkerCount)
+{
+    aWorkerCount = std::max(aWorkerCount, 0);
+    if (aWorkerCount == GetWorkerCount()) {
+        return;
+    }
+
+    // workers are restarted rather than resized, this only happens when the settings change
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mbStopping = true;
+    }
+    mQueueCondition.notify_all();
+
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+    mWorkers.clear();
+    mbStopping = false;
+
+    for (s32 i = 0; i < aWorkerCount; ++i) {
+        mWorkers.emplace_back(&TimelinePreparePool::WorkerMain, this);
+    }
+}
+
+void ImTimeline::TimelinePreparePool::Submit(const std::shared_ptr<CustomNodeBase>& aNode)
+{
+    IM_ASSERT(aNode != nullptr);
+
+    u8 expected = ePrepare_None;
+    if (aNode->mPrepareState.compare_exchange_strong(expected, ePrepare_Queued) == false) {
+        return;
+    }
+
+    // without workers the setup still runs ahead of the activation, just on the calling thread
+    if (mWorkers.empty()) {
+        if (Claim(*aNode)) {
+            RunSetup(*aNode);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mQueue.push_back(aNode);
+    }
+    mQueueCondition.notify_one();
+}
+
+bool ImTimeline::TimelinePreparePool::IsReady(CustomNodeBase& aNode) const
+{
+    return aNode.mPrepareState.load() == ePrepare_Done && aNode.IsReady();
+}
+
+bool ImTimeline::TimelinePreparePool::WaitUntilReady(CustomNodeBase& aNode, s32 aTimeoutMilliseconds)
+{
+    // not submitted or still waiting for a worker, the caller needs it now
+    u8 state = aNode.mPrepareState.load();
+    if (state == ePrepare_None) {
+        aNode.mPrepareState.compare_exchange_strong(state, ePrepare_Queued);
+    }
+    if (Claim(aNode)) {
+        RunSetup(aNode);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(aTimeoutMilliseconds, 0));
+
+    while (IsReady(aNode) == false) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+void ImTimeline::TimelinePreparePool::Release(CustomNodeBase& aNode)
+{
+    // a setup that is still queued or running keeps its state, the node is simply prepared for the next pass already
+    u8 expected = ePrepare_Done;
+    aNode.mPrepareState.compare_exchange_strong(expected, ePrepare_None);
+}
+
+size_t ImTimeline::TimelinePreparePool::GetQueuedCount()
+{
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    return mQueue.size();
+}
+
+void ImTimeline::TimelinePreparePool::WorkerMain()
+{
+    while (true) {
+        std::shared_ptr<CustomNodeBase> node;
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueCondition.wait(lock, [this]() { return mbStopping || mQueue.empty() == false; });
+
+            if (mbStopping) {
+                return;
+            }
+
+            node = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        if (Claim(*node)) {
+            RunSetup(*node);
+        }
+    }
+}
+
+bool ImTimeline::TimelinePreparePool::Claim(CustomNodeBase& aNode)
+{
+    u8 expected = ePrepare_Queued;
+    return aNode.mPrepareState.compare_exchange_strong(expected, ePrepare_Running);
+}
+
+void ImTimeline::TimelinePreparePool::RunSetup(CustomNodeBase& aNode)
+{
+    aNode.OnTimelinePlayerSetup();
+    aNode.mPrepareState.store(ePrepare_Done);
+}
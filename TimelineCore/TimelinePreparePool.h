@@ -0,0 +1,73 @@
+#pragma once
+
+#include "TimelineDefines.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace ImTimeline
+{
+   enum class eNotReadyPolicy
+   {
+      Block, // the player waits for the node, at most mBlockTimeoutMilliseconds, then activates it anyway
+      Skip, // the node isn't played in this pass
+      Delay, // the node is activated at the first frame it's ready, unless it ended before
+   };
+
+   struct sLookaheadSettings
+   {
+      s32 mFrames = 0; // nodes starting within this many frames are prepared ahead, 0 turns the lookahead off
+      s32 mWorkerCount = 2;
+      eNotReadyPolicy mPolicy = eNotReadyPolicy::Block;
+      s32 mBlockTimeoutMilliseconds = 100;
+   };
+
+   /******
+    TimelinePreparePool
+    =========================
+    - Worker threads calling CustomNodeBase::OnTimelinePlayerSetup for nodes that are about to be played.
+     A node is prepared once until it is played: its state lives in the custom node, so submitting it again while
+     it's queued, running or done is free. Release puts a played node back, the next pass prepares it again.
+     WaitUntilReady runs a setup that's still queued on the calling thread instead of waiting for a worker.
+    */
+   class TimelinePreparePool
+   {
+   public:
+      enum ePrepareState : u8
+      {
+         ePrepare_None = 0,
+         ePrepare_Queued,
+         ePrepare_Running,
+         ePrepare_Done,
+      };
+
+      TimelinePreparePool() { }
+      TimelinePreparePool(const TimelinePreparePool&) = delete;
+      TimelinePreparePool& operator=(const TimelinePreparePool&) = delete;
+      ~TimelinePreparePool();
+
+      void SetWorkerCount(s32 aWorkerCount);
+      s32 GetWorkerCount() const { return static_cast<s32>(mWorkers.size()); }
+
+      void Submit(const std::shared_ptr<CustomNodeBase>& aNode);
+      // setup finished and the node reports ready
+      bool IsReady(CustomNodeBase& aNode) const;
+      // returns IsReady, waiting at most aTimeoutMilliseconds for it
+      bool WaitUntilReady(CustomNodeBase& aNode, s32 aTimeoutMilliseconds);
+      void Release(CustomNodeBase& aNode);
+
+      size_t GetQueuedCount();
+
+   private:
+      void WorkerMain();
+      static bool Claim(CustomNodeBase& aNode);
+      static void RunSetup(CustomNodeBase& aNode);
+
+      std::vector<std::thread> mWorkers;
+      std::deque<std::shared_ptr<CustomNodeBase>> mQueue; // entries claimed by WaitUntilReady are skipped by the workers
+      std::mutex mQueueMutex;
+      std::condition_variable mQueueCondition;
+      bool mbStopping = false;
+   };
+}
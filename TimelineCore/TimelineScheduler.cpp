@@ -0,0 +1,289 @@
+#include "TimelineScheduler.h"
+#include "TimelinePlayer.h"
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    s32 CountTrailingZeros(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward64(&index, value);
+        return static_cast<s32>(index);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    s32 HighestBit(uint32_t value)
+    {
+        s32 bit = -1;
+        while (value != 0) {
+            value >>= 1;
+            bit++;
+        }
+        return bit;
+    }
+
+    uint32_t ClampTimestamp(s32 timestamp)
+    {
+        return timestamp < 0 ? 0u : static_cast<uint32_t>(timestamp);
+    }
+}
+
+void ImTimeline::TimelineScheduler::AddPlayer(TimelinePlayer* aPlayer)
+{
+    IM_ASSERT(aPlayer != nullptr);
+
+    if (mLevels == nullptr) {
+        mLevels = std::make_unique<sLevel[]>(LevelCount);
+    }
+
+    if (mPlayerIndices.count(aPlayer) > 0) {
+        return;
+    }
+
+    sPlayerRecord record;
+    record.mPlayer = aPlayer;
+    mPlayerIndices[aPlayer] = static_cast<u32>(mPlayers.size());
+    mPlayers.push_back(record);
+
+    MarkDirty(aPlayer);
+}
+
+void ImTimeline::TimelineScheduler::RemovePlayer(TimelinePlayer* aPlayer)
+{
+    auto itIndex = mPlayerIndices.find(aPlayer);
+    if (itIndex == mPlayerIndices.end()) {
+        return;
+    }
+
+    // the record stays so indices in the wheel remain valid, its entries are stale from here on
+    unschedule(itIndex->second);
+    mPlayers[itIndex->second].mPlayer = nullptr;
+    mPlayerIndices.erase(itIndex);
+}
+
+void ImTimeline::TimelineScheduler::Reset(s32 aTimestamp)
+{
+    if (mLevels != nullptr) {
+        for (s32 level = 0; level < LevelCount; ++level) {
+            for (auto& slot : mLevels[level].mSlots) {
+                slot.clear();
+            }
+            std::fill(std::begin(mLevels[level].mOccupied), std::end(mLevels[level].mOccupied), 0);
+        }
+    }
+    mDue.clear();
+    mNow = ClampTimestamp(aTimestamp);
+
+    for (u32 index = 0; index < mPlayers.size(); ++index) {
+        unschedule(index);
+        if (mPlayers[index].mPlayer != nullptr && mPlayers[index].mbDirty == false) {
+            mPlayers[index].mbDirty = true;
+            mDirty.push_back(index);
+        }
+    }
+}
+
+void ImTimeline::TimelineScheduler::MarkDirty(TimelinePlayer* aPlayer)
+{
+    auto itIndex = mPlayerIndices.find(aPlayer);
+    if (itIndex == mPlayerIndices.end()) {
+        return;
+    }
+
+    sPlayerRecord& record = mPlayers[itIndex->second];
+    if (record.mbDirty == false) {
+        record.mbDirty = true;
+        mDirty.push_back(itIndex->second);
+    }
+}
+
+void ImTimeline::TimelineScheduler::AdvanceTo(s32 aTimestamp)
+{
+    if (mLevels == nullptr) {
+        return;
+    }
+
+    uint32_t target = ClampTimestamp(aTimestamp);
+    mLastWakeCount = 0;
+
+    flushDirty();
+    wakeDue();
+
+    uint32_t next = 0;
+    while (findNextTimestamp(next) && next <= target) {
+        mNow = next;
+
+        // on a slot boundary of a higher level its players move down, highest level first
+        for (s32 level = LevelCount - 1; level > 0; --level) {
+            uint32_t lowerBits = (1u << (level * SlotBits)) - 1;
+            if ((mNow & lowerBits) == 0) {
+                cascade(level);
+            }
+        }
+
+        sLevel& levelZero = mLevels[0];
+        uint32_t slot = mNow & (SlotCount - 1);
+        if (levelZero.mOccupied[slot / 64] & (uint64_t(1) << (slot % 64))) {
+            levelZero.mOccupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+            mDue.insert(mDue.end(), levelZero.mSlots[slot].begin(), levelZero.mSlots[slot].end());
+            levelZero.mSlots[slot].clear();
+        }
+
+        wakeDue();
+    }
+
+    if (target > mNow) {
+        mNow = target;
+    }
+}
+
+void ImTimeline::TimelineScheduler::schedule(u32 aPlayerIndex)
+{
+    unschedule(aPlayerIndex);
+
+    sPlayerRecord& record = mPlayers[aPlayerIndex];
+    if (record.mPlayer == nullptr || record.mPlayer->IsPlaying() == false) {
+        return;
+    }
+
+    sEntry entry;
+    entry.mPlayerIndex = aPlayerIndex;
+    entry.mGeneration = record.mGeneration;
+    entry.mTimestamp = ClampTimestamp(record.mPlayer->GetNextEventTimestamp());
+
+    record.mbScheduled = true;
+    mScheduledCount++;
+    file(entry);
+}
+
+void ImTimeline::TimelineScheduler::unschedule(u32 aPlayerIndex)
+{
+    sPlayerRecord& record = mPlayers[aPlayerIndex];
+    record.mGeneration++;
+
+    if (record.mbScheduled) {
+        record.mbScheduled = false;
+        mScheduledCount--;
+    }
+}
+
+void ImTimeline::TimelineScheduler::file(const sEntry& aEntry)
+{
+    if (aEntry.mTimestamp <= mNow) {
+        mDue.push_back(aEntry);
+        return;
+    }
+
+    s32 level = HighestBit(aEntry.mTimestamp ^ mNow) / SlotBits;
+    uint32_t slot = (aEntry.mTimestamp >> (level * SlotBits)) & (SlotCount - 1);
+
+    mLevels[level].mSlots[slot].push_back(aEntry);
+    mLevels[level].mOccupied[slot / 64] |= uint64_t(1) << (slot % 64);
+}
+
+void ImTimeline::TimelineScheduler::flushDirty()
+{
+    for (u32 index : mDirty) {
+        mPlayers[index].mbDirty = false;
+        schedule(index);
+    }
+    mDirty.clear();
+}
+
+// Every player woken here is at mNow, it's filed again at its next event, which always lies after mNow
+void ImTimeline::TimelineScheduler::wakeDue()
+{
+    while (mDue.empty() == false) {
+        mWaking.swap(mDue);
+
+        for (const sEntry& entry : mWaking) {
+            sPlayerRecord& record = mPlayers[entry.mPlayerIndex];
+            if (record.mGeneration != entry.mGeneration || record.mPlayer == nullptr) {
+                continue;
+            }
+
+            record.mbScheduled = false;
+            mScheduledCount--;
+
+            record.mPlayer->AdvanceTo(static_cast<s32>(mNow));
+            mWakeCount++;
+            mLastWakeCount++;
+
+            if (record.mPlayer->IsPlaying() == false) {
+                record.mGeneration++;
+                continue;
+            }
+
+            sEntry next = entry;
+            next.mGeneration = ++record.mGeneration;
+            next.mTimestamp = std::max(ClampTimestamp(record.mPlayer->GetNextEventTimestamp()), mNow + 1);
+
+            record.mbScheduled = true;
+            mScheduledCount++;
+            file(next);
+        }
+
+        mWaking.clear();
+    }
+}
+
+void ImTimeline::TimelineScheduler::cascade(s32 aLevel)
+{
+    sLevel& level = mLevels[aLevel];
+    uint32_t slot = (mNow >> (aLevel * SlotBits)) & (SlotCount - 1);
+
+    if ((level.mOccupied[slot / 64] & (uint64_t(1) << (slot % 64))) == 0) {
+        return;
+    }
+
+    level.mOccupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    mCascading.swap(level.mSlots[slot]);
+
+    for (const sEntry& entry : mCascading) {
+        if (mPlayers[entry.mPlayerIndex].mGeneration == entry.mGeneration) {
+            file(entry);
+        }
+    }
+
+    mCascading.clear();
+    mCascadeCount++;
+}
+
+// Lower levels always come first: their next slot lies inside the current slot of every level above
+bool ImTimeline::TimelineScheduler::findNextTimestamp(uint32_t& outTimestamp) const
+{
+    for (s32 level = 0; level < LevelCount; ++level) {
+        const sLevel& wheel = mLevels[level];
+        s32 shift = level * SlotBits;
+        s32 current = static_cast<s32>((mNow >> shift) & (SlotCount - 1));
+
+        for (s32 word = (current + 1) / 64; word < WordCount; ++word) {
+            uint64_t bits = wheel.mOccupied[word];
+            if (word == (current + 1) / 64 && (current + 1) % 64 != 0) {
+                bits &= ~uint64_t(0) << ((current + 1) % 64);
+            }
+
+            if (bits != 0) {
+                uint64_t slot = static_cast<uint64_t>(word * 64 + CountTrailingZeros(bits));
+                uint64_t upperMask = ~((uint64_t(1) << (shift + SlotBits)) - 1);
+                outTimestamp = static_cast<uint32_t>((static_cast<uint64_t>(mNow) & upperMask) | (slot << shift));
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ImTimeline::TimelineScheduler::OnDebugGUIPerformance()
+{
+    ImGui::Text("Scheduler: %d players, %d waiting, frame %d", static_cast<s32>(mPlayerIndices.size()), mScheduledCount, static_cast<s32>(mNow));
+    ImGui::Text("Wake-ups: %d last tick, %d total, %d cascades", mLastWakeCount, static_cast<s32>(mWakeCount), static_cast<s32>(mCascadeCount));
+}
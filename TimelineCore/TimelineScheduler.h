@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../Core/CoreDefines.h"
+#include <cstdint>
+
+namespace ImTimeline
+{
+   class TimelinePlayer;
+
+   /******
+    TimelineScheduler
+    =========================
+    - Hierarchical timing wheel that wakes child players only at the frames where something happens for them.
+     Each player is filed under the timestamp returned by TimelinePlayer::GetNextEventTimestamp. There are four levels of
+     256 slots, and a player sits on the level of the highest byte in which its wake-up frame differs from the current
+     frame. When the wheel reaches a slot of a higher level, the players in it move down a level, until they land in
+     level 0 and are woken. Occupancy bitmaps let AdvanceTo jump straight to the next occupied slot, so a tick costs
+     O(1 + players due), however many players are idle or far in the future.
+     Players are re-filed after every wake-up. Anything else that changes their schedule (edits, seeks, play state)
+     has to call MarkDirty or Reset, which re-read the player on the next AdvanceTo.
+    */
+   class TimelineScheduler
+   {
+   public:
+      TimelineScheduler() { }
+      TimelineScheduler(const TimelineScheduler&) = delete;
+      TimelineScheduler& operator=(const TimelineScheduler&) = delete;
+
+      void AddPlayer(TimelinePlayer* aPlayer);
+      void RemovePlayer(TimelinePlayer* aPlayer);
+
+      // Drops every pending wake-up and moves the wheel to aTimestamp, all players are re-read on the next AdvanceTo
+      void Reset(s32 aTimestamp);
+      void MarkDirty(TimelinePlayer* aPlayer);
+
+      // Wakes every player due up to and including aTimestamp, in timestamp order
+      void AdvanceTo(s32 aTimestamp);
+
+      bool IsIdle() const { return mScheduledCount == 0 && mDirty.empty(); } // no player is waiting for a frame
+      s32 GetTimestamp() const { return static_cast<s32>(mNow); }
+
+      void OnDebugGUIPerformance();
+
+   private:
+      static constexpr s32 LevelCount = 4;
+      static constexpr s32 SlotBits = 8;
+      static constexpr s32 SlotCount = 1 << SlotBits;
+      static constexpr s32 WordCount = SlotCount / 64;
+
+      struct sEntry
+      {
+         u32 mPlayerIndex = 0;
+         u32 mGeneration = 0; // stale entries of rescheduled players are skipped
+         uint32_t mTimestamp = 0;
+      };
+
+      struct sPlayerRecord
+      {
+         TimelinePlayer* mPlayer = nullptr;
+         u32 mGeneration = 0;
+         bool mbScheduled = false;
+         bool mbDirty = false;
+      };
+
+      struct sLevel
+      {
+         std::vector<sEntry> mSlots[SlotCount];
+         uint64_t mOccupied[WordCount] = {};
+      };
+
+      void schedule(u32 aPlayerIndex);
+      void unschedule(u32 aPlayerIndex);
+      void file(const sEntry& aEntry);
+      void flushDirty();
+      void wakeDue();
+      void cascade(s32 aLevel);
+      bool findNextTimestamp(uint32_t& outTimestamp) const;
+
+      std::vector<sPlayerRecord> mPlayers;
+      std::unordered_map<TimelinePlayer*, u32> mPlayerIndices;
+      std::vector<u32> mDirty;
+      std::vector<sEntry> mDue; // due at mNow
+      std::vector<sEntry> mWaking;
+      std::vector<sEntry> mCascading;
+      std::unique_ptr<sLevel[]> mLevels; // allocated with the first player
+      uint32_t mNow = 0;
+      s32 mScheduledCount = 0;
+
+      // stats
+      s32 mLastWakeCount = 0;
+      size_t mWakeCount = 0;
+      size_t mCascadeCount = 0;
+   };
+}
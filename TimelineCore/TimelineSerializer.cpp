@@ -0,0 +1,435 @@
+#include "TimelineSerializer.h"
+#include "TimelineFileFormat.h"
+#include "../Timeline.h"
+#include "../TimelineData/ImDataController.h"
+#include "../TimelineData/ImDataControllerMapped.h"
+#include "../TimelineData/ImDataSummaryPyramid.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+    using namespace ImTimelineFile;
+
+    // Writes next to the target and only moves the new file over it once it's complete. The target can be the file the
+    // timeline is mapped from, which must not be truncated under the mapping, and a failed save leaves it as it was.
+    class FileWriter
+    {
+    public:
+        explicit FileWriter(const std::string& path)
+            : mPath(path)
+            , mTempPath(path + ".tmp")
+            , mStream(mTempPath, std::ios::binary | std::ios::trunc)
+        {
+        }
+
+        ~FileWriter()
+        {
+            if (mbIsCommitted == false) {
+                mStream.close();
+                std::remove(mTempPath.c_str());
+            }
+        }
+
+        bool IsGood() const { return mStream.good(); }
+
+        bool Commit()
+        {
+            mStream.close();
+            if (mStream.fail()) {
+                return false;
+            }
+
+#ifdef _WIN32
+            mbIsCommitted = MoveFileExA(mTempPath.c_str(), mPath.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+            mbIsCommitted = std::rename(mTempPath.c_str(), mPath.c_str()) == 0;
+#endif
+            return mbIsCommitted;
+        }
+        uint64_t GetOffset() const { return mOffset; }
+
+        template <typename T>
+        uint64_t WriteBlock(const T* data, size_t count)
+        {
+            Align();
+            uint64_t offset = mOffset;
+            Write(data, count * sizeof(T));
+            return offset;
+        }
+
+        void Write(const void* data, size_t bytes)
+        {
+            if (bytes > 0) {
+                mStream.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+                mOffset += bytes;
+            }
+        }
+
+        void Align()
+        {
+            static const char zeros[kBlockAlignment] = {};
+            Write(zeros, static_cast<size_t>(AlignOffset(mOffset) - mOffset));
+        }
+
+        void Rewrite(uint64_t offset, const void* data, size_t bytes)
+        {
+            mStream.seekp(static_cast<std::streamoff>(offset));
+            mStream.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            mStream.seekp(0, std::ios::end);
+        }
+
+    private:
+        std::string mPath;
+        std::string mTempPath;
+        std::ofstream mStream;
+        uint64_t mOffset = 0;
+        bool mbIsCommitted = false;
+    };
+
+    // deduplicated strings and display properties, shared by every section of the file
+    class FileTables
+    {
+    public:
+        u32 AddString(const std::string& text)
+        {
+            auto it = mStringIndex.find(text);
+            if (it != mStringIndex.end()) {
+                return it->second;
+            }
+
+            sFileString entry = {};
+            entry.mOffset = mStringData.size();
+            entry.mLength = static_cast<u32>(text.size());
+            mStringData.insert(mStringData.end(), text.begin(), text.end());
+
+            u32 index = static_cast<u32>(mStrings.size());
+            mStrings.push_back(entry);
+            mStringIndex.emplace(text, index);
+            return index;
+        }
+
+        // the background colours of a node drawn with its section's aren't used, they're left out so it can share the default
+        u32 AddDisplayProperties(const sGenericDisplayProperties& properties, bool bOwnBackground)
+        {
+            sFileDisplayProperties fileProperties = ToFile(properties);
+            if (bOwnBackground == false) {
+                fileProperties.mBackgroundColor = mDefaultProperties.mBackgroundColor;
+                fileProperties.mBackgroundColorTwo = mDefaultProperties.mBackgroundColorTwo;
+            }
+            if (std::memcmp(&fileProperties, &mDefaultProperties, sizeof(sFileDisplayProperties)) == 0) {
+                return kNoIndex;
+            }
+
+            std::string key(reinterpret_cast<const char*>(&fileProperties), sizeof(sFileDisplayProperties));
+            auto it = mDisplayPropertiesIndex.find(key);
+            if (it != mDisplayPropertiesIndex.end()) {
+                return it->second;
+            }
+
+            u32 index = static_cast<u32>(mDisplayProperties.size());
+            mDisplayProperties.push_back(fileProperties);
+            mDisplayPropertiesIndex.emplace(std::move(key), index);
+            return index;
+        }
+
+        std::vector<char> mStringData;
+        std::vector<sFileString> mStrings;
+        std::vector<sFileDisplayProperties> mDisplayProperties;
+
+    private:
+        std::unordered_map<std::string, u32> mStringIndex;
+        std::unordered_map<std::string, u32> mDisplayPropertiesIndex;
+        sFileDisplayProperties mDefaultProperties = ToFile(sGenericDisplayProperties());
+    };
+
+    void WriteSummary(FileWriter& writer, const NodeSummaryPyramid& summary, sFileSection& outSection)
+    {
+        static_assert(sizeof(NodeSummaryPyramid::sEntry) == 24, "summary entry layout changed");
+
+        std::vector<NodeSummaryPyramid::sEntry> entries;
+        summary.get_entries(entries);
+
+        outSection.mSummaryBucketFrames = static_cast<s32>(summary.get_bucket_frames(0));
+        outSection.mSummaryLevelCount = static_cast<u32>(summary.get_level_count());
+        outSection.mSummaryNodeCount = static_cast<uint64_t>(summary.get_node_count());
+        outSection.mSummaryOccupiedFrames = summary.get_occupied_frames();
+        outSection.mSummaryEntryCount = entries.size();
+        outSection.mSummaryOffset = writer.WriteBlock(entries.data(), entries.size());
+    }
+
+    std::string ReadString(const sMappedSection& tables, u32 index)
+    {
+        if (index >= tables.mStringCount) {
+            return std::string();
+        }
+
+        const sFileString& entry = tables.mStrings[index];
+        if (entry.mOffset > tables.mStringDataSize || entry.mLength > tables.mStringDataSize - entry.mOffset) {
+            return std::string();
+        }
+
+        return std::string(tables.mStringData + entry.mOffset, entry.mLength);
+    }
+
+    // Points the section's columns into the file, false if any of them lies outside of it
+    bool MapSection(const MappedFile& file, const sFileSection& section, sMappedSection& outSection)
+    {
+        const uint64_t nodeCount = section.mNodeCount;
+        if (nodeCount > 0xFFFFFFFFull) {
+            return false;
+        }
+
+        outSection.mSection = section;
+        outSection.mStarts = file.get_block<s32>(section.mStartsOffset, nodeCount);
+        outSection.mEnds = file.get_block<s32>(section.mEndsOffset, nodeCount);
+        outSection.mIDs = file.get_block<NodeID>(section.mIDsOffset, nodeCount);
+        outSection.mNodeInfos = file.get_block<sFileNodeInfo>(section.mNodeInfoOffset, nodeCount);
+        outSection.mIDIndex = file.get_block<sFileIDEntry>(section.mIDIndexOffset, nodeCount);
+
+        if (nodeCount > 0 && (outSection.mStarts == nullptr || outSection.mEnds == nullptr || outSection.mIDs == nullptr || outSection.mNodeInfos == nullptr || outSection.mIDIndex == nullptr)) {
+            return false;
+        }
+
+        outSection.mSummaryEntries = file.get_block<NodeSummaryPyramid::sEntry>(section.mSummaryOffset, section.mSummaryEntryCount);
+        if (section.mSummaryLevelCount > 32 || (section.mSummaryEntryCount > 0 && outSection.mSummaryEntries == nullptr)) {
+            return false;
+        }
+
+        return true;
+    }
+}
+
+bool ImTimeline::TimelineSerializer::Save(Timeline& aTimeline, const std::string& aPath, sSerializerStats* outStats)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    auto lock = aTimeline.lockForEdit();
+
+    if (aTimeline.IsInTransaction()) {
+        LOG_WARNING_PRINTF("Timeline can't be saved to %s while a transaction is open", aPath.c_str());
+        return false;
+    }
+
+    FileWriter writer(aPath);
+    if (writer.IsGood() == false) {
+        LOG_WARNING_PRINTF("Could not open %s for writing", aPath.c_str());
+        return false;
+    }
+
+    sFileHeader header = {};
+    std::memcpy(header.mMagic, kMagic, sizeof(kMagic));
+    header.mVersion = kVersion;
+    header.mByteOrderMark = kByteOrderMark;
+    header.mHeaderSize = sizeof(sFileHeader);
+    header.mFrameMax = aTimeline.GetMaxFrame();
+    header.mMaxNodeID = 0;
+    writer.Write(&header, sizeof(header)); // rewritten once the offsets are known
+
+    // sections by ID, so saving the same timeline twice gives the same file
+    std::map<u32, const sTimelineSection*> sections;
+    for (const auto& section : aTimeline.mTimelines) {
+        if (section.second.mbIsInitialized && section.second.mNodeData != nullptr) {
+            sections[section.first] = &section.second;
+        }
+    }
+
+    FileTables tables;
+    std::vector<sFileSection> fileSections;
+    fileSections.reserve(sections.size());
+    size_t totalNodeCount = 0;
+
+    for (const auto& entry : sections) {
+        const sTimelineSection& section = *entry.second;
+
+        std::vector<const TimelineNode*> nodes;
+        nodes.reserve(section.mNodeData->node_count());
+        section.mNodeData->for_each_node([&nodes](TimelineNode& node) { nodes.push_back(&node); });
+        std::stable_sort(nodes.begin(), nodes.end(), [](const TimelineNode* a, const TimelineNode* b) { return a->start < b->start; });
+
+        if (nodes.size() > 0xFFFFFFFFull) {
+            LOG_WARNING_PRINTF("Section %d has too many nodes to be saved", static_cast<s32>(entry.first));
+            return false;
+        }
+
+        const size_t count = nodes.size();
+        std::vector<s32> starts(count);
+        std::vector<s32> ends(count);
+        std::vector<NodeID> ids(count);
+        std::vector<sFileNodeInfo> infos(count);
+        std::vector<sFileIDEntry> idIndex(count);
+        s32 maxDuration = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            const TimelineNode& node = *nodes[i];
+            starts[i] = node.start;
+            ends[i] = node.end;
+            ids[i] = node.GetID();
+            infos[i].mText = tables.AddString(node.displayText);
+            infos[i].mFlags = static_cast<u32>(node.mFlags.to_ulong());
+            infos[i].mDisplayProperties = tables.AddDisplayProperties(node.displayProperties, node.mFlags.test(eTimelineNodeFlags::TimelineNodeFlags_UseSectionBackground) == false);
+            idIndex[i].mID = node.GetID();
+            idIndex[i].mIndex = static_cast<u32>(i);
+            maxDuration = std::max(maxDuration, node.end - node.start);
+            header.mMaxNodeID = std::max(header.mMaxNodeID, node.GetID());
+        }
+        std::sort(idIndex.begin(), idIndex.end(), [](const sFileIDEntry& a, const sFileIDEntry& b) { return a.mID < b.mID; });
+
+        sFileSection fileSection = {};
+        fileSection.mID = static_cast<s32>(entry.first);
+        fileSection.mName = tables.AddString(section.mProps.mSectionName);
+        fileSection.mEndTimestamp = section.mProps.mEndTimestamp;
+        fileSection.mMaxDuration = maxDuration;
+        fileSection.mDisplayProperties = ToFile(section.mProps.mDisplayProperties);
+        fileSection.mNodeCount = count;
+        fileSection.mStartsOffset = writer.WriteBlock(starts.data(), count);
+        fileSection.mEndsOffset = writer.WriteBlock(ends.data(), count);
+        fileSection.mIDsOffset = writer.WriteBlock(ids.data(), count);
+        fileSection.mNodeInfoOffset = writer.WriteBlock(infos.data(), count);
+        fileSection.mIDIndexOffset = writer.WriteBlock(idIndex.data(), count);
+
+        // containers without a summary get one built for the file, a loaded section always has one
+        const NodeSummaryPyramid* summary = section.mNodeData->get_summary();
+        NodeSummaryPyramid builtSummary;
+        if (summary == nullptr) {
+            for (size_t i = 0; i < count; ++i) {
+                builtSummary.add(starts[i], ends[i]);
+            }
+            summary = &builtSummary;
+        }
+        WriteSummary(writer, *summary, fileSection);
+
+        fileSections.push_back(fileSection);
+        totalNodeCount += count;
+    }
+
+    header.mStringDataOffset = writer.WriteBlock(tables.mStringData.data(), tables.mStringData.size());
+    header.mStringDataSize = tables.mStringData.size();
+    header.mStringTableOffset = writer.WriteBlock(tables.mStrings.data(), tables.mStrings.size());
+    header.mStringCount = static_cast<u32>(tables.mStrings.size());
+    header.mDisplayPropertiesOffset = writer.WriteBlock(tables.mDisplayProperties.data(), tables.mDisplayProperties.size());
+    header.mDisplayPropertiesCount = static_cast<u32>(tables.mDisplayProperties.size());
+    header.mSectionTableOffset = writer.WriteBlock(fileSections.data(), fileSections.size());
+    header.mSectionCount = static_cast<u32>(fileSections.size());
+    writer.Align();
+    header.mFileSize = writer.GetOffset();
+
+    writer.Rewrite(0, &header, sizeof(header));
+    if (writer.IsGood() == false || writer.Commit() == false) {
+        LOG_WARNING_PRINTF("Writing %s failed", aPath.c_str());
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    LOG_INFO_PRINTF("Saved %d node(s) in %d section(s) to %s", static_cast<s32>(totalNodeCount), static_cast<s32>(fileSections.size()), aPath.c_str());
+
+    if (outStats != nullptr) {
+        outStats->mSectionCount = fileSections.size();
+        outStats->mNodeCount = totalNodeCount;
+        outStats->mFileBytes = header.mFileSize;
+        outStats->mSeconds = seconds;
+    }
+
+    return true;
+}
+
+bool ImTimeline::TimelineSerializer::Load(Timeline& aTimeline, const std::string& aPath, sSerializerStats* outStats)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::shared_ptr<MappedFile> file = MappedFile::Open(aPath);
+    if (file == nullptr) {
+        LOG_WARNING_PRINTF("Could not map %s", aPath.c_str());
+        return false;
+    }
+
+    const sFileHeader* header = file->get_block<sFileHeader>(0, 1);
+    if (header == nullptr || std::memcmp(header->mMagic, kMagic, sizeof(kMagic)) != 0) {
+        LOG_WARNING_PRINTF("%s is not a timeline file", aPath.c_str());
+        return false;
+    }
+
+    if (header->mVersion != kVersion || header->mByteOrderMark != kByteOrderMark || header->mHeaderSize != sizeof(sFileHeader)) {
+        LOG_WARNING_PRINTF("%s has version %d, or was written on a host of different byte order", aPath.c_str(), static_cast<s32>(header->mVersion));
+        return false;
+    }
+
+    if (header->mFileSize != file->size()) {
+        LOG_WARNING_PRINTF("%s is truncated", aPath.c_str());
+        return false;
+    }
+
+    // everything is checked before the timeline is touched, a bad file leaves it as it was
+    sMappedSection tables;
+    tables.mStrings = file->get_block<sFileString>(header->mStringTableOffset, header->mStringCount);
+    tables.mStringCount = header->mStringCount;
+    tables.mStringData = file->get_block<char>(header->mStringDataOffset, header->mStringDataSize);
+    tables.mStringDataSize = header->mStringDataSize;
+    tables.mDisplayProperties = file->get_block<sFileDisplayProperties>(header->mDisplayPropertiesOffset, header->mDisplayPropertiesCount);
+    tables.mDisplayPropertiesCount = header->mDisplayPropertiesCount;
+    const sFileSection* fileSections = file->get_block<sFileSection>(header->mSectionTableOffset, header->mSectionCount);
+
+    bool bIsValid = (tables.mStrings != nullptr || tables.mStringCount == 0) && (tables.mStringData != nullptr || tables.mStringDataSize == 0)
+        && (tables.mDisplayProperties != nullptr || tables.mDisplayPropertiesCount == 0) && (fileSections != nullptr || header->mSectionCount == 0);
+
+    std::vector<sMappedSection> mappedSections(bIsValid ? header->mSectionCount : 0, tables);
+    for (size_t i = 0; i < mappedSections.size() && bIsValid; ++i) {
+        bIsValid = MapSection(*file, fileSections[i], mappedSections[i]);
+    }
+
+    if (bIsValid == false) {
+        LOG_WARNING_PRINTF("%s is corrupt", aPath.c_str());
+        return false;
+    }
+
+    auto lock = aTimeline.lockForEdit();
+    if (aTimeline.IsInTransaction()) {
+        LOG_WARNING_PRINTF("Timeline can't be loaded from %s while a transaction is open", aPath.c_str());
+        return false;
+    }
+
+    aTimeline.clearSections();
+
+    size_t totalNodeCount = 0;
+    for (const sMappedSection& mapped : mappedSections) {
+        totalNodeCount += static_cast<size_t>(mapped.mSection.mNodeCount);
+    }
+    for (const sMappedSection& mapped : mappedSections) {
+        const sFileSection& fileSection = mapped.mSection;
+
+        aTimeline.InitializeTimelineSection(fileSection.mID, ReadString(tables, fileSection.mName), new MappedContainer(file, mapped));
+
+        sTimelineSection& section = aTimeline.GetTimelineSection(fileSection.mID);
+        section.mProps.mEndTimestamp = fileSection.mEndTimestamp;
+        section.mProps.mDisplayProperties = FromFile(fileSection.mDisplayProperties);
+
+        // nothing is read per node, lookups by ID search the section's ID index in the file
+        aTimeline.mLoadedSections.push_back(fileSection.mID);
+    }
+
+    aTimeline.SetMaxFrame(header->mFrameMax);
+    aTimeline.mIDGenerator.Reserve(header->mMaxNodeID);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    LOG_INFO_PRINTF("Loaded %d node(s) in %d section(s) from %s", static_cast<s32>(totalNodeCount), static_cast<s32>(mappedSections.size()), aPath.c_str());
+
+    if (outStats != nullptr) {
+        outStats->mSectionCount = mappedSections.size();
+        outStats->mNodeCount = totalNodeCount;
+        outStats->mFileBytes = file->size();
+        outStats->mSeconds = seconds;
+    }
+
+    return true;
+}
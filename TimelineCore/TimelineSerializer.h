@@ -0,0 +1,35 @@
+#pragma once
+
+#include "TimelineDefines.h"
+#include <string>
+
+namespace ImTimeline
+{
+   class Timeline;
+
+   struct sSerializerStats
+   {
+      size_t mSectionCount = 0;
+      size_t mNodeCount = 0;
+      uint64_t mFileBytes = 0;
+      double mSeconds = 0.0;
+
+      double GetMegabytesPerSecond() const { return mSeconds > 0.0 ? mFileBytes / (1024.0 * 1024.0) / mSeconds : 0.0; }
+   };
+
+   /******
+    TimelineSerializer
+    =========================
+    - Saves a timeline in the native binary format, see ImTimelineFile, and loads it back by mapping the file into memory.
+     A loaded section is a MappedContainer over the mapping: nothing is read per node at load time, lookups by ID
+     binary-search the file's ID index and nodes are read as they're scrolled into view or played. Loading replaces every section and
+     clears the undo history. Saving over the file the timeline was loaded from is fine, the new file replaces it at the end.
+     Custom nodes aren't saved, they belong to the application, which can attach them again after loading.
+    */
+   class TimelineSerializer
+   {
+   public:
+      static bool Save(Timeline& aTimeline, const std::string& aPath, sSerializerStats* outStats = nullptr);
+      static bool Load(Timeline& aTimeline, const std::string& aPath, sSerializerStats* outStats = nullptr);
+   };
+}
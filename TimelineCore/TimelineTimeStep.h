@@ -1,62 +1,217 @@
 #pragma once
 #include "../Core/CoreDefines.h"
-#include <chrono>
-
-//TODO use this more for step progression everywhere
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 namespace ImTimeline
-{   
+{
    class TimelineTimeStep
    {
    public:
       TimelineTimeStep() { };
+      virtual ~TimelineTimeStep() { };
 
       virtual void Update(f32 aDeltaTime) = 0;
       virtual inline f32 GetTimestamp() const = 0;
    };
 
-    class IntTimelineTimeStep : TimelineTimeStep
+   struct sTimeStepSettings
+   {
+      f32 mFramesPerSecond = 1.0f; // timeline frames per second of delta time
+      f32 mPlaybackSpeed = 1.0f; // multiplier on the delta time, 0 holds the playhead
+      s32 mFixedFramesPerUpdate = 0; // when > 0 every Update advances exactly this many frames and the delta time is ignored
+   };
+
+   struct sLoopRange
+   {
+      s32 mStart = 0;
+      s32 mEnd = 0; // exclusive, reaching it wraps the playhead back to mStart. Looping is off while mEnd <= mStart
+
+      bool IsActive() const { return mEnd > mStart; }
+   };
+
+   /******
+    DeltaTimelineTimeStep
+    =========================
+    - Advances the timestamp purely from the delta time handed to Update, no clock is polled.
+     Fractions of a frame are accumulated until they add up to whole frames, so a 60 Hz UI can drive a 24 fps timeline.
+     The fixed step mode advances a constant number of frames per Update, for deterministic runs that don't depend on frame times.
+    */
+   class DeltaTimelineTimeStep : public TimelineTimeStep
    {
    public:
-      IntTimelineTimeStep() : mTimestamp(0)
+      DeltaTimelineTimeStep() { }
+      explicit DeltaTimelineTimeStep(s32 aStart) : mTimestamp(aStart) { }
+
+      void Update(f32 aDeltaTime) override
+      {
+         if (mSettings.mFixedFramesPerUpdate > 0) {
+            mTimestamp += mSettings.mFixedFramesPerUpdate;
+            return;
+         }
+
+         if (aDeltaTime <= 0.0f || mSettings.mPlaybackSpeed <= 0.0f || mSettings.mFramesPerSecond <= 0.0f) {
+            return;
+         }
+
+         mSubFrame += static_cast<double>(aDeltaTime) * mSettings.mPlaybackSpeed * mSettings.mFramesPerSecond;
+
+         double wholeFrames = std::floor(mSubFrame);
+         mTimestamp += static_cast<s32>(wholeFrames);
+         mSubFrame -= wholeFrames;
+      }
+
+      // whole frames plus the fraction accumulated towards the next one
+      virtual inline f32 GetTimestamp() const override
+      {
+         return static_cast<f32>(mTimestamp + mSubFrame);
+      }
+
+      s32 GetFrame() const { return mTimestamp; }
+      double GetPosition() const { return mTimestamp + mSubFrame; }
+
+      void SetTimestamp(s32 aTimestamp)
       {
-         mLastUpdateTime = std::chrono::steady_clock::now(); 
+         mTimestamp = aTimestamp;
+         mSubFrame = 0.0;
       }
-      IntTimelineTimeStep(s32 start) : mTimestamp(start)
+
+      // fractional position, for a playhead slaved to an external clock
+      void SetPosition(double aPosition)
+      {
+         double wholeFrames = std::floor(aPosition);
+         mTimestamp = static_cast<s32>(wholeFrames);
+         mSubFrame = aPosition - wholeFrames;
+      }
+
+      void SetSettings(const sTimeStepSettings& aSettings) { mSettings = aSettings; }
+      const sTimeStepSettings& GetSettings() const { return mSettings; }
+
+   private:
+      s32 mTimestamp = 0;
+      double mSubFrame = 0.0; // [0, 1)
+      sTimeStepSettings mSettings;
+   };
+
+   /******
+    ITimelineClockSource
+    =========================
+    - Monotonically increasing counter a player can be slaved to, an audio device's sample position for instance.
+    */
+   class ITimelineClockSource
+   {
+   public:
+      virtual ~ITimelineClockSource() = default;
+
+      virtual int64_t GetTicks() = 0;
+      virtual double GetTicksPerSecond() const = 0;
+   };
+
+   /******
+    FakeTimelineClock
+    =========================
+    - Clock that only moves when told to, for tests and headless runs that need a reproducible external clock.
+    */
+   class FakeTimelineClock : public ITimelineClockSource
+   {
+   public:
+      explicit FakeTimelineClock(double aTicksPerSecond = 48000.0) : mTicksPerSecond(aTicksPerSecond) { }
+
+      int64_t GetTicks() override { return mTicks; }
+      double GetTicksPerSecond() const override { return mTicksPerSecond; }
+
+      void Advance(int64_t aTicks) { mTicks += std::max<int64_t>(aTicks, 0); }
+      void SetTicks(int64_t aTicks) { mTicks = std::max(aTicks, mTicks); }
+
+   private:
+      int64_t mTicks = 0;
+      double mTicksPerSecond = 48000.0;
+   };
+
+   struct sClockSyncSettings
+   {
+      f32 mCorrectionRate = 0.25f; // share of the drift from the clock corrected per update, 1 follows the clock exactly
+      f32 mMaxDriftFrames = 2.0f; // further off than this, the playhead jumps to the clock
+   };
+
+   /******
+    TimelineClockSync
+    =========================
+    - Maps an external clock onto timeline frames from an anchor: the tick and the frame at which playback (re)started
+     and the frame rate and speed of the time step at that point.
+     The playhead is still advanced by the delta time between clock reads, which are often coarse (once per audio buffer),
+     and the drift from the clock is corrected a little every update. Large errors, after a device stall for instance,
+     are resynchronized at once. The playhead never moves backwards.
+     Whatever the smoothing, GetTicksAtFrame gives the exact clock tick of a frame, events carry it to line up with the clock.
+    */
+   class TimelineClockSync
+   {
+   public:
+      void SetSource(std::shared_ptr<ITimelineClockSource> aSource) { mSource = std::move(aSource); }
+      const std::shared_ptr<ITimelineClockSource>& GetSource() const { return mSource; }
+      bool HasSource() const { return mSource != nullptr; }
+
+      void SetSettings(const sClockSyncSettings& aSettings) { mSettings = aSettings; }
+      const sClockSyncSettings& GetSettings() const { return mSettings; }
+
+      void Anchor(double aPosition, const sTimeStepSettings& aTimeStepSettings)
       {
+         if (mSource == nullptr) {
+            return;
+         }
 
+         mAnchorTicks = mSource->GetTicks();
+         mAnchorPosition = aPosition;
+         mFramesPerTick = mSource->GetTicksPerSecond() > 0.0 ? aTimeStepSettings.mFramesPerSecond * aTimeStepSettings.mPlaybackSpeed / mSource->GetTicksPerSecond() : 0.0;
       }
 
-    void Update(f32 aDeltaTime) override
-    {
-      if(mFirstUpdate == false)
+      // aPredicted is the playhead advanced by the delta time, the result is corrected towards the clock
+      double Correct(double aPrevious, double aPredicted)
       {
-        mFirstUpdate = true;
-        mLastUpdateTime = std::chrono::steady_clock::now(); 
+         double target = GetClockPosition();
+         double error = target - aPredicted;
+
+         mLastDriftFrames = static_cast<f32>(error);
+         mPeakDriftFrames = std::max(mPeakDriftFrames, static_cast<f32>(std::fabs(error)));
 
+         double corrected = aPredicted + error * ImClamp(mSettings.mCorrectionRate, 0.0f, 1.0f);
+         if (std::fabs(error) > mSettings.mMaxDriftFrames) {
+            corrected = target;
+            mResyncCount++;
+         }
+
+         return std::max(corrected, aPrevious);
       }
-            auto currentTime = std::chrono::steady_clock::now(); 
-            std::chrono::duration<float> elapsed = currentTime - mLastUpdateTime; 
-            
-            if (elapsed.count() >= 1.0f) 
-            { 
-                ++mTimestamp; 
-                mLastUpdateTime = currentTime; 
-            }
-    }
-      virtual inline f32 GetTimestamp() const override
+
+      double GetClockPosition() const
       {
-        return mTimestamp;
+         return mSource != nullptr ? mAnchorPosition + static_cast<double>(mSource->GetTicks() - mAnchorTicks) * mFramesPerTick : mAnchorPosition;
       }
 
-      void SetTimestamp(s32 aTimestamp)
+      // -1 without a clock, or while the playhead doesn't move
+      int64_t GetTicksAtFrame(s32 aFrame) const
       {
-        mTimestamp = aTimestamp;
+         if (mSource == nullptr || mFramesPerTick <= 0.0) {
+            return -1;
+         }
+         return mAnchorTicks + static_cast<int64_t>(std::llround((aFrame - mAnchorPosition) / mFramesPerTick));
       }
 
-    private:
-      s32 mTimestamp = 0;
-      std::chrono::steady_clock::time_point mLastUpdateTime;
-      bool mFirstUpdate = false;
+      f32 GetLastDriftFrames() const { return mLastDriftFrames; }
+      f32 GetPeakDriftFrames() const { return mPeakDriftFrames; }
+      s32 GetResyncCount() const { return mResyncCount; }
+
+   private:
+      std::shared_ptr<ITimelineClockSource> mSource;
+      sClockSyncSettings mSettings;
+      int64_t mAnchorTicks = 0;
+      double mAnchorPosition = 0.0;
+      double mFramesPerTick = 0.0;
+
+      // stats
+      f32 mLastDriftFrames = 0.0f;
+      f32 mPeakDriftFrames = 0.0f;
+      s32 mResyncCount = 0;
    };
 }
@@ -0,0 +1,831 @@
+#include "TimelineTraceImporter.h"
+#include "ImTimeline_internal.h"
+#include "../Timeline.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    static constexpr size_t kMaxJsonDepth = 256;
+
+    // Reads a file in fixed-size blocks, the only buffer the parser holds on to
+    class BlockReader
+    {
+    public:
+        BlockReader(FILE* file, size_t bufferBytes)
+            : mFile(file)
+            , mBuffer(std::max<size_t>(bufferBytes, 4096))
+        {
+        }
+
+        int Peek()
+        {
+            if (mPos == mEnd && Refill() == false) {
+                return EOF;
+            }
+            return static_cast<unsigned char>(mBuffer[mPos]);
+        }
+
+        int Get()
+        {
+            int c = Peek();
+            if (c != EOF) {
+                mPos++;
+            }
+            return c;
+        }
+
+        void SkipWhitespace()
+        {
+            do {
+                while (mPos < mEnd) {
+                    char c = mBuffer[mPos];
+                    if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                        return;
+                    }
+                    mPos++;
+                }
+            } while (Refill());
+        }
+
+        // Appends everything up to the next quote or backslash to out, returns that character, or EOF
+        int ReadStringRun(std::string& out)
+        {
+            do {
+                size_t start = mPos;
+                while (mPos < mEnd) {
+                    char c = mBuffer[mPos];
+                    if (c == '"' || c == '\\') {
+                        out.append(mBuffer.data() + start, mPos - start);
+                        return c;
+                    }
+                    mPos++;
+                }
+                out.append(mBuffer.data() + start, mPos - start);
+            } while (Refill());
+
+            return EOF;
+        }
+
+        // Reads a number or a literal, all the characters up to the next delimiter
+        void ReadToken(std::string& out)
+        {
+            out.clear();
+            do {
+                size_t start = mPos;
+                while (mPos < mEnd) {
+                    char c = mBuffer[mPos];
+                    bool bIsTokenChar = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+                    if (bIsTokenChar == false) {
+                        out.append(mBuffer.data() + start, mPos - start);
+                        return;
+                    }
+                    mPos++;
+                }
+                out.append(mBuffer.data() + start, mPos - start);
+            } while (Refill());
+        }
+
+        uint64_t GetOffset() const { return mBlockOffset + mPos; }
+        uint64_t GetBytesRead() const { return mBlockOffset + mEnd; }
+        bool HasReadError() const { return mbReadError; }
+
+    private:
+        bool Refill()
+        {
+            mBlockOffset += mEnd;
+            mPos = 0;
+            mEnd = std::fread(mBuffer.data(), 1, mBuffer.size(), mFile);
+            if (mEnd == 0 && std::ferror(mFile)) {
+                mbReadError = true;
+            }
+            return mEnd > 0;
+        }
+
+        FILE* mFile = nullptr;
+        std::vector<char> mBuffer;
+        size_t mPos = 0;
+        size_t mEnd = 0;
+        uint64_t mBlockOffset = 0; // file offset of mBuffer[0]
+        bool mbReadError = false;
+    };
+
+    void AppendUTF8(std::string& out, uint32_t codePoint)
+    {
+        if (codePoint < 0x80) {
+            out.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    bool ReadHex4(BlockReader& reader, uint32_t& outValue)
+    {
+        outValue = 0;
+        for (s32 i = 0; i < 4; ++i) {
+            int c = reader.Get();
+            outValue <<= 4;
+            if (c >= '0' && c <= '9') {
+                outValue |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                outValue |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                outValue |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the opening quote is consumed already
+    bool ReadString(BlockReader& reader, std::string& out, std::string& outError)
+    {
+        out.clear();
+
+        while (true) {
+            int stop = reader.ReadStringRun(out);
+            reader.Get();
+
+            if (stop == '"') {
+                return true;
+            }
+            if (stop == EOF) {
+                outError = "unterminated string";
+                return false;
+            }
+
+            int escaped = reader.Get();
+            switch (escaped) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t codePoint = 0;
+                if (ReadHex4(reader, codePoint) == false) {
+                    outError = "bad unicode escape";
+                    return false;
+                }
+
+                // a high surrogate is followed by the low half of the pair
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (reader.Get() != '\\' || reader.Get() != 'u' || ReadHex4(reader, low) == false || low < 0xDC00 || low > 0xDFFF) {
+                        outError = "bad surrogate pair";
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUTF8(out, codePoint);
+                break;
+            }
+            default:
+                outError = "bad escape sequence";
+                return false;
+            }
+        }
+    }
+
+    // Timestamps are mostly plain decimals, which skip strtod, anything with an exponent or too many digits goes through it
+    bool ParseNumber(const std::string& text, double& outValue)
+    {
+        const char* it = text.c_str();
+        const char* end = it + text.size();
+        bool bNegative = *it == '-';
+        it += bNegative ? 1 : 0;
+
+        uint64_t mantissa = 0;
+        s32 digitCount = 0;
+        s32 fractionDigits = 0;
+        bool bHasDot = false;
+        for (; it != end; ++it) {
+            if (*it >= '0' && *it <= '9') {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*it - '0');
+                digitCount++;
+                fractionDigits += bHasDot ? 1 : 0;
+            } else if (*it == '.' && bHasDot == false) {
+                bHasDot = true;
+            } else {
+                break;
+            }
+        }
+
+        if (it == end && digitCount > 0 && digitCount <= 18 && (bHasDot == false || fractionDigits > 0)) {
+            static const double kPowersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+            double value = static_cast<double>(mantissa) / kPowersOfTen[fractionDigits];
+            outValue = bNegative ? -value : value;
+            return true;
+        }
+
+        char* parseEnd = nullptr;
+        outValue = std::strtod(text.c_str(), &parseEnd);
+        return text.empty() == false && parseEnd == text.c_str() + text.size();
+    }
+
+    /*
+     Iterative SAX-style JSON parser, no document is built. The handler gets
+       StartObject(depth) / EndObject(depth), StartArray(depth) / EndArray(depth), Key(key, depth),
+       String(value, depth), Number(text, depth) and Literal(depth) for true, false and null,
+     where depth counts the open containers, the one being started or ended included.
+     An unterminated top-level array is accepted, the Chrome trace format allows leaving out the closing bracket.
+    */
+    template <typename Handler>
+    bool ParseJson(BlockReader& reader, Handler& handler, std::string& outError)
+    {
+        enum class eState {
+            Value,
+            ValueOrClose, // after '['
+            KeyOrClose, // after '{'
+            Key, // after ',' in an object
+            CommaOrClose,
+            Done,
+        };
+
+        std::vector<char> stack;
+        std::string text;
+        eState state = eState::Value;
+
+        auto afterValue = [&]() { state = stack.empty() ? eState::Done : eState::CommaOrClose; };
+
+        while (true) {
+            reader.SkipWhitespace();
+            int c = reader.Peek();
+
+            if (c == EOF) {
+                if (reader.HasReadError()) {
+                    outError = "read error";
+                    return false;
+                }
+                if (state == eState::Done) {
+                    return true;
+                }
+                if (stack.size() == 1 && stack[0] == '[' && state != eState::Key && state != eState::KeyOrClose) {
+                    handler.EndArray(1);
+                    return true;
+                }
+                outError = "unexpected end of file";
+                return false;
+            }
+
+            switch (state) {
+            case eState::Done:
+                outError = "unexpected data after the document";
+                return false;
+
+            case eState::ValueOrClose:
+                if (c == ']') {
+                    reader.Get();
+                    handler.EndArray(stack.size());
+                    stack.pop_back();
+                    afterValue();
+                } else {
+                    state = eState::Value;
+                }
+                break;
+
+            case eState::Value:
+                if (c == '{' || c == '[') {
+                    if (stack.size() >= kMaxJsonDepth) {
+                        outError = "nested too deeply";
+                        return false;
+                    }
+                    reader.Get();
+                    stack.push_back(static_cast<char>(c));
+                    if (c == '{') {
+                        handler.StartObject(stack.size());
+                        state = eState::KeyOrClose;
+                    } else {
+                        handler.StartArray(stack.size());
+                        state = eState::ValueOrClose;
+                    }
+                } else if (c == ']' && stack.empty() == false && stack.back() == '[') {
+                    // trailing comma
+                    reader.Get();
+                    handler.EndArray(stack.size());
+                    stack.pop_back();
+                    afterValue();
+                } else if (c == '"') {
+                    reader.Get();
+                    if (ReadString(reader, text, outError) == false) {
+                        return false;
+                    }
+                    handler.String(text, stack.size());
+                    afterValue();
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    // the handler converts the numbers it needs
+                    reader.ReadToken(text);
+                    handler.Number(text, stack.size());
+                    afterValue();
+                } else if (c == 't' || c == 'f' || c == 'n') {
+                    reader.ReadToken(text);
+                    if (text != "true" && text != "false" && text != "null") {
+                        outError = "unknown literal";
+                        return false;
+                    }
+                    handler.Literal(stack.size());
+                    afterValue();
+                } else {
+                    outError = "unexpected character";
+                    return false;
+                }
+                break;
+
+            case eState::KeyOrClose:
+                if (c == '}') {
+                    reader.Get();
+                    handler.EndObject(stack.size());
+                    stack.pop_back();
+                    afterValue();
+                } else {
+                    state = eState::Key;
+                }
+                break;
+
+            case eState::Key:
+                if (reader.Get() != '"' || ReadString(reader, text, outError) == false) {
+                    if (outError.empty()) {
+                        outError = "expected a key";
+                    }
+                    return false;
+                }
+                reader.SkipWhitespace();
+                if (reader.Get() != ':') {
+                    outError = "expected ':'";
+                    return false;
+                }
+                handler.Key(text, stack.size());
+                state = eState::Value;
+                break;
+
+            case eState::CommaOrClose: {
+                const char open = stack.back();
+                reader.Get();
+                if (c == ',') {
+                    state = open == '{' ? eState::Key : eState::Value;
+                } else if (c == (open == '{' ? '}' : ']')) {
+                    if (open == '{') {
+                        handler.EndObject(stack.size());
+                    } else {
+                        handler.EndArray(stack.size());
+                    }
+                    stack.pop_back();
+                    afterValue();
+                } else {
+                    outError = "expected ',' or the end of the container";
+                    return false;
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    // Turns the events of the trace into node descriptors, handed to mAddNodes a batch at a time
+    class TraceEventHandler
+    {
+    public:
+        using AddNodesFunction = std::function<size_t(std::vector<NodeInitDescriptor>&)>;
+
+        TraceEventHandler(ImTimeline::Timeline& timeline, const ImTimeline::sTraceImportSettings& settings, ImTimeline::sTraceImportStats& stats, AddNodesFunction addNodes)
+            : mTimeline(timeline)
+            , mSettings(settings)
+            , mStats(stats)
+            , mAddNodes(std::move(addNodes))
+            , mNextSection(settings.mFirstSection)
+        {
+            if (mAddNodes != nullptr) {
+                mBatch.reserve(std::max<size_t>(mSettings.mBatchNodeCount, 1));
+            }
+        }
+
+        void StartObject(size_t depth)
+        {
+            if (mEventArrayDepth > 0 && depth == mEventArrayDepth + 1) {
+                mbInEvent = true;
+                mEvent.Reset();
+            } else if (mbInEvent && depth == mEventArrayDepth + 2 && mField == eField::Args) {
+                mbInArgs = true;
+            }
+        }
+
+        void EndObject(size_t depth)
+        {
+            if (mbInEvent && depth == mEventArrayDepth + 2) {
+                mbInArgs = false;
+            } else if (mbInEvent && depth == mEventArrayDepth + 1) {
+                mbInEvent = false;
+                dispatchEvent();
+            }
+        }
+
+        void StartArray(size_t depth)
+        {
+            // the array format, or the traceEvents array of the object format
+            if (mEventArrayDepth == 0 && (depth == 1 || (depth == 2 && mTopLevelKey == "traceEvents"))) {
+                mEventArrayDepth = depth;
+            }
+        }
+
+        void EndArray(size_t depth)
+        {
+            if (depth == mEventArrayDepth) {
+                mEventArrayDepth = 0;
+            }
+        }
+
+        void Key(const std::string& key, size_t depth)
+        {
+            if (depth == 1) {
+                mTopLevelKey = key;
+            }
+
+            if (mbInEvent && depth == mEventArrayDepth + 1) {
+                mField = FieldFromKey(key);
+            } else if (mbInArgs && depth == mEventArrayDepth + 2) {
+                mbIsArgsName = key == "name";
+            }
+        }
+
+        void String(const std::string& value, size_t depth)
+        {
+            if (mbInEvent && depth == mEventArrayDepth + 1) {
+                switch (mField) {
+                case eField::Name: mEvent.mName = value; break;
+                case eField::Phase: mEvent.mPhase = value.empty() ? '\0' : value[0]; break;
+                case eField::Pid: mEvent.mPid = value; break;
+                case eField::Tid: mEvent.mTid = value; break;
+                case eField::Timestamp: mEvent.mbHasTimestamp = ParseNumber(value, mEvent.mTimestamp); break;
+                case eField::Duration: mEvent.mbHasDuration = ParseNumber(value, mEvent.mDuration); break;
+                default: break;
+                }
+            } else if (mbInArgs && mbIsArgsName && depth == mEventArrayDepth + 2) {
+                mEvent.mArgsName = value;
+            }
+        }
+
+        void Number(const std::string& text, size_t depth)
+        {
+            if (mbInEvent == false || depth != mEventArrayDepth + 1) {
+                return;
+            }
+
+            switch (mField) {
+            case eField::Timestamp: mEvent.mbHasTimestamp = ParseNumber(text, mEvent.mTimestamp); break;
+            case eField::Duration: mEvent.mbHasDuration = ParseNumber(text, mEvent.mDuration); break;
+            case eField::Pid: mEvent.mPid = text; break;
+            case eField::Tid: mEvent.mTid = text; break;
+            default: break;
+            }
+        }
+
+        void Literal(size_t /*depth*/) { }
+
+        // The origin pass only looks for the earliest duration event, frame 0 has to be known before the first node is added
+        void SetOriginPass(bool bIsOriginPass) { mbIsOriginPass = bIsOriginPass; }
+        bool HasOrigin() const { return mbHasOrigin; }
+        double GetOrigin() const { return mOrigin; }
+
+        void SetOrigin(double origin)
+        {
+            mOrigin = origin;
+            mbHasOrigin = true;
+        }
+
+        // Adds what's left of the last batch and names the sections, once the whole file is read
+        void Finish()
+        {
+            flushBatch();
+
+            for (auto& entry : mThreads) {
+                sThread& thread = entry.second;
+                mStats.mUnmatchedCount += thread.mOpenSlices.size();
+                if (thread.mSection >= 0) {
+                    mTimeline.SetTimelineName(thread.mSection, getSectionName(thread));
+                }
+            }
+        }
+
+    private:
+        enum class eField {
+            None,
+            Name,
+            Phase,
+            Timestamp,
+            Duration,
+            Pid,
+            Tid,
+            Args,
+        };
+
+        struct sEvent {
+            std::string mName;
+            std::string mPid;
+            std::string mTid;
+            std::string mArgsName;
+            char mPhase = '\0';
+            double mTimestamp = 0.0;
+            double mDuration = 0.0;
+            bool mbHasTimestamp = false;
+            bool mbHasDuration = false;
+
+            // clear keeps the capacity, the strings stop allocating after the first few events
+            void Reset()
+            {
+                mName.clear();
+                mPid.clear();
+                mTid.clear();
+                mArgsName.clear();
+                mPhase = '\0';
+                mbHasTimestamp = false;
+                mbHasDuration = false;
+            }
+        };
+
+        struct sOpenSlice {
+            std::string mName;
+            double mTimestamp = 0.0;
+        };
+
+        struct sThread {
+            std::string mPid;
+            std::string mTid;
+            std::string mName; // thread_name metadata
+            s32 mSection = -1; // created with the first node
+            std::vector<sOpenSlice> mOpenSlices; // 'B' events waiting for their 'E'
+        };
+
+        static eField FieldFromKey(const std::string& key)
+        {
+            if (key == "name") {
+                return eField::Name;
+            } else if (key == "ph") {
+                return eField::Phase;
+            } else if (key == "ts") {
+                return eField::Timestamp;
+            } else if (key == "dur") {
+                return eField::Duration;
+            } else if (key == "pid") {
+                return eField::Pid;
+            } else if (key == "tid") {
+                return eField::Tid;
+            } else if (key == "args") {
+                return eField::Args;
+            }
+            return eField::None;
+        }
+
+        sThread& getThread()
+        {
+            mThreadKey.assign(mEvent.mPid);
+            mThreadKey.push_back('/');
+            mThreadKey.append(mEvent.mTid);
+
+            auto it = mThreads.find(mThreadKey);
+            if (it == mThreads.end()) {
+                it = mThreads.emplace(mThreadKey, sThread()).first;
+                it->second.mPid = mEvent.mPid;
+                it->second.mTid = mEvent.mTid;
+            }
+            return it->second;
+        }
+
+        std::string getSectionName(const sThread& thread) const
+        {
+            auto itProcess = mProcessNames.find(thread.mPid);
+            std::string processName = itProcess != mProcessNames.end() ? itProcess->second + " (" + thread.mPid + ")" : "pid " + thread.mPid;
+            std::string threadName = thread.mName.empty() ? "tid " + thread.mTid : thread.mName + " (" + thread.mTid + ")";
+            return processName + " / " + threadName;
+        }
+
+        s32 toFrame(double timestamp)
+        {
+            double frame = std::round((timestamp - mOrigin) / mSettings.mMicrosecondsPerFrame);
+            if (frame < 0.0 || frame > static_cast<double>(INT_MAX - 1)) {
+                mbWasClamped = true;
+                return frame < 0.0 ? 0 : INT_MAX - 1;
+            }
+            return static_cast<s32>(frame);
+        }
+
+        void addNode(sThread& thread, const std::string& name, double start, double end)
+        {
+            if (thread.mSection < 0) {
+                while (mTimeline.HasSection(mNextSection)) {
+                    mNextSection++;
+                }
+                thread.mSection = mNextSection++;
+                mTimeline.InitializeTimelineSection(thread.mSection, getSectionName(thread));
+                mStats.mSectionCount++;
+            }
+
+            mbWasClamped = false;
+            s32 startFrame = toFrame(start);
+            s32 endFrame = std::max(toFrame(end), startFrame + 1); // slices shorter than a frame stay visible
+            mStats.mClampedCount += mbWasClamped ? 1 : 0;
+
+            mBatch.emplace_back();
+            NodeInitDescriptor& descriptor = mBatch.back();
+            descriptor.label = name;
+            descriptor.section = thread.mSection;
+            descriptor.start = startFrame;
+            descriptor.end = endFrame;
+
+            if (mBatch.size() >= mSettings.mBatchNodeCount) {
+                flushBatch();
+            }
+        }
+
+        void flushBatch()
+        {
+            if (mBatch.empty() == false) {
+                mStats.mNodeCount += mAddNodes(mBatch);
+                mBatch.clear();
+            }
+        }
+
+        void dispatchEvent()
+        {
+            // events aren't in timestamp order, a complete event comes after the slices nested in it
+            if (mbIsOriginPass) {
+                bool bIsDuration = mEvent.mPhase == 'X' || mEvent.mPhase == 'B' || mEvent.mPhase == 'E';
+                if (bIsDuration && mEvent.mbHasTimestamp && (mbHasOrigin == false || mEvent.mTimestamp < mOrigin)) {
+                    SetOrigin(mEvent.mTimestamp);
+                }
+                return;
+            }
+
+            mStats.mEventCount++;
+
+            switch (mEvent.mPhase) {
+            case 'X': {
+                if (mEvent.mbHasTimestamp == false) {
+                    mStats.mSkippedCount++;
+                    break;
+                }
+                addNode(getThread(), mEvent.mName, mEvent.mTimestamp, mEvent.mTimestamp + (mEvent.mbHasDuration ? mEvent.mDuration : 0.0));
+                break;
+            }
+            case 'B': {
+                sThread& thread = getThread();
+                thread.mOpenSlices.emplace_back();
+                thread.mOpenSlices.back().mName = mEvent.mName;
+                thread.mOpenSlices.back().mTimestamp = mEvent.mTimestamp;
+                break;
+            }
+            case 'E': {
+                sThread& thread = getThread();
+                if (thread.mOpenSlices.empty()) {
+                    mStats.mUnmatchedCount++;
+                    break;
+                }
+                sOpenSlice& slice = thread.mOpenSlices.back();
+                addNode(thread, slice.mName, slice.mTimestamp, mEvent.mTimestamp);
+                thread.mOpenSlices.pop_back();
+                break;
+            }
+            case 'M': {
+                if (mEvent.mName == "thread_name") {
+                    getThread().mName = mEvent.mArgsName;
+                } else if (mEvent.mName == "process_name") {
+                    mProcessNames[mEvent.mPid] = mEvent.mArgsName;
+                }
+                break;
+            }
+            default:
+                mStats.mSkippedCount++;
+                break;
+            }
+        }
+
+        ImTimeline::Timeline& mTimeline;
+        const ImTimeline::sTraceImportSettings& mSettings;
+        ImTimeline::sTraceImportStats& mStats;
+        AddNodesFunction mAddNodes;
+
+        // parser position
+        std::string mTopLevelKey;
+        size_t mEventArrayDepth = 0; // 0 outside of the event array
+        bool mbInEvent = false;
+        bool mbInArgs = false;
+        bool mbIsArgsName = false;
+        eField mField = eField::None;
+        sEvent mEvent;
+
+        std::unordered_map<std::string, sThread> mThreads; // "pid/tid" -> thread
+        std::unordered_map<std::string, std::string> mProcessNames; // pid -> process_name metadata
+        std::string mThreadKey;
+        s32 mNextSection = 0;
+        double mOrigin = 0.0; // timestamp of frame 0
+        bool mbHasOrigin = false;
+        bool mbIsOriginPass = false;
+        bool mbWasClamped = false;
+        std::vector<NodeInitDescriptor> mBatch;
+    };
+}
+
+bool ImTimeline::TimelineTraceImporter::Import(Timeline& aTimeline, const std::string& aPath, const sTraceImportSettings& aSettings, sTraceImportStats* outStats)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    sTraceImportStats stats;
+
+    FILE* file = std::fopen(aPath.c_str(), "rb");
+    if (file == nullptr || aSettings.mMicrosecondsPerFrame <= 0.0) {
+        LOG_WARNING_PRINTF("Could not import trace %s", aPath.c_str());
+        if (file != nullptr) {
+            std::fclose(file);
+        }
+        stats.mError = "could not open the file";
+        if (outStats != nullptr) {
+            *outStats = stats;
+        }
+        return false;
+    }
+
+    // the file is read twice, for the origin and for the nodes, which keeps memory to the nodes added
+    sTraceImportStats originStats;
+    TraceEventHandler originHandler(aTimeline, aSettings, originStats, nullptr);
+    originHandler.SetOriginPass(true);
+    {
+        BlockReader reader(file, aSettings.mReadBufferBytes);
+        ParseJson(reader, originHandler, originStats.mError); // an error is reported by the second pass
+    }
+    std::rewind(file);
+
+    // slices nest, moving overlapping nodes apart would break the timing of the trace
+    std::bitset<eTimelineNodeFlags::TimelineNodeFlags_Max> flags = aTimeline.mEmptyDummyNode.mFlags;
+    flags.set(eTimelineNodeFlags::TimelineNodeFlags_MoveSurroundingNodesToTheRight, false);
+
+    // The timeline is only locked while a batch goes in, not while the file is read. Each batch would be an undo step
+    // of its own, so the batches are added without commands and one step for the whole import is pushed at the end.
+    auto cmd = std::make_unique<ImTimelineInternal::AddCommand>(&aTimeline);
+    TraceEventHandler handler(aTimeline, aSettings, stats, [&aTimeline, &aSettings, &flags, &cmd](std::vector<NodeInitDescriptor>& batch) {
+        auto lock = aTimeline.lockForEdit();
+        if (aSettings.mbRecordUndo) {
+            for (NodeInitDescriptor& descriptor : batch) {
+                descriptor.ID = aTimeline.mIDGenerator.GetUniqueID();
+                cmd->mNodeIDs.push_back(descriptor.ID);
+            }
+        }
+
+        bool bWasEnabled = aTimeline.mEnableCommands;
+        aTimeline.SetCommandEnable(false);
+        size_t addedCount = aTimeline.addNodesBulk(batch.data(), batch.size(), flags);
+        aTimeline.SetCommandEnable(bWasEnabled);
+        return addedCount;
+    });
+    if (originHandler.HasOrigin()) {
+        handler.SetOrigin(originHandler.GetOrigin());
+    }
+
+    BlockReader reader(file, aSettings.mReadBufferBytes);
+    bool bParsed = ParseJson(reader, handler, stats.mError);
+    if (bParsed == false) {
+        stats.mErrorOffset = reader.GetOffset();
+    }
+    handler.Finish();
+    stats.mBytesRead = reader.GetBytesRead();
+    std::fclose(file);
+
+    if (cmd->mNodeIDs.empty() == false) {
+        auto lock = aTimeline.lockForEdit();
+        aTimeline.PushCommand(std::move(cmd));
+    }
+
+    stats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (bParsed) {
+        LOG_INFO_PRINTF("Imported %d node(s) in %d section(s) from %s, %.1f MB/s", static_cast<s32>(stats.mNodeCount), static_cast<s32>(stats.mSectionCount),
+            aPath.c_str(), stats.GetMegabytesPerSecond());
+    } else {
+        LOG_WARNING_PRINTF("Trace %s: %s at byte %llu, %d node(s) imported before it", aPath.c_str(), stats.mError.c_str(),
+            static_cast<unsigned long long>(stats.mErrorOffset), static_cast<s32>(stats.mNodeCount));
+    }
+
+    if (outStats != nullptr) {
+        *outStats = stats;
+    }
+
+    return bParsed;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "TimelineDefines.h"
+#include <cstdint>
+#include <string>
+
+namespace ImTimeline
+{
+   class Timeline;
+
+   struct sTraceImportSettings
+   {
+      double mMicrosecondsPerFrame = 1.0; // trace timestamps are in microseconds, frame 0 is the earliest event of the trace
+      s32 mFirstSection = 0; // threads go to the free sections from here on, sections that exist already are skipped
+      size_t mBatchNodeCount = 64 * 1024; // nodes handed to the bulk insert at once
+      size_t mReadBufferBytes = 1024 * 1024;
+      bool mbRecordUndo = false; // one undo step for the whole import, which holds on to the ID of every imported node
+   };
+
+   struct sTraceImportStats
+   {
+      uint64_t mBytesRead = 0;
+      size_t mEventCount = 0; // trace events of any type
+      size_t mNodeCount = 0;
+      size_t mSectionCount = 0;
+      size_t mUnmatchedCount = 0; // 'B' without an 'E' and the other way round
+      size_t mSkippedCount = 0; // events that aren't durations: instants, counters, async and flow events
+      size_t mClampedCount = 0; // nodes outside of the frame range, before the first event or past INT_MAX frames
+      double mSeconds = 0.0;
+      uint64_t mErrorOffset = 0; // byte offset of a syntax error
+      std::string mError;
+
+      double GetMegabytesPerSecond() const { return mSeconds > 0.0 ? mBytesRead / (1024.0 * 1024.0) / mSeconds : 0.0; }
+   };
+
+   /******
+    TimelineTraceImporter
+    =========================
+    - Imports a Chrome trace event file (the JSON array format, or an object with a traceEvents array), as written by
+     chrome://tracing, Perfetto and most profilers. The file is read in fixed-size blocks by a SAX-style parser, nothing
+     is kept of an event once it's turned into a node, so memory grows with the nodes added and not with the file size.
+     The time span doesn't matter either, the section summaries are bounded by the node count, see NodeSummaryPyramid.
+     It's read twice, first for the earliest timestamp, as events aren't in timestamp order.
+     Every process and thread pair becomes a section, named by the process_name and thread_name metadata events.
+     Complete events ('X') and matched begin/end pairs ('B'/'E') become nodes, added in batches through the bulk insert
+     path. The timeline is only locked while a batch is added, playback carries on while the file is read.
+     Nodes are added without the default MoveSurroundingNodesToTheRight flag, nested slices keep their timing.
+     Rebuilding a section doesn't look at the flag though: the first edit that rebuilds an imported section, such as
+     moving one of its nodes, moves every overlapping node apart and flattens the nesting.
+    */
+   class TimelineTraceImporter
+   {
+   public:
+      // Nodes parsed before a syntax error are kept, the error is reported in the stats
+      static bool Import(Timeline& aTimeline, const std::string& aPath, const sTraceImportSettings& aSettings = sTraceImportSettings(), sTraceImportStats* outStats = nullptr);
+   };
+}
@@ -1,8 +1,64 @@
 #pragma once
 #include <iostream>
 #include <functional>
+#include <algorithm>
+#include <climits>
+#include <type_traits>
 #include "../TimelineCore/TimelineDefines.h"
 
+class NodeSummaryPyramid;
+
+namespace ImDataControllerDetail
+{
+    // visitors may return void or bool, false stops the iteration
+    template <typename F>
+    inline bool InvokeVisitor(F& visitor, TimelineNode& node)
+    {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, TimelineNode&>, bool>) {
+            return visitor(node);
+        } else {
+            visitor(node);
+            return true;
+        }
+    }
+
+    // lower bound for the start of a node that can still reach 'start', clamped so it doesn't wrap around
+    inline s32 LookbackStart(s32 start, s32 maxDuration)
+    {
+        return start >= INT_MIN + maxDuration ? start - maxDuration : INT_MIN;
+    }
+}
+
+// Non-owning reference to a node visitor. Crossing the virtual interface through this costs one indirect call per node
+// and, unlike std::function, never allocates.
+class NodeVisitor {
+public:
+    template <typename F, typename = std::enable_if_t<std::is_same_v<std::decay_t<F>, NodeVisitor> == false>>
+    explicit NodeVisitor(F& visitor)
+        : mContext(const_cast<void*>(static_cast<const void*>(&visitor)))
+        , mInvoke([](void* context, TimelineNode& node) { return ImDataControllerDetail::InvokeVisitor(*static_cast<F*>(context), node); })
+    {
+    }
+
+    bool operator()(TimelineNode& node) const { return mInvoke(mContext, node); }
+
+private:
+    void* mContext = nullptr;
+    bool (*mInvoke)(void*, TimelineNode&) = nullptr;
+};
+
+// Nodes stored back to back and sorted by start. mMaxDuration bounds end - start of every node in the span.
+struct NodeSpan {
+    TimelineNode* mBegin = nullptr;
+    TimelineNode* mEnd = nullptr;
+    s32 mMaxDuration = 0;
+
+    TimelineNode* begin() const { return mBegin; }
+    TimelineNode* end() const { return mEnd; }
+    size_t size() const { return static_cast<size_t>(mEnd - mBegin); }
+    bool empty() const { return mBegin == mEnd; }
+};
+
 class ImDataController {
 public:
     ImDataController() { }
@@ -17,12 +73,147 @@ public:
     virtual void iterate(const std::function<void(TimelineNode&)>& func) = 0;
     virtual int rebuild(const NodeInitDescriptor& descriptor) = 0;
 
+    // Adds nodes that are sorted by start, after existing nodes with an equal start like emplace_back_direct does.
+    // Returns the number of nodes added. The default implementation inserts them one by one, containers that keep
+    // their nodes in start order should override this with a single merge.
+    virtual int emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor = NodeInitDescriptor())
+    {
+        for (TimelineNode& node : sortedNodes) {
+            emplace_back_direct(node, descriptor);
+        }
+        return static_cast<int>(sortedNodes.size());
+    }
+
+    // Deletes the nodes with the given IDs, returns how many were found. The default implementation deletes the range of
+    // each node, which also takes other nodes lying completely inside it, containers with an ID index should override this.
+    virtual int delete_nodes(const std::vector<NodeID>& ids)
+    {
+        int deleteCount = 0;
+        for (NodeID id : ids) {
+            NodeInitDescriptor descriptor;
+            descriptor.ID = id;
+            TimelineNode* node = get_node_id(descriptor);
+            if (node != nullptr) {
+                descriptor.start = node->start;
+                descriptor.end = node->end;
+                descriptor.section = node->GetSection();
+                deleteCount += delete_node(descriptor) > 0 ? 1 : 0;
+            }
+        }
+        return deleteCount;
+    }
+
     virtual TimelineNode* get_node_id(const NodeInitDescriptor& descriptor) = 0;
     virtual std::vector<TimelineNode*> get_node_range(const NodeInitDescriptor& descriptor) = 0;
 
+    // Nodes that intersect [descriptor.start, descriptor.end], unlike get_node_range which only returns fully contained nodes.
+    virtual std::vector<TimelineNode*> get_node_overlap(const NodeInitDescriptor& descriptor)
+    {
+        std::vector<TimelineNode*> nodes;
+        for_each_in_range(descriptor.start, descriptor.end, [&nodes](TimelineNode& node) { nodes.push_back(&node); });
+        return nodes;
+    }
+
+    // Containers that keep their nodes in one sorted array expose it here, for_each_in_range then runs entirely inline.
+    virtual bool get_contiguous_span(NodeSpan& /*outSpan*/) { return false; }
+
+    // Calls visitor for every node intersecting [start, end] in start order until it returns false.
+    // The default implementation is a linear scan, containers with an index should override this.
+    virtual void visit_overlap(s32 start, s32 end, const NodeVisitor& visitor)
+    {
+        NodeSpan span;
+        if (get_contiguous_span(span)) {
+            visitSpan(span, start, end, visitor);
+            return;
+        }
+
+        bool bStopped = false;
+        iterate([&](TimelineNode& node) {
+            if (bStopped == false && node.start <= end && node.end >= start) {
+                bStopped = visitor(node) == false;
+            }
+        });
+    }
+
+    // Allocation-free range query, the visitor is inlined for contiguous containers and goes through one
+    // indirect call per node otherwise. It may return bool to stop early, and must not add or delete nodes.
+    template <typename F>
+    void for_each_in_range(s32 start, s32 end, F&& visitor)
+    {
+        NodeSpan span;
+        if (get_contiguous_span(span)) {
+            visitSpan(span, start, end, visitor);
+            return;
+        }
+
+        visit_overlap(start, end, NodeVisitor(visitor));
+    }
+
+    template <typename F>
+    void for_each_node(F&& visitor)
+    {
+        for_each_in_range(INT_MIN, INT_MAX, visitor);
+    }
+
+    // Start-order position access for cursors that walk a section node by node.
+    // The default implementations are linear scans, containers with an ordered index should override them.
+    virtual size_t node_count()
+    {
+        size_t count = 0;
+        iterate([&count](TimelineNode&) { count++; });
+        return count;
+    }
+
+    virtual TimelineNode* get_node_at(size_t index)
+    {
+        TimelineNode* result = nullptr;
+        size_t current = 0;
+        iterate([&](TimelineNode& node) {
+            if (current++ == index) {
+                result = &node;
+            }
+        });
+        return result;
+    }
+
+    // Index of the first node starting after timestamp, node_count() if there is none
+    virtual size_t find_first_after(s32 timestamp)
+    {
+        size_t index = 0;
+        iterate([&](TimelineNode& node) {
+            if (node.start <= timestamp) {
+                index++;
+            }
+        });
+        return index;
+    }
+
+    // Changes whenever nodes are added, erased or reordered, which tells cursors that their index has to be sought again
+    u32 get_version() const { return mVersion; }
+
+    // Zoomed-out occupancy of the section, nullptr when the container doesn't maintain one
+    virtual const NodeSummaryPyramid* get_summary() const { return nullptr; }
+
     virtual void PerformanceDebugUI() const { }
 
     virtual void OnFinalize() { }
 
-   
+protected:
+    void mark_modified() { mVersion++; }
+
+    template <typename F>
+    static void visitSpan(const NodeSpan& span, s32 start, s32 end, F& visitor)
+    {
+        s32 scanFrom = ImDataControllerDetail::LookbackStart(start, span.mMaxDuration);
+        TimelineNode* it = std::lower_bound(span.begin(), span.end(), scanFrom, [](const TimelineNode& node, s32 value) { return node.start < value; });
+
+        for (; it != span.end() && it->start <= end; ++it) {
+            if (it->end >= start && ImDataControllerDetail::InvokeVisitor(visitor, *it) == false) {
+                return;
+            }
+        }
+    }
+
+private:
+    u32 mVersion = 0;
 };
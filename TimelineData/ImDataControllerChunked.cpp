@@ -0,0 +1,376 @@
+#include "ImDataControllerChunked.h"
+#include "../Core/ImTimelineLog.h"
+#include <algorithm>
+#include <iterator>
+
+ChunkedContainer::ChunkedContainer(size_t chunkNodeCount)
+    : ImDataController()
+    , mChunkNodeCount(chunkNodeCount > 0 ? chunkNodeCount : 1)
+{
+}
+
+ChunkedContainer::~ChunkedContainer()
+{
+    mOrder.clear();
+    mIDIndex.clear();
+    mChunks.clear();
+}
+
+/* SLOT ALLOCATION */
+
+ChunkedContainer::sSlotRef ChunkedContainer::allocateSlot(const TimelineNode& node)
+{
+    // every chunk before the hint is either full or released
+    size_t chunkIndex = mChunkWithSpaceHint;
+    for (; chunkIndex < mChunks.size(); ++chunkIndex) {
+        const sChunk* chunk = mChunks[chunkIndex].get();
+        if (chunk == nullptr || chunk->mFreeSlots.empty() == false || chunk->mNodes.size() < mChunkNodeCount) {
+            break;
+        }
+    }
+
+    if (chunkIndex == mChunks.size()) {
+        mChunks.emplace_back();
+    }
+
+    if (mChunks[chunkIndex] == nullptr) {
+        mChunks[chunkIndex] = std::make_unique<sChunk>();
+        mChunks[chunkIndex]->mNodes.reserve(mChunkNodeCount);
+        mAllocatedChunkCount++;
+    }
+
+    mChunkWithSpaceHint = chunkIndex;
+    sChunk& chunk = *mChunks[chunkIndex];
+
+    sSlotRef ref;
+    ref.mChunk = static_cast<u32>(chunkIndex);
+
+    if (chunk.mFreeSlots.empty() == false) {
+        ref.mSlot = chunk.mFreeSlots.back();
+        chunk.mFreeSlots.pop_back();
+        chunk.mNodes[ref.mSlot] = node;
+    } else {
+        IM_ASSERT(chunk.mNodes.size() < chunk.mNodes.capacity()); // growing would move every node in the chunk
+        ref.mSlot = static_cast<u32>(chunk.mNodes.size());
+        chunk.mNodes.push_back(node);
+    }
+
+    ref.mNode = &chunk.mNodes[ref.mSlot];
+    chunk.mAliveCount++;
+
+    return ref;
+}
+
+void ChunkedContainer::releaseSlot(const sSlotRef& ref)
+{
+    IM_ASSERT(ref.mChunk < mChunks.size() && mChunks[ref.mChunk] != nullptr);
+    sChunk& chunk = *mChunks[ref.mChunk];
+
+    chunk.mNodes[ref.mSlot] = TimelineNode(); // drop the label and custom node right away
+    chunk.mFreeSlots.push_back(ref.mSlot);
+    chunk.mAliveCount--;
+
+    if (chunk.mAliveCount == 0) {
+        mChunks[ref.mChunk].reset();
+        mAllocatedChunkCount--;
+
+        while (mChunks.empty() == false && mChunks.back() == nullptr) {
+            mChunks.pop_back();
+        }
+    }
+
+    mChunkWithSpaceHint = std::min(mChunkWithSpaceHint, static_cast<size_t>(ref.mChunk));
+}
+
+size_t ChunkedContainer::lowerBound(s32 start) const
+{
+    auto it = std::lower_bound(mOrder.begin(), mOrder.end(), start, [](const sSlotRef& ref, s32 value) { return ref.mNode->start < value; });
+    return static_cast<size_t>(it - mOrder.begin());
+}
+
+size_t ChunkedContainer::upperBound(s32 start) const
+{
+    auto it = std::upper_bound(mOrder.begin(), mOrder.end(), start, [](s32 value, const sSlotRef& ref) { return value < ref.mNode->start; });
+    return static_cast<size_t>(it - mOrder.begin());
+}
+
+/* CONTAINER INTERFACE */
+
+void ChunkedContainer::iterate(const std::function<void(TimelineNode&)>& func)
+{
+    for (const sSlotRef& ref : mOrder) {
+        func(*ref.mNode);
+    }
+}
+
+TimelineNode& ChunkedContainer::emplace_back_direct(TimelineNode& newElement, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    s32 start = newElement.start;
+    s32 end = newElement.end;
+
+    if (descriptor.bMoveOverlappingNext && start < 0) {
+        end -= start;
+        start = 0;
+    }
+
+    size_t index = upperBound(start);
+
+    sSlotRef ref = allocateSlot(newElement);
+    ref.mNode->start = start;
+    ref.mNode->end = end;
+    mOrder.insert(mOrder.begin() + index, ref);
+    mMaxDuration = std::max(mMaxDuration, end - start);
+    mSummary.add(start, end);
+    mark_modified();
+
+    if (ref.mNode->GetID() != InvalidNodeID) {
+        mIDIndex[ref.mNode->GetID()] = ref.mNode;
+    }
+
+    if (descriptor.bMoveOverlappingNext) {
+        fix_overlap_from(index, index);
+    }
+
+    LOG_INFO_PRINTF("Emplaced node ID %d in section %d (start %d)", (s32)ref.mNode->GetID(), ref.mNode->GetSection(), ref.mNode->start);
+
+    return *ref.mNode;
+}
+
+int ChunkedContainer::emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    if (sortedNodes.empty()) {
+        return 0;
+    }
+
+    IM_ASSERT(std::is_sorted(sortedNodes.begin(), sortedNodes.end(), [](const TimelineNode& a, const TimelineNode& b) { return a.start < b.start; }));
+
+    // clamping negative starts to 0 keeps the nodes sorted
+    std::vector<sSlotRef> added;
+    added.reserve(sortedNodes.size());
+
+    for (TimelineNode& newElement : sortedNodes) {
+        sSlotRef ref = allocateSlot(newElement);
+        if (descriptor.bMoveOverlappingNext && ref.mNode->start < 0) {
+            ref.mNode->end -= ref.mNode->start;
+            ref.mNode->start = 0;
+        }
+
+        mMaxDuration = std::max(mMaxDuration, ref.mNode->end - ref.mNode->start);
+        mSummary.add(ref.mNode->start, ref.mNode->end);
+        if (ref.mNode->GetID() != InvalidNodeID) {
+            mIDIndex[ref.mNode->GetID()] = ref.mNode;
+        }
+        added.push_back(ref);
+    }
+
+    size_t firstInserted = upperBound(added.front().mNode->start);
+
+    // only the nodes starting after the first new one take part in the merge, batches that arrive roughly in time order,
+    // like a streamed import, cost the size of the batch rather than the size of the section
+    // existing nodes come first on equal starts, the same order single inserts end up in
+    size_t existingCount = mOrder.size();
+    mOrder.insert(mOrder.end(), added.begin(), added.end());
+    std::inplace_merge(mOrder.begin() + firstInserted, mOrder.begin() + existingCount, mOrder.end(),
+        [](const sSlotRef& a, const sSlotRef& b) { return a.mNode->start < b.mNode->start; });
+    mark_modified();
+
+    if (descriptor.bMoveOverlappingNext) {
+        fix_overlap_from(firstInserted, upperBound(added.back().mNode->start) - 1);
+    }
+
+    LOG_INFO_PRINTF("Emplaced %d nodes in section %d", static_cast<s32>(added.size()), added.front().mNode->GetSection());
+
+    return static_cast<int>(added.size());
+}
+
+int ChunkedContainer::delete_nodes(const std::vector<NodeID>& ids)
+{
+    std::unordered_map<NodeID, TimelineNode*> deleted;
+    deleted.reserve(ids.size());
+    s32 minStart = INT_MAX;
+    s32 maxStart = INT_MIN;
+
+    for (NodeID id : ids) {
+        auto itIndex = mIDIndex.find(id);
+        if (itIndex != mIDIndex.end()) {
+            minStart = std::min(minStart, itIndex->second->start);
+            maxStart = std::max(maxStart, itIndex->second->start);
+            deleted.insert(*itIndex);
+            mIDIndex.erase(itIndex);
+        }
+    }
+
+    if (deleted.empty()) {
+        return 0;
+    }
+
+    // one compaction of the window of the order holding the nodes, whatever their number
+    size_t first = lowerBound(minStart);
+    size_t last = upperBound(maxStart);
+    size_t write = first;
+    for (size_t read = first; read < last; ++read) {
+        const sSlotRef ref = mOrder[read];
+        auto itDeleted = deleted.find(ref.mNode->GetID());
+
+        if (itDeleted != deleted.end() && itDeleted->second == ref.mNode) {
+            mSummary.remove(ref.mNode->start, ref.mNode->end);
+            releaseSlot(ref);
+        } else {
+            mOrder[write++] = ref;
+        }
+    }
+    mOrder.erase(mOrder.begin() + write, mOrder.begin() + last);
+    mark_modified();
+
+    LOG_INFO_PRINTF("Deleted %d node(s) by ID", static_cast<s32>(deleted.size()));
+
+    return static_cast<int>(deleted.size());
+}
+
+// Everything before the first inserted node is free of overlap, so the sweep starts at the node before it. Past the
+// last inserted node, the first node that fits ends it.
+void ChunkedContainer::fix_overlap_from(size_t firstInserted, size_t lastInserted)
+{
+    size_t first = firstInserted > 0 ? firstInserted - 1 : firstInserted;
+
+    for (size_t i = first; i + 1 < mOrder.size(); ++i) {
+        const TimelineNode& current = *mOrder[i].mNode;
+        TimelineNode& next = *mOrder[i + 1].mNode;
+
+        if (next.start < current.end) {
+            int duration = next.end - next.start;
+            mSummary.remove(next.start, next.end);
+            next.start = current.end + 1;
+            next.end = next.start + duration;
+            mSummary.add(next.start, next.end);
+        } else if (i + 1 > lastInserted) {
+            break;
+        }
+    }
+}
+
+int ChunkedContainer::rebuild(const NodeInitDescriptor& /*descriptor*/)
+{
+    std::stable_sort(mOrder.begin(), mOrder.end(), [](const sSlotRef& a, const sSlotRef& b) { return a.mNode->start < b.mNode->start; });
+
+    // nodes might have been edited in place, so the summary can't be patched here
+    mMaxDuration = 0;
+    mSummary.clear();
+    mark_modified();
+    for (size_t i = 0; i < mOrder.size(); ++i) {
+        TimelineNode& node = *mOrder[i].mNode;
+        if (node.start < 0) {
+            int offsetFrom0 = 0 - node.start;
+            node.start = 0;
+            node.end += offsetFrom0;
+        }
+
+        if (i + 1 < mOrder.size()) {
+            TimelineNode& next = *mOrder[i + 1].mNode;
+            if (next.start < node.end) {
+                int duration = next.end - next.start;
+                next.start = node.end + 1;
+                next.end = next.start + duration;
+            }
+        }
+
+        mMaxDuration = std::max(mMaxDuration, node.end - node.start);
+        mSummary.add(node.start, node.end);
+    }
+
+    return 0;
+}
+
+int ChunkedContainer::delete_node(const NodeInitDescriptor& descriptor)
+{
+    // a contained node starts inside the range, so only that window of the order has to be visited
+    size_t first = lowerBound(descriptor.start);
+    size_t last = upperBound(descriptor.end);
+
+    int deleteCount = 0;
+    size_t write = first;
+
+    for (size_t read = first; read < last; ++read) {
+        const sSlotRef ref = mOrder[read];
+        if (ref.mNode->end <= descriptor.end) {
+            auto itIndex = mIDIndex.find(ref.mNode->GetID());
+            if (itIndex != mIDIndex.end() && itIndex->second == ref.mNode) {
+                mIDIndex.erase(itIndex);
+            }
+            mSummary.remove(ref.mNode->start, ref.mNode->end);
+            releaseSlot(ref);
+            deleteCount++;
+        } else {
+            mOrder[write++] = ref;
+        }
+    }
+
+    mOrder.erase(mOrder.begin() + write, mOrder.begin() + last);
+
+    if (deleteCount > 0) {
+        mark_modified();
+    }
+
+    if (deleteCount == 0) {
+        LOG_INFO_PRINTF("Trying to delete a node in section %d but no node was deleted...", descriptor.section);
+    } else {
+        LOG_INFO_PRINTF("Deleted %d node(s) between %d and %d", deleteCount, descriptor.start, descriptor.end);
+    }
+
+    return deleteCount;
+}
+
+TimelineNode* ChunkedContainer::get_node_id(const NodeInitDescriptor& descriptor)
+{
+    auto it = mIDIndex.find(descriptor.ID);
+    if (it == mIDIndex.end()) {
+        return nullptr;
+    }
+
+    return it->second;
+}
+
+std::vector<TimelineNode*> ChunkedContainer::get_node_range(const NodeInitDescriptor& descriptor)
+{
+    std::vector<TimelineNode*> nodes;
+
+    size_t first = lowerBound(descriptor.start);
+    size_t last = upperBound(descriptor.end);
+
+    for (size_t i = first; i < last; ++i) {
+        if (mOrder[i].mNode->end <= descriptor.end) {
+            nodes.push_back(mOrder[i].mNode);
+        }
+    }
+
+    return nodes;
+}
+
+void ChunkedContainer::visit_overlap(s32 start, s32 end, const NodeVisitor& visitor)
+{
+    size_t first = lowerBound(ImDataControllerDetail::LookbackStart(start, mMaxDuration));
+    size_t last = upperBound(end);
+
+    for (size_t i = first; i < last; ++i) {
+        if (mOrder[i].mNode->end >= start && visitor(*mOrder[i].mNode) == false) {
+            return;
+        }
+    }
+}
+
+void ChunkedContainer::PerformanceDebugUI() const
+{
+    size_t nodeCountAllocated = mAllocatedChunkCount * mChunkNodeCount;
+    size_t totalSizeBytes = sizeof(*this)
+        + mChunks.capacity() * sizeof(std::unique_ptr<sChunk>)
+        + mAllocatedChunkCount * (sizeof(sChunk) + mChunkNodeCount * sizeof(TimelineNode))
+        + mOrder.capacity() * sizeof(sSlotRef);
+
+    double sizeInKB = static_cast<double>(totalSizeBytes) / 1024;
+
+    ImGui::Text("Timeline Data Size: %.2f KB", sizeInKB);
+    ImGui::SameLine();
+    ImGui::Text("Allocated Node Count: %d (%d chunks)", (s32)nodeCountAllocated, (s32)mAllocatedChunkCount);
+    ImGui::SameLine();
+    ImGui::Text("Displayed Node Count: %d", (s32)mOrder.size());
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "ImDataController.h"
+#include "ImDataSummaryPyramid.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+/******
+ ChunkedContainer
+ =========================
+ - Nodes live in fixed-size chunks that are allocated on demand and released once they're empty, so a section only
+  pays for the nodes it holds and there is no upper limit on the node count.
+  A chunk never reallocates, which keeps every TimelineNode pointer valid for as long as the node exists.
+  Erased slots are reused by later inserts. The start order is kept in a separate array of slot references.
+ */
+class ChunkedContainer : public ImDataController {
+public:
+    ChunkedContainer(size_t chunkNodeCount);
+
+    virtual void iterate(const std::function<void(TimelineNode&)>& func) override;
+    TimelineNode& emplace_back_direct(TimelineNode& node, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    virtual int rebuild(const NodeInitDescriptor& descriptor) override;
+    int delete_node(const NodeInitDescriptor& descriptor) override;
+    int emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    int delete_nodes(const std::vector<NodeID>& ids) override;
+    TimelineNode* get_node_id(const NodeInitDescriptor& descriptor) override;
+    std::vector<TimelineNode*> get_node_range(const NodeInitDescriptor& descriptor) override;
+    void visit_overlap(s32 start, s32 end, const NodeVisitor& visitor) override;
+    const NodeSummaryPyramid* get_summary() const override { return &mSummary; }
+    size_t node_count() override { return mOrder.size(); }
+    TimelineNode* get_node_at(size_t index) override { return index < mOrder.size() ? mOrder[index].mNode : nullptr; }
+    size_t find_first_after(s32 timestamp) override { return upperBound(timestamp); }
+
+    virtual void PerformanceDebugUI() const override;
+
+    virtual ~ChunkedContainer() override;
+
+private:
+    struct sChunk {
+        std::vector<TimelineNode> mNodes; // reserved once, never grows past the chunk size
+        std::vector<u32> mFreeSlots;
+        size_t mAliveCount = 0;
+    };
+
+    struct sSlotRef {
+        TimelineNode* mNode = nullptr;
+        u32 mChunk = 0;
+        u32 mSlot = 0;
+    };
+
+    sSlotRef allocateSlot(const TimelineNode& node);
+    void releaseSlot(const sSlotRef& ref);
+    void fix_overlap_from(size_t firstInserted, size_t lastInserted);
+    size_t lowerBound(s32 start) const;
+    size_t upperBound(s32 start) const;
+
+    size_t mChunkNodeCount = 0;
+    std::vector<std::unique_ptr<sChunk>> mChunks; // released chunks leave a nullptr behind so chunk indices stay valid
+    size_t mChunkWithSpaceHint = 0;
+    size_t mAllocatedChunkCount = 0;
+
+    std::vector<sSlotRef> mOrder; // sorted by start
+    s32 mMaxDuration = 0; // upper bound of end - start, bounds how far back an overlap scan has to look
+    NodeSummaryPyramid mSummary;
+    std::unordered_map<NodeID, TimelineNode*> mIDIndex;
+};
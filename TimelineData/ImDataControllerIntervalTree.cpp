@@ -0,0 +1,525 @@
+#include "ImDataControllerIntervalTree.h"
+#include "../Core/ImTimelineLog.h"
+#include <algorithm>
+#include <cmath>
+
+IntervalTreeContainer::IntervalTreeContainer()
+    : ImDataController()
+{
+}
+
+IntervalTreeContainer::~IntervalTreeContainer()
+{
+    destroy(mRoot);
+    mRoot = nullptr;
+    mNodeCount = 0;
+    mIDIndex.clear();
+}
+
+/* TREAP HELPERS */
+
+void IntervalTreeContainer::update(sTreeNode* t)
+{
+    if (t == nullptr) {
+        return;
+    }
+
+    s32 maxEnd = t->mData.end;
+    if (t->mLeft && t->mLeft->mMaxEnd > maxEnd) {
+        maxEnd = t->mLeft->mMaxEnd;
+    }
+    if (t->mRight && t->mRight->mMaxEnd > maxEnd) {
+        maxEnd = t->mRight->mMaxEnd;
+    }
+    t->mMaxEnd = maxEnd;
+    t->mSize = 1 + size(t->mLeft) + size(t->mRight);
+}
+
+// outLeft receives all nodes with start <= key, so equal starts keep their insertion order
+void IntervalTreeContainer::split(sTreeNode* t, s32 key, sTreeNode*& outLeft, sTreeNode*& outRight)
+{
+    if (t == nullptr) {
+        outLeft = nullptr;
+        outRight = nullptr;
+        return;
+    }
+
+    if (t->mData.start <= key) {
+        split(t->mRight, key, t->mRight, outRight);
+        outLeft = t;
+    } else {
+        split(t->mLeft, key, outLeft, t->mLeft);
+        outRight = t;
+    }
+
+    update(t);
+}
+
+IntervalTreeContainer::sTreeNode* IntervalTreeContainer::merge(sTreeNode* left, sTreeNode* right)
+{
+    if (left == nullptr) {
+        return right;
+    }
+    if (right == nullptr) {
+        return left;
+    }
+
+    if (left->mPriority > right->mPriority) {
+        left->mRight = merge(left->mRight, right);
+        update(left);
+        return left;
+    }
+
+    right->mLeft = merge(left, right->mLeft);
+    update(right);
+    return right;
+}
+
+void IntervalTreeContainer::destroy(sTreeNode* t)
+{
+    if (t == nullptr) {
+        return;
+    }
+    destroy(t->mLeft);
+    destroy(t->mRight);
+    delete t;
+}
+
+s32 IntervalTreeContainer::depth(const sTreeNode* t)
+{
+    if (t == nullptr) {
+        return 0;
+    }
+    return 1 + std::max(depth(t->mLeft), depth(t->mRight));
+}
+
+u32 IntervalTreeContainer::nextPriority()
+{
+    // xorshift32, priorities only need to be well distributed to keep the treap balanced
+    mRandomState ^= mRandomState << 13;
+    mRandomState ^= mRandomState >> 17;
+    mRandomState ^= mRandomState << 5;
+    return mRandomState;
+}
+
+/* CONTAINER INTERFACE */
+
+void IntervalTreeContainer::iterate(const std::function<void(TimelineNode&)>& func)
+{
+    iterate(mRoot, func);
+}
+
+void IntervalTreeContainer::iterate(sTreeNode* t, const std::function<void(TimelineNode&)>& func)
+{
+    if (t == nullptr) {
+        return;
+    }
+    iterate(t->mLeft, func);
+    func(t->mData);
+    iterate(t->mRight, func);
+}
+
+TimelineNode& IntervalTreeContainer::emplace_back_direct(TimelineNode& newElement, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    sTreeNode* newNode = new sTreeNode();
+    newNode->mData = newElement;
+    newNode->mPriority = nextPriority();
+
+    if (descriptor.bMoveOverlappingNext && newNode->mData.start < 0) {
+        int offsetFrom0 = 0 - newNode->mData.start;
+        newNode->mData.start = 0;
+        newNode->mData.end += offsetFrom0;
+    }
+    update(newNode);
+
+    const s32 key = newNode->mData.start;
+
+    // the node ending right before the insertion point, needed to resolve overlap with the new node
+    sTreeNode* previous = nullptr;
+    for (sTreeNode* t = mRoot; t != nullptr;) {
+        if (t->mData.start < key) {
+            previous = t;
+            t = t->mRight;
+        } else {
+            t = t->mLeft;
+        }
+    }
+
+    sTreeNode* left = nullptr;
+    sTreeNode* right = nullptr;
+    split(mRoot, key, left, right);
+    mRoot = merge(merge(left, newNode), right);
+    mNodeCount++;
+    mSummary.add(newNode->mData.start, newNode->mData.end);
+    mark_modified();
+
+    if (newNode->mData.GetID() != InvalidNodeID) {
+        mIDIndex[newNode->mData.GetID()] = newNode;
+    }
+    mbDepthDirty = true;
+
+    if (descriptor.bMoveOverlappingNext) {
+        // Only the nodes after the insertion point can be pushed, and shifting keeps their relative order intact
+        sOverlapSweep sweep;
+        sweep.mInserted = newNode;
+        sweep.mbHasPrevious = previous != nullptr;
+        sweep.mEndPrevious = previous ? previous->mData.end : 0;
+        sweepOverlap(mRoot, key, sweep);
+    }
+
+    LOG_INFO_PRINTF("Emplaced node ID %d in section %d (start %d)", (s32)newNode->mData.GetID(), newNode->mData.GetSection(), newNode->mData.start);
+
+    return newNode->mData;
+}
+
+void IntervalTreeContainer::sweepOverlap(sTreeNode* t, s32 key, sOverlapSweep& sweep)
+{
+    if (t == nullptr || sweep.mbDone) {
+        return;
+    }
+
+    if (t->mData.start >= key) {
+        sweepOverlap(t->mLeft, key, sweep);
+
+        if (sweep.mbDone == false) {
+            TimelineNode& node = t->mData;
+            bool bShifted = false;
+
+            if (sweep.mbHasPrevious && node.start < sweep.mEndPrevious) {
+                int duration = node.end - node.start;
+                mSummary.remove(node.start, node.end);
+                node.start = sweep.mEndPrevious + 1;
+                node.end = node.start + duration;
+                mSummary.add(node.start, node.end);
+                bShifted = true;
+            }
+
+            if (bShifted == false && sweep.mbPassedInserted) {
+                sweep.mbDone = true;
+            } else {
+                sweep.mbPassedInserted |= (t == sweep.mInserted);
+                sweep.mbHasPrevious = true;
+                sweep.mEndPrevious = node.end;
+            }
+        }
+    }
+
+    sweepOverlap(t->mRight, key, sweep);
+    update(t);
+}
+
+int IntervalTreeContainer::rebuild(const NodeInitDescriptor& /*descriptor*/)
+{
+    std::vector<sTreeNode*> sorted;
+    sorted.reserve(mNodeCount);
+    collect(mRoot, sorted);
+
+    // nodes might have been edited in place, so the order is re-established from scratch
+    std::stable_sort(sorted.begin(), sorted.end(), [](const sTreeNode* a, const sTreeNode* b) { return a->mData.start < b->mData.start; });
+
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        TimelineNode& node = sorted[i]->mData;
+        if (node.start < 0) {
+            int offsetFrom0 = 0 - node.start;
+            node.start = 0;
+            node.end += offsetFrom0;
+        }
+
+        if (i + 1 < sorted.size()) {
+            TimelineNode& next = sorted[i + 1]->mData;
+            if (next.start < node.end) {
+                int duration = next.end - next.start;
+                next.start = node.end + 1;
+                next.end = next.start + duration;
+            }
+        }
+    }
+
+    // nodes might have been edited in place, so the summary can't be patched here
+    mSummary.clear();
+    for (const sTreeNode* t : sorted) {
+        mSummary.add(t->mData.start, t->mData.end);
+    }
+
+    mRoot = buildFromSorted(sorted);
+    mbDepthDirty = true;
+    mark_modified();
+
+    return 0;
+}
+
+void IntervalTreeContainer::collect(sTreeNode* t, std::vector<sTreeNode*>& out) const
+{
+    if (t == nullptr) {
+        return;
+    }
+    collect(t->mLeft, out);
+    out.push_back(t);
+    collect(t->mRight, out);
+}
+
+// Builds the Cartesian tree of the sorted nodes in O(n), which is the unique treap for the existing priorities
+IntervalTreeContainer::sTreeNode* IntervalTreeContainer::buildFromSorted(std::vector<sTreeNode*>& sorted)
+{
+    std::vector<sTreeNode*> spine;
+    spine.reserve(64);
+
+    for (sTreeNode* node : sorted) {
+        node->mLeft = nullptr;
+        node->mRight = nullptr;
+
+        sTreeNode* lastPopped = nullptr;
+        while (spine.empty() == false && spine.back()->mPriority < node->mPriority) {
+            lastPopped = spine.back();
+            spine.pop_back();
+
+            // the popped node is final from here on, its children won't change anymore
+            update(lastPopped);
+        }
+
+        node->mLeft = lastPopped;
+        if (spine.empty() == false) {
+            spine.back()->mRight = node;
+        }
+        spine.push_back(node);
+    }
+
+    while (spine.size() > 1) {
+        update(spine.back());
+        spine.pop_back();
+    }
+
+    if (spine.empty()) {
+        return nullptr;
+    }
+
+    update(spine.front());
+    return spine.front();
+}
+
+int IntervalTreeContainer::delete_node(const NodeInitDescriptor& descriptor)
+{
+    int deleteCount = 0;
+    mRoot = eraseContained(mRoot, descriptor.start, descriptor.end, deleteCount);
+
+    if (deleteCount == 0) {
+        LOG_INFO_PRINTF("Trying to delete a node in section %d but no node was deleted...", descriptor.section);
+    } else {
+        LOG_INFO_PRINTF("Deleted %d node(s) between %d and %d", deleteCount, descriptor.start, descriptor.end);
+        mbDepthDirty = true;
+        mark_modified();
+    }
+
+    return deleteCount;
+}
+
+IntervalTreeContainer::sTreeNode* IntervalTreeContainer::eraseContained(sTreeNode* t, s32 start, s32 end, int& deleteCount)
+{
+    // a contained node ends at or after its own start, so a subtree ending before 'start' has nothing to delete
+    if (t == nullptr || t->mMaxEnd < start) {
+        return t;
+    }
+
+    if (t->mData.start >= start) {
+        t->mLeft = eraseContained(t->mLeft, start, end, deleteCount);
+    }
+
+    if (t->mData.start <= end) {
+        t->mRight = eraseContained(t->mRight, start, end, deleteCount);
+    }
+
+    if (t->mData.start >= start && t->mData.end <= end) {
+        sTreeNode* replacement = merge(t->mLeft, t->mRight);
+        auto itIndex = mIDIndex.find(t->mData.GetID());
+        if (itIndex != mIDIndex.end() && itIndex->second == t) {
+            mIDIndex.erase(itIndex);
+        }
+        mSummary.remove(t->mData.start, t->mData.end);
+        delete t;
+        mNodeCount--;
+        deleteCount++;
+        return replacement;
+    }
+
+    update(t);
+    return t;
+}
+
+int IntervalTreeContainer::delete_nodes(const std::vector<NodeID>& ids)
+{
+    int deleteCount = 0;
+
+    for (NodeID id : ids) {
+        auto itIndex = mIDIndex.find(id);
+        if (itIndex == mIDIndex.end()) {
+            continue;
+        }
+
+        sTreeNode* target = itIndex->second;
+        bool bFound = false;
+        mRoot = eraseNode(mRoot, target, true, bFound);
+        if (bFound == false) {
+            // moved in place and not rebuilt yet, so it isn't where its start says
+            mRoot = eraseNode(mRoot, target, false, bFound);
+        }
+        if (bFound == false) {
+            continue;
+        }
+
+        mIDIndex.erase(itIndex);
+        mSummary.remove(target->mData.start, target->mData.end);
+        delete target;
+        mNodeCount--;
+        deleteCount++;
+    }
+
+    if (deleteCount > 0) {
+        LOG_INFO_PRINTF("Deleted %d node(s) by ID", deleteCount);
+        mbDepthDirty = true;
+        mark_modified();
+    }
+
+    return deleteCount;
+}
+
+// Unlinks target without deleting it, with bFollowKey only the subtrees that can hold its start are searched
+IntervalTreeContainer::sTreeNode* IntervalTreeContainer::eraseNode(sTreeNode* t, const sTreeNode* target, bool bFollowKey, bool& outFound)
+{
+    if (t == nullptr) {
+        return nullptr;
+    }
+
+    if (t == target) {
+        outFound = true;
+        return merge(t->mLeft, t->mRight);
+    }
+
+    const s32 key = target->mData.start;
+    if (bFollowKey == false || key <= t->mData.start) {
+        t->mLeft = eraseNode(t->mLeft, target, bFollowKey, outFound);
+    }
+    // equal starts can sit on either side after a split
+    if (outFound == false && (bFollowKey == false || key >= t->mData.start)) {
+        t->mRight = eraseNode(t->mRight, target, bFollowKey, outFound);
+    }
+
+    if (outFound) {
+        update(t);
+    }
+    return t;
+}
+
+TimelineNode* IntervalTreeContainer::get_node_id(const NodeInitDescriptor& descriptor)
+{
+    auto it = mIDIndex.find(descriptor.ID);
+    if (it == mIDIndex.end()) {
+        return nullptr;
+    }
+
+    return &it->second->mData;
+}
+
+std::vector<TimelineNode*> IntervalTreeContainer::get_node_range(const NodeInitDescriptor& descriptor)
+{
+    std::vector<TimelineNode*> nodes;
+    queryContained(mRoot, descriptor.start, descriptor.end, nodes);
+    return nodes;
+}
+
+TimelineNode* IntervalTreeContainer::get_node_at(size_t index)
+{
+    for (sTreeNode* t = mRoot; t != nullptr;) {
+        size_t leftSize = size(t->mLeft);
+        if (index < leftSize) {
+            t = t->mLeft;
+        } else if (index == leftSize) {
+            return &t->mData;
+        } else {
+            index -= leftSize + 1;
+            t = t->mRight;
+        }
+    }
+    return nullptr;
+}
+
+size_t IntervalTreeContainer::find_first_after(s32 timestamp)
+{
+    size_t index = 0;
+    for (sTreeNode* t = mRoot; t != nullptr;) {
+        if (t->mData.start <= timestamp) {
+            index += size(t->mLeft) + 1;
+            t = t->mRight;
+        } else {
+            t = t->mLeft;
+        }
+    }
+    return index;
+}
+
+void IntervalTreeContainer::visit_overlap(s32 start, s32 end, const NodeVisitor& visitor)
+{
+    visitOverlap(mRoot, start, end, visitor);
+}
+
+void IntervalTreeContainer::queryContained(sTreeNode* t, s32 start, s32 end, std::vector<TimelineNode*>& out) const
+{
+    if (t == nullptr || t->mMaxEnd < start) {
+        return;
+    }
+
+    if (t->mData.start >= start) {
+        queryContained(t->mLeft, start, end, out);
+    }
+
+    if (t->mData.start > end) {
+        return;
+    }
+
+    if (t->mData.start >= start && t->mData.end <= end) {
+        out.push_back(&t->mData);
+    }
+
+    queryContained(t->mRight, start, end, out);
+}
+
+// Returns false once the visitor asked to stop
+bool IntervalTreeContainer::visitOverlap(sTreeNode* t, s32 start, s32 end, const NodeVisitor& visitor)
+{
+    if (t == nullptr || t->mMaxEnd < start) {
+        return true;
+    }
+
+    if (visitOverlap(t->mLeft, start, end, visitor) == false) {
+        return false;
+    }
+
+    if (t->mData.start > end) {
+        return true;
+    }
+
+    if (t->mData.end >= start && visitor(t->mData) == false) {
+        return false;
+    }
+
+    return visitOverlap(t->mRight, start, end, visitor);
+}
+
+void IntervalTreeContainer::PerformanceDebugUI() const
+{
+    if (mbDepthDirty) {
+        mCachedDepth = depth(mRoot);
+        mbDepthDirty = false;
+    }
+
+    size_t totalSizeBytes = sizeof(*this) + mNodeCount * sizeof(sTreeNode);
+    double sizeInKB = static_cast<double>(totalSizeBytes) / 1024;
+    s32 idealDepth = mNodeCount > 0 ? static_cast<s32>(std::ceil(std::log2(static_cast<double>(mNodeCount) + 1.0))) : 0;
+
+    ImGui::Text("Timeline Data Size: %.2f KB", sizeInKB);
+    ImGui::SameLine();
+    ImGui::Text("Tree Node Count: %d", (s32)mNodeCount);
+    ImGui::SameLine();
+    ImGui::Text("Tree Depth: %d (balanced: %d)", mCachedDepth, idealDepth);
+    ImGui::SameLine();
+    ImGui::Text("ID Index: %d", (s32)mIDIndex.size());
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "ImDataController.h"
+#include "ImDataSummaryPyramid.h"
+#include <vector>
+#include <unordered_map>
+
+/******
+ IntervalTreeContainer
+ =========================
+ - Nodes are kept in a treap ordered by start, where every tree node is augmented with the largest end of its subtree.
+  That lets overlap and containment queries skip whole subtrees and answer in O(log n + k) instead of scanning the section.
+  Tree nodes are individually allocated, so TimelineNode pointers stay valid when other nodes are inserted or deleted.
+ */
+class IntervalTreeContainer : public ImDataController {
+public:
+    IntervalTreeContainer();
+
+    virtual void iterate(const std::function<void(TimelineNode&)>& func) override;
+    TimelineNode& emplace_back_direct(TimelineNode& node, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    virtual int rebuild(const NodeInitDescriptor& descriptor) override;
+    int delete_node(const NodeInitDescriptor& descriptor) override;
+    int delete_nodes(const std::vector<NodeID>& ids) override;
+    TimelineNode* get_node_id(const NodeInitDescriptor& descriptor) override;
+    std::vector<TimelineNode*> get_node_range(const NodeInitDescriptor& descriptor) override;
+    void visit_overlap(s32 start, s32 end, const NodeVisitor& visitor) override;
+    const NodeSummaryPyramid* get_summary() const override { return &mSummary; }
+    size_t node_count() override { return mNodeCount; }
+    TimelineNode* get_node_at(size_t index) override;
+    size_t find_first_after(s32 timestamp) override;
+
+    virtual void PerformanceDebugUI() const override;
+
+    virtual ~IntervalTreeContainer() override;
+
+private:
+    struct sTreeNode {
+        TimelineNode mData;
+        sTreeNode* mLeft = nullptr;
+        sTreeNode* mRight = nullptr;
+        u32 mPriority = 0;
+        s32 mMaxEnd = 0; // largest end in this subtree
+        size_t mSize = 1; // node count of this subtree, for rank queries
+    };
+
+    struct sOverlapSweep {
+        const sTreeNode* mInserted = nullptr;
+        bool mbHasPrevious = false;
+        bool mbPassedInserted = false;
+        bool mbDone = false;
+        s32 mEndPrevious = 0;
+    };
+
+    static void update(sTreeNode* t);
+    static size_t size(const sTreeNode* t) { return t ? t->mSize : 0; }
+    static void split(sTreeNode* t, s32 key, sTreeNode*& outLeft, sTreeNode*& outRight);
+    static sTreeNode* merge(sTreeNode* left, sTreeNode* right);
+    static void destroy(sTreeNode* t);
+    static s32 depth(const sTreeNode* t);
+    static void iterate(sTreeNode* t, const std::function<void(TimelineNode&)>& func);
+
+    sTreeNode* eraseContained(sTreeNode* t, s32 start, s32 end, int& deleteCount);
+    static sTreeNode* eraseNode(sTreeNode* t, const sTreeNode* target, bool bFollowKey, bool& outFound);
+    void queryContained(sTreeNode* t, s32 start, s32 end, std::vector<TimelineNode*>& out) const;
+    static bool visitOverlap(sTreeNode* t, s32 start, s32 end, const NodeVisitor& visitor);
+    void sweepOverlap(sTreeNode* t, s32 key, sOverlapSweep& sweep);
+    void collect(sTreeNode* t, std::vector<sTreeNode*>& out) const;
+    sTreeNode* buildFromSorted(std::vector<sTreeNode*>& sorted);
+    u32 nextPriority();
+
+    sTreeNode* mRoot = nullptr;
+    size_t mNodeCount = 0;
+    std::unordered_map<NodeID, sTreeNode*> mIDIndex; // tree nodes never move, so the index survives rebalancing
+    u32 mRandomState = 0x9E3779B9u;
+    NodeSummaryPyramid mSummary;
+
+    mutable s32 mCachedDepth = 0;
+    mutable bool mbDepthDirty = true;
+};
@@ -0,0 +1,327 @@
+#include "ImDataControllerMapped.h"
+#include "../TimelineCore/ImTimeline_internal.h"
+#include "../Core/ImTimelineLog.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path)
+{
+    std::shared_ptr<MappedFile> file(new MappedFile());
+
+#ifdef _WIN32
+    // sharing delete lets a save move a new file over this one while it's mapped
+    HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    file->mFileHandle = fileHandle;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(fileHandle, &size) == FALSE || size.QuadPart <= 0) {
+        return nullptr;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        return nullptr;
+    }
+    file->mMappingHandle = mappingHandle;
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    file->mData = static_cast<const u8*>(data);
+    file->mSize = static_cast<uint64_t>(size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    // the mapping keeps the file alive, the descriptor isn't needed past this point
+    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    file->mData = static_cast<const u8*>(data);
+    file->mSize = static_cast<uint64_t>(status.st_size);
+#endif
+
+    return file;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (mData != nullptr) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mMappingHandle));
+    }
+    if (mFileHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mFileHandle));
+    }
+#else
+    if (mData != nullptr) {
+        munmap(const_cast<u8*>(mData), static_cast<size_t>(mSize));
+    }
+#endif
+}
+
+MappedContainer::MappedContainer(std::shared_ptr<MappedFile> file, const sMappedSection& section)
+    : mFile(std::move(file))
+    , mSection(section)
+    , mNodeCount(static_cast<size_t>(section.mSection.mNodeCount))
+{
+    mSummary.attach(section.mSection.mSummaryBucketFrames, static_cast<s32>(section.mSection.mSummaryLevelCount), section.mSummaryEntries,
+        static_cast<size_t>(section.mSection.mSummaryEntryCount), static_cast<size_t>(section.mSection.mSummaryNodeCount), section.mSection.mSummaryOccupiedFrames);
+}
+
+MappedContainer::~MappedContainer()
+{
+    mWritable.reset();
+    mNodeSlots.clear();
+    mNodes.clear();
+}
+
+std::string MappedContainer::getString(u32 index) const
+{
+    if (index >= mSection.mStringCount) {
+        return std::string();
+    }
+
+    const ImTimelineFile::sFileString& entry = mSection.mStrings[index];
+    if (entry.mOffset > mSection.mStringDataSize || entry.mLength > mSection.mStringDataSize - entry.mOffset) {
+        return std::string();
+    }
+
+    return std::string(mSection.mStringData + entry.mOffset, entry.mLength);
+}
+
+TimelineNode& MappedContainer::materialize(size_t index)
+{
+    std::lock_guard<std::mutex> lock(mNodesMutex);
+
+    auto itSlot = mNodeSlots.find(static_cast<u32>(index));
+    if (itSlot != mNodeSlots.end()) {
+        return mNodes[itSlot->second];
+    }
+
+    const ImTimelineFile::sFileNodeInfo& info = mSection.mNodeInfos[index];
+
+    ImTimelineInternal::sNodeRecord record;
+    record.mID = mSection.mIDs[index];
+    record.mSection = mSection.mSection.mID;
+    record.mStart = mSection.mStarts[index];
+    record.mEnd = mSection.mEnds[index];
+    record.mFlags = info.mFlags;
+    record.mText = getString(info.mText);
+    if (info.mDisplayProperties < mSection.mDisplayPropertiesCount) {
+        record.mDisplayProperties = std::make_unique<sGenericDisplayProperties>(ImTimelineFile::FromFile(mSection.mDisplayProperties[info.mDisplayProperties]));
+    }
+
+    mNodeSlots[static_cast<u32>(index)] = static_cast<u32>(mNodes.size());
+    mNodes.emplace_back();
+    record.MoveTo(mNodes.back());
+
+    return mNodes.back();
+}
+
+void MappedContainer::makeWritable()
+{
+    if (mWritable != nullptr) {
+        return;
+    }
+
+    std::vector<TimelineNode> nodes;
+    nodes.reserve(mNodeCount);
+    for (size_t i = 0; i < mNodeCount; ++i) {
+        nodes.push_back(materialize(i));
+    }
+
+    // nodes that were moved through a reference are back in place after the sort, their neighbours are fixed by the next rebuild
+    std::stable_sort(nodes.begin(), nodes.end(), [](const TimelineNode& a, const TimelineNode& b) { return a.start < b.start; });
+
+    mWritable.reset(ImTimelineInternal::CreateDefaultDataController());
+    mWritable->emplace_bulk(nodes);
+    mark_modified();
+
+    // everything is served by the copy from here on, the mapping goes once no other section of the file needs it
+    {
+        std::lock_guard<std::mutex> lock(mNodesMutex);
+        mNodes.clear();
+        mNodes.shrink_to_fit();
+        mNodeSlots.clear();
+    }
+    mFile.reset();
+
+    LOG_INFO_PRINTF("Mapped section %d copied for editing, %d nodes", mSection.mSection.mID, static_cast<s32>(mNodeCount));
+}
+
+void MappedContainer::iterate(const std::function<void(TimelineNode&)>& func)
+{
+    if (mWritable != nullptr) {
+        mWritable->iterate(func);
+        return;
+    }
+
+    for (size_t i = 0; i < mNodeCount; ++i) {
+        func(materialize(i));
+    }
+}
+
+TimelineNode& MappedContainer::emplace_back_direct(TimelineNode& node, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    makeWritable();
+    mark_modified();
+    return mWritable->emplace_back_direct(node, descriptor);
+}
+
+int MappedContainer::rebuild(const NodeInitDescriptor& descriptor)
+{
+    // a rebuild follows edits made through node references, which the mapped columns can't take
+    makeWritable();
+    mark_modified();
+    return mWritable->rebuild(descriptor);
+}
+
+int MappedContainer::delete_node(const NodeInitDescriptor& descriptor)
+{
+    makeWritable();
+    mark_modified();
+    return mWritable->delete_node(descriptor);
+}
+
+int MappedContainer::emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    makeWritable();
+    mark_modified();
+    return mWritable->emplace_bulk(sortedNodes, descriptor);
+}
+
+int MappedContainer::delete_nodes(const std::vector<NodeID>& ids)
+{
+    makeWritable();
+    mark_modified();
+    return mWritable->delete_nodes(ids);
+}
+
+TimelineNode* MappedContainer::get_node_id(const NodeInitDescriptor& descriptor)
+{
+    if (mWritable != nullptr) {
+        return mWritable->get_node_id(descriptor);
+    }
+
+    const ImTimelineFile::sFileIDEntry* begin = mSection.mIDIndex;
+    const ImTimelineFile::sFileIDEntry* end = mSection.mIDIndex + mNodeCount;
+    auto it = std::lower_bound(begin, end, descriptor.ID, [](const ImTimelineFile::sFileIDEntry& entry, NodeID id) { return entry.mID < id; });
+    if (it == end || it->mID != descriptor.ID || it->mIndex >= mNodeCount) {
+        return nullptr;
+    }
+
+    return &materialize(it->mIndex);
+}
+
+std::vector<TimelineNode*> MappedContainer::get_node_range(const NodeInitDescriptor& descriptor)
+{
+    if (mWritable != nullptr) {
+        return mWritable->get_node_range(descriptor);
+    }
+
+    std::vector<TimelineNode*> nodes;
+
+    const s32* starts = mSection.mStarts;
+    size_t first = static_cast<size_t>(std::lower_bound(starts, starts + mNodeCount, descriptor.start) - starts);
+    size_t last = static_cast<size_t>(std::upper_bound(starts, starts + mNodeCount, descriptor.end) - starts);
+
+    for (size_t i = first; i < last; ++i) {
+        if (mSection.mEnds[i] <= descriptor.end) {
+            nodes.push_back(&materialize(i));
+        }
+    }
+
+    return nodes;
+}
+
+void MappedContainer::visit_overlap(s32 start, s32 end, const NodeVisitor& visitor)
+{
+    if (mWritable != nullptr) {
+        mWritable->visit_overlap(start, end, visitor);
+        return;
+    }
+
+    // nothing starting before start - mMaxDuration can still reach into the range
+    const s32* starts = mSection.mStarts;
+    s32 scanFrom = ImDataControllerDetail::LookbackStart(start, mSection.mSection.mMaxDuration);
+    size_t first = static_cast<size_t>(std::lower_bound(starts, starts + mNodeCount, scanFrom) - starts);
+    size_t last = static_cast<size_t>(std::upper_bound(starts, starts + mNodeCount, end) - starts);
+
+    for (size_t i = first; i < last; ++i) {
+        if (mSection.mEnds[i] >= start && visitor(materialize(i)) == false) {
+            return;
+        }
+    }
+}
+
+TimelineNode* MappedContainer::get_node_at(size_t index)
+{
+    if (mWritable != nullptr) {
+        return mWritable->get_node_at(index);
+    }
+
+    return index < mNodeCount ? &materialize(index) : nullptr;
+}
+
+size_t MappedContainer::find_first_after(s32 timestamp)
+{
+    if (mWritable != nullptr) {
+        return mWritable->find_first_after(timestamp);
+    }
+
+    const s32* starts = mSection.mStarts;
+    return static_cast<size_t>(std::upper_bound(starts, starts + mNodeCount, timestamp) - starts);
+}
+
+void MappedContainer::PerformanceDebugUI() const
+{
+    if (mWritable != nullptr) {
+        ImGui::Text("Mapped (copied for editing):");
+        ImGui::SameLine();
+        mWritable->PerformanceDebugUI();
+        return;
+    }
+
+    size_t materializedCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mNodesMutex);
+        materializedCount = mNodes.size();
+    }
+
+    ImGui::Text("Mapped File: %.2f MB", static_cast<double>(mFile->size()) / (1024 * 1024));
+    ImGui::SameLine();
+    ImGui::Text("Materialized: %d / %d", static_cast<s32>(materializedCount), static_cast<s32>(mNodeCount));
+    ImGui::SameLine();
+    ImGui::Text("Materialized Memory: %.2f KB", static_cast<double>(materializedCount * sizeof(TimelineNode)) / 1024);
+}
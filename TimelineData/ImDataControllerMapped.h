@@ -0,0 +1,120 @@
+#pragma once
+#include "ImDataController.h"
+#include "ImDataSummaryPyramid.h"
+#include "../TimelineCore/TimelineFileFormat.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/******
+ MappedFile
+ =========================
+ - Read-only memory mapping of a whole file. Pages are only read from disk when they're first touched.
+ */
+class MappedFile {
+public:
+    static std::shared_ptr<MappedFile> Open(const std::string& path); // nullptr when the file can't be mapped
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const u8* data() const { return mData; }
+    uint64_t size() const { return mSize; }
+
+    // the block of count elements at offset, nullptr when it doesn't lie inside the file or is misaligned
+    template <typename T>
+    const T* get_block(uint64_t offset, uint64_t count) const
+    {
+        if (offset > mSize || count > (mSize - offset) / sizeof(T) || offset % alignof(T) != 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(mData + offset);
+    }
+
+private:
+    MappedFile() { }
+
+    const u8* mData = nullptr;
+    uint64_t mSize = 0;
+#ifdef _WIN32
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
+
+// A section of a mapped file, the columns checked against the file size by whoever opened it
+struct sMappedSection {
+    ImTimelineFile::sFileSection mSection = {};
+    const s32* mStarts = nullptr;
+    const s32* mEnds = nullptr;
+    const NodeID* mIDs = nullptr;
+    const ImTimelineFile::sFileNodeInfo* mNodeInfos = nullptr;
+    const ImTimelineFile::sFileIDEntry* mIDIndex = nullptr;
+    const NodeSummaryPyramid::sEntry* mSummaryEntries = nullptr;
+
+    // shared by every section of the file
+    const ImTimelineFile::sFileString* mStrings = nullptr;
+    u32 mStringCount = 0;
+    const char* mStringData = nullptr;
+    uint64_t mStringDataSize = 0;
+    const ImTimelineFile::sFileDisplayProperties* mDisplayProperties = nullptr;
+    u32 mDisplayPropertiesCount = 0;
+};
+
+/******
+ MappedContainer
+ =========================
+ - Read-only section served straight from a memory-mapped file in the ImTimelineFile format. Range scans and lookups run
+  on the mapped start/end/ID columns like SoAContainer does on its own, so opening a section costs nothing per node.
+  A TimelineNode is only built the first time it's handed out, and kept at the same address afterwards.
+  The first edit copies the section into a default container and forwards everything to it from then on, edits made
+  through handed-out references before that are picked up by the copy. The copy releases the nodes handed out so far,
+  and the mapping along with them, so those references are only valid up to the first edit.
+ */
+class MappedContainer : public ImDataController {
+public:
+    MappedContainer(std::shared_ptr<MappedFile> file, const sMappedSection& section);
+
+    virtual void iterate(const std::function<void(TimelineNode&)>& func) override;
+    TimelineNode& emplace_back_direct(TimelineNode& node, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    virtual int rebuild(const NodeInitDescriptor& descriptor) override;
+    int delete_node(const NodeInitDescriptor& descriptor) override;
+    int emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    int delete_nodes(const std::vector<NodeID>& ids) override;
+    TimelineNode* get_node_id(const NodeInitDescriptor& descriptor) override;
+    std::vector<TimelineNode*> get_node_range(const NodeInitDescriptor& descriptor) override;
+    bool get_contiguous_span(NodeSpan& outSpan) override { return mWritable != nullptr && mWritable->get_contiguous_span(outSpan); }
+    void visit_overlap(s32 start, s32 end, const NodeVisitor& visitor) override;
+    const NodeSummaryPyramid* get_summary() const override { return mWritable != nullptr ? mWritable->get_summary() : &mSummary; }
+    size_t node_count() override { return mWritable != nullptr ? mWritable->node_count() : mNodeCount; }
+    TimelineNode* get_node_at(size_t index) override;
+    size_t find_first_after(s32 timestamp) override;
+
+    bool is_writable() const { return mWritable != nullptr; }
+    size_t get_materialized_count() const { return mNodes.size(); }
+
+    virtual void PerformanceDebugUI() const override;
+
+    virtual ~MappedContainer() override;
+
+private:
+    TimelineNode& materialize(size_t index);
+    void makeWritable();
+    std::string getString(u32 index) const;
+
+    std::shared_ptr<MappedFile> mFile;
+    sMappedSection mSection;
+    size_t mNodeCount = 0;
+    NodeSummaryPyramid mSummary;
+
+    // nodes handed out so far, the deque never moves them
+    mutable std::mutex mNodesMutex;
+    std::deque<TimelineNode> mNodes;
+    std::unordered_map<u32, u32> mNodeSlots; // start order index -> mNodes slot
+
+    std::unique_ptr<ImDataController> mWritable; // after the first edit
+};
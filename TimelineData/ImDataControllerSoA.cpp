@@ -0,0 +1,296 @@
+#include "ImDataControllerSoA.h"
+#include "../Core/ImTimelineLog.h"
+#include <algorithm>
+#include <numeric>
+
+SoAContainer::~SoAContainer()
+{
+    mIDIndex.clear();
+    mCold.clear();
+}
+
+void SoAContainer::iterate(const std::function<void(TimelineNode&)>& func)
+{
+    for (u32 coldSlot : mColdSlots) {
+        func(mCold[coldSlot]);
+    }
+}
+
+void SoAContainer::setTiming(size_t index, s32 start, s32 end)
+{
+    mSummary.remove(mStarts[index], mEnds[index]);
+    mSummary.add(start, end);
+
+    mStarts[index] = start;
+    mEnds[index] = end;
+
+    TimelineNode& cold = mCold[mColdSlots[index]];
+    cold.start = start;
+    cold.end = end;
+}
+
+TimelineNode& SoAContainer::emplace_back_direct(TimelineNode& newElement, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    s32 start = newElement.start;
+    s32 end = newElement.end;
+
+    if (descriptor.bMoveOverlappingNext && start < 0) {
+        end -= start;
+        start = 0;
+    }
+
+    size_t index = static_cast<size_t>(std::upper_bound(mStarts.begin(), mStarts.end(), start) - mStarts.begin());
+
+    u32 coldSlot = 0;
+    if (mFreeColdSlots.empty() == false) {
+        coldSlot = mFreeColdSlots.back();
+        mFreeColdSlots.pop_back();
+        mCold[coldSlot] = newElement;
+    } else {
+        coldSlot = static_cast<u32>(mCold.size());
+        mCold.push_back(newElement); // deque keeps existing elements in place
+    }
+
+    TimelineNode& cold = mCold[coldSlot];
+    cold.start = start;
+    cold.end = end;
+
+    mStarts.insert(mStarts.begin() + index, start);
+    mEnds.insert(mEnds.begin() + index, end);
+    mIDs.insert(mIDs.begin() + index, cold.GetID());
+    mColdSlots.insert(mColdSlots.begin() + index, coldSlot);
+    mMaxDuration = std::max(mMaxDuration, end - start);
+    mSummary.add(start, end);
+    mark_modified();
+
+    if (cold.GetID() != InvalidNodeID) {
+        mIDIndex[cold.GetID()] = coldSlot;
+    }
+
+    if (descriptor.bMoveOverlappingNext) {
+        fix_overlap_from(index);
+    }
+
+    LOG_INFO_PRINTF("Emplaced node ID %d in section %d (start %d)", (s32)cold.GetID(), cold.GetSection(), cold.start);
+
+    return cold;
+}
+
+void SoAContainer::fix_overlap_from(size_t insertedIndex)
+{
+    size_t first = insertedIndex > 0 ? insertedIndex - 1 : insertedIndex;
+
+    for (size_t i = first; i + 1 < mStarts.size(); ++i) {
+        if (mStarts[i + 1] < mEnds[i]) {
+            s32 duration = mEnds[i + 1] - mStarts[i + 1];
+            s32 newStart = mEnds[i] + 1;
+            setTiming(i + 1, newStart, newStart + duration);
+        } else if (i + 1 > insertedIndex) {
+            break;
+        }
+    }
+}
+
+int SoAContainer::rebuild(const NodeInitDescriptor& /*descriptor*/)
+{
+    const size_t count = mColdSlots.size();
+
+    // the side table is what callers edit, so the columns and the summary are refreshed from it first
+    mSummary.clear();
+    mark_modified();
+    for (size_t i = 0; i < count; ++i) {
+        const TimelineNode& cold = mCold[mColdSlots[i]];
+        mStarts[i] = cold.start;
+        mEnds[i] = cold.end;
+        mSummary.add(cold.start, cold.end);
+    }
+
+    std::vector<u32> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [this](u32 a, u32 b) { return mStarts[a] < mStarts[b]; });
+
+    std::vector<s32> starts(count);
+    std::vector<s32> ends(count);
+    std::vector<NodeID> ids(count);
+    std::vector<u32> coldSlots(count);
+    for (size_t i = 0; i < count; ++i) {
+        starts[i] = mStarts[order[i]];
+        ends[i] = mEnds[order[i]];
+        ids[i] = mIDs[order[i]];
+        coldSlots[i] = mColdSlots[order[i]];
+    }
+    mStarts.swap(starts);
+    mEnds.swap(ends);
+    mIDs.swap(ids);
+    mColdSlots.swap(coldSlots);
+
+    mMaxDuration = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (mStarts[i] < 0) {
+            setTiming(i, 0, mEnds[i] - mStarts[i]);
+        }
+
+        if (i + 1 < count && mStarts[i + 1] < mEnds[i]) {
+            s32 duration = mEnds[i + 1] - mStarts[i + 1];
+            setTiming(i + 1, mEnds[i] + 1, mEnds[i] + 1 + duration);
+        }
+
+        mMaxDuration = std::max(mMaxDuration, mEnds[i] - mStarts[i]);
+    }
+
+    return 0;
+}
+
+void SoAContainer::eraseColumns(size_t first, size_t last)
+{
+    mStarts.erase(mStarts.begin() + first, mStarts.begin() + last);
+    mEnds.erase(mEnds.begin() + first, mEnds.begin() + last);
+    mIDs.erase(mIDs.begin() + first, mIDs.begin() + last);
+    mColdSlots.erase(mColdSlots.begin() + first, mColdSlots.begin() + last);
+}
+
+int SoAContainer::delete_node(const NodeInitDescriptor& descriptor)
+{
+    size_t first = static_cast<size_t>(std::lower_bound(mStarts.begin(), mStarts.end(), descriptor.start) - mStarts.begin());
+    size_t last = static_cast<size_t>(std::upper_bound(mStarts.begin(), mStarts.end(), descriptor.end) - mStarts.begin());
+
+    int deleteCount = 0;
+    size_t write = first;
+
+    for (size_t read = first; read < last; ++read) {
+        if (mEnds[read] <= descriptor.end) {
+            u32 coldSlot = mColdSlots[read];
+
+            auto itIndex = mIDIndex.find(mIDs[read]);
+            if (itIndex != mIDIndex.end() && itIndex->second == coldSlot) {
+                mIDIndex.erase(itIndex);
+            }
+
+            mSummary.remove(mStarts[read], mEnds[read]);
+            mCold[coldSlot] = TimelineNode();
+            mFreeColdSlots.push_back(coldSlot);
+            deleteCount++;
+        } else {
+            mStarts[write] = mStarts[read];
+            mEnds[write] = mEnds[read];
+            mIDs[write] = mIDs[read];
+            mColdSlots[write] = mColdSlots[read];
+            write++;
+        }
+    }
+
+    eraseColumns(write, last);
+
+    if (deleteCount > 0) {
+        mark_modified();
+    }
+
+    if (deleteCount == 0) {
+        LOG_INFO_PRINTF("Trying to delete a node in section %d but no node was deleted...", descriptor.section);
+    } else {
+        LOG_INFO_PRINTF("Deleted %d node(s) between %d and %d", deleteCount, descriptor.start, descriptor.end);
+    }
+
+    return deleteCount;
+}
+
+int SoAContainer::delete_nodes(const std::vector<NodeID>& ids)
+{
+    std::vector<bool> isDeleted(mCold.size(), false);
+    int deleteCount = 0;
+
+    for (NodeID id : ids) {
+        auto itIndex = mIDIndex.find(id);
+        if (itIndex != mIDIndex.end()) {
+            isDeleted[itIndex->second] = true;
+            mIDIndex.erase(itIndex);
+            deleteCount++;
+        }
+    }
+
+    if (deleteCount == 0) {
+        return 0;
+    }
+
+    // one compaction pass over the columns, matched by cold slot since a node's start may have been edited in place
+    size_t write = 0;
+    for (size_t read = 0; read < mColdSlots.size(); ++read) {
+        u32 coldSlot = mColdSlots[read];
+        if (isDeleted[coldSlot]) {
+            mSummary.remove(mStarts[read], mEnds[read]);
+            mCold[coldSlot] = TimelineNode();
+            mFreeColdSlots.push_back(coldSlot);
+        } else {
+            mStarts[write] = mStarts[read];
+            mEnds[write] = mEnds[read];
+            mIDs[write] = mIDs[read];
+            mColdSlots[write] = coldSlot;
+            write++;
+        }
+    }
+    eraseColumns(write, mColdSlots.size());
+    mark_modified();
+
+    LOG_INFO_PRINTF("Deleted %d node(s) by ID", deleteCount);
+
+    return deleteCount;
+}
+
+TimelineNode* SoAContainer::get_node_id(const NodeInitDescriptor& descriptor)
+{
+    auto it = mIDIndex.find(descriptor.ID);
+    if (it == mIDIndex.end()) {
+        return nullptr;
+    }
+
+    return &mCold[it->second];
+}
+
+std::vector<TimelineNode*> SoAContainer::get_node_range(const NodeInitDescriptor& descriptor)
+{
+    std::vector<TimelineNode*> nodes;
+
+    size_t first = static_cast<size_t>(std::lower_bound(mStarts.begin(), mStarts.end(), descriptor.start) - mStarts.begin());
+    size_t last = static_cast<size_t>(std::upper_bound(mStarts.begin(), mStarts.end(), descriptor.end) - mStarts.begin());
+
+    for (size_t i = first; i < last; ++i) {
+        if (mEnds[i] <= descriptor.end) {
+            nodes.push_back(&mCold[mColdSlots[i]]);
+        }
+    }
+
+    return nodes;
+}
+
+size_t SoAContainer::find_first_after(s32 timestamp)
+{
+    return static_cast<size_t>(std::upper_bound(mStarts.begin(), mStarts.end(), timestamp) - mStarts.begin());
+}
+
+void SoAContainer::visit_overlap(s32 start, s32 end, const NodeVisitor& visitor)
+{
+    // nothing starting before start - mMaxDuration can still reach into the range
+    s32 scanFrom = ImDataControllerDetail::LookbackStart(start, mMaxDuration);
+    size_t first = static_cast<size_t>(std::lower_bound(mStarts.begin(), mStarts.end(), scanFrom) - mStarts.begin());
+    size_t last = static_cast<size_t>(std::upper_bound(mStarts.begin(), mStarts.end(), end) - mStarts.begin());
+
+    for (size_t i = first; i < last; ++i) {
+        if (mEnds[i] >= start && visitor(mCold[mColdSlots[i]]) == false) {
+            return;
+        }
+    }
+}
+
+void SoAContainer::PerformanceDebugUI() const
+{
+    size_t hotBytes = mStarts.capacity() * sizeof(s32) + mEnds.capacity() * sizeof(s32) + mIDs.capacity() * sizeof(NodeID) + mColdSlots.capacity() * sizeof(u32);
+    size_t coldBytes = mCold.size() * sizeof(TimelineNode);
+
+    ImGui::Text("Hot Columns: %.2f KB", static_cast<double>(hotBytes) / 1024);
+    ImGui::SameLine();
+    ImGui::Text("Side Table: %.2f KB", static_cast<double>(coldBytes) / 1024);
+    ImGui::SameLine();
+    ImGui::Text("Displayed Node Count: %d", (s32)mStarts.size());
+    ImGui::SameLine();
+    ImGui::Text("Free Slots: %d", (s32)mFreeColdSlots.size());
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "ImDataController.h"
+#include "ImDataSummaryPyramid.h"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+/******
+ SoAContainer
+ =========================
+ - Structure-of-arrays layout: the timing and ID columns that every range scan touches are stored in separate, contiguous
+  arrays sorted by start, while labels, display properties and custom nodes stay in a side table of full TimelineNode objects.
+  A visible-range scan only streams through the start/end columns and touches the side table for the nodes it returns.
+  Callers still receive TimelineNode references from the side table, which never moves its entries.
+  Edits made through those references are picked up again by rebuild().
+ */
+class SoAContainer : public ImDataController {
+public:
+    SoAContainer() { }
+
+    virtual void iterate(const std::function<void(TimelineNode&)>& func) override;
+    TimelineNode& emplace_back_direct(TimelineNode& node, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    virtual int rebuild(const NodeInitDescriptor& descriptor) override;
+    int delete_node(const NodeInitDescriptor& descriptor) override;
+    int delete_nodes(const std::vector<NodeID>& ids) override;
+    TimelineNode* get_node_id(const NodeInitDescriptor& descriptor) override;
+    std::vector<TimelineNode*> get_node_range(const NodeInitDescriptor& descriptor) override;
+    void visit_overlap(s32 start, s32 end, const NodeVisitor& visitor) override;
+    const NodeSummaryPyramid* get_summary() const override { return &mSummary; }
+    size_t node_count() override { return mColdSlots.size(); }
+    TimelineNode* get_node_at(size_t index) override { return index < mColdSlots.size() ? &mCold[mColdSlots[index]] : nullptr; }
+    size_t find_first_after(s32 timestamp) override;
+
+    virtual void PerformanceDebugUI() const override;
+
+    virtual ~SoAContainer() override;
+
+private:
+    void fix_overlap_from(size_t insertedIndex);
+    void setTiming(size_t index, s32 start, s32 end);
+    void eraseColumns(size_t first, size_t last);
+
+    // hot columns, all sorted by start and indexed alike
+    std::vector<s32> mStarts;
+    std::vector<s32> mEnds;
+    std::vector<NodeID> mIDs;
+    std::vector<u32> mColdSlots;
+    s32 mMaxDuration = 0; // upper bound of end - start, bounds how far back an overlap scan has to look
+    NodeSummaryPyramid mSummary;
+
+    // cold side table
+    std::deque<TimelineNode> mCold;
+    std::vector<u32> mFreeColdSlots;
+    std::unordered_map<NodeID, u32> mIDIndex; // NodeID -> cold slot
+};
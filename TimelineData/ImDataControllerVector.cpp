@@ -33,18 +33,35 @@ void VectorContainer::PerformanceDebugUI() const
     ImGui::Text("Allocated Node Count: %d", (s32)nodeCountAllocated);
     ImGui::SameLine();
     ImGui::Text("Displayed Node Count: %d", (s32)nodeCount);
+    ImGui::SameLine();
+    ImGui::Text("ID Index: %d", (s32)mIDIndex.size());
 }
 
 VectorContainer::~VectorContainer()
 {
     mContainer.clear();
+    mIDIndex.clear();
+}
+
+// Slots move whenever nodes are inserted, erased or re-sorted, so every slot from fromSlot onwards is written again
+void VectorContainer::reindex(size_t fromSlot)
+{
+    for (size_t slot = fromSlot; slot < mContainer.size(); ++slot) {
+        NodeID id = mContainer[slot].GetID();
+        if (id != InvalidNodeID) {
+            mIDIndex[id] = slot;
+        }
+    }
 }
 
 int VectorContainer::fix_overlap(const NodeInitDescriptor& notused)
 {
     auto start = mContainer.begin();
     auto end = mContainer.end();
-    std::sort(start, end, [](const TimelineNode& a, const TimelineNode& b) { return a.start < b.start; });
+    std::stable_sort(start, end, [](const TimelineNode& a, const TimelineNode& b) { return a.start < b.start; });
+    reindex(0);
+    mMaxDuration = 0;
+    mark_modified();
 
     for (auto it = mContainer.begin(); it != mContainer.end();) {
         if (it->start < 0) {
@@ -66,6 +83,13 @@ int VectorContainer::fix_overlap(const NodeInitDescriptor& notused)
         }
     }
 
+    // nodes might have been edited in place, so the summary can't be patched here
+    mSummary.clear();
+    for (const TimelineNode& node : mContainer) {
+        mMaxDuration = std::max(mMaxDuration, node.end - node.start);
+        mSummary.add(node.start, node.end);
+    }
+
     return 0;
 }
 
@@ -76,58 +100,115 @@ TimelineNode& VectorContainer::emplace_back_direct(TimelineNode& newElement, con
         // mContainer.reserve(mContainer.size() + 1);
     }
 
-    TimelineNode* lastInsertedNode = nullptr;
+    s32 start = newElement.start;
+    s32 end = newElement.end;
 
-    // empty or back
-    if (mContainer.size() == 0 || mContainer.back().start < newElement.start) {
-        auto& newData = mContainer.emplace_back(newElement);
-        lastInsertedNode = &newData;
-        // auto* ptr = std::addressof(mContainer.emplace_back(newElement));
+    if (descriptor.bMoveOverlappingNext && start < 0) {
+        end -= start;
+        start = 0;
     }
 
-    // front insert
-    if (lastInsertedNode == nullptr && mContainer.begin()->start > newElement.start) {
-        mContainer.insert(mContainer.begin(), newElement);
-        lastInsertedNode = &*mContainer.begin();
+    // The container is always sorted by start, new nodes go after nodes with an equal start
+    auto itInsert = std::upper_bound(mContainer.begin(), mContainer.end(), start, [](s32 value, const TimelineNode& node) { return value < node.start; });
+    size_t slot = static_cast<size_t>(itInsert - mContainer.begin());
+
+    mContainer.insert(itInsert, newElement);
+    TimelineNode* lastInsertedNode = &mContainer[slot];
+    lastInsertedNode->start = start;
+    lastInsertedNode->end = end;
+
+    reindex(slot);
+    mMaxDuration = std::max(mMaxDuration, end - start);
+    mark_modified();
+    mSummary.add(start, end);
+
+    if (descriptor.bMoveOverlappingNext) {
+        fix_overlap_from(slot, slot);
     }
 
-    // middle insert
-    if (lastInsertedNode == nullptr) {
-        auto itInsert = mContainer.begin();
+    LOG_INFO_PRINTF("Emplaced node ID %d in section %d (start %d)", (s32)lastInsertedNode->GetID(), lastInsertedNode->GetSection(), lastInsertedNode->start);
 
-        for (auto it = mContainer.begin(); it != mContainer.end(); ++it) {
-            if (it->start < newElement.start) {
-                itInsert = it;
-            } else {
-                break;
-            }
+    return *lastInsertedNode;
+}
+
+int VectorContainer::emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor /* = NodeInitDescriptor() */)
+{
+    if (sortedNodes.empty()) {
+        return 0;
+    }
+
+    if (mContainer.size() + sortedNodes.size() > mContainer.capacity()) {
+        IM_ASSERT(false);
+    }
+
+    IM_ASSERT(std::is_sorted(sortedNodes.begin(), sortedNodes.end(), [](const TimelineNode& a, const TimelineNode& b) { return a.start < b.start; }));
+
+    for (TimelineNode& node : sortedNodes) {
+        if (descriptor.bMoveOverlappingNext && node.start < 0) {
+            node.end -= node.start;
+            node.start = 0;
         }
+        mMaxDuration = std::max(mMaxDuration, node.end - node.start);
+        mSummary.add(node.start, node.end);
+    }
+
+    // merged in place from the back, existing nodes stay in front of new ones with an equal start
+    size_t oldSize = mContainer.size();
+    mContainer.resize(oldSize + sortedNodes.size());
+
+    size_t read = oldSize;
+    size_t readNew = sortedNodes.size();
+    size_t write = mContainer.size();
 
-        if (mContainer.size() > 1 && itInsert != mContainer.end()) {
-            itInsert++;
-            IM_ASSERT(itInsert != mContainer.end()); // there should be a next node
+    while (readNew > 0) {
+        if (read > 0 && mContainer[read - 1].start > sortedNodes[readNew - 1].start) {
+            mContainer[--write] = std::move(mContainer[--read]);
+        } else {
+            mContainer[--write] = sortedNodes[--readNew];
         }
+    }
 
-        IM_ASSERT(mContainer.capacity() > mContainer.size());
-        mContainer.insert(itInsert, newElement);
-        lastInsertedNode = &*itInsert; // TODO there's nothing wrong with it but I dont like this
+    size_t firstInsertedSlot = write;
+    size_t lastInsertedSlot = firstInsertedSlot;
+    for (size_t slot = firstInsertedSlot; slot < mContainer.size(); ++slot) {
+        if (mContainer[slot].start > sortedNodes.back().start) {
+            break;
+        }
+        lastInsertedSlot = slot;
     }
 
-    IM_ASSERT(lastInsertedNode != nullptr);
+    reindex(firstInsertedSlot);
+    mark_modified();
 
-    if (descriptor.bMoveOverlappingNext) 
-    {
-        NodeInitDescriptor descriptor;
-        descriptor.start = 0;
-        s32 result = fix_overlap(descriptor);
+    if (descriptor.bMoveOverlappingNext) {
+        fix_overlap_from(firstInsertedSlot, lastInsertedSlot);
     }
 
-    LOG_INFO_PRINTF("Emplaced node ID %d in section %d (start %d)", (s32)lastInsertedNode->GetID(), lastInsertedNode->GetSection(), lastInsertedNode->start);
+    LOG_INFO_PRINTF("Emplaced %d nodes in section %d", static_cast<s32>(sortedNodes.size()), sortedNodes.front().GetSection());
 
-    return *lastInsertedNode;
+    return static_cast<int>(sortedNodes.size());
+}
 
-    // MEMO: Iterator might become invalidated. As long as the vector is sized, it should be good
-    // It would be safer to research the vector for the last inserted element and return that.
+// Resolves overlap around freshly inserted nodes. Everything before the first insertion point is already free of overlap,
+// so only the nodes from the previous one onwards can move, and the first node after the last insert that fits ends the sweep.
+void VectorContainer::fix_overlap_from(size_t firstInsertedSlot, size_t lastInsertedSlot)
+{
+    size_t first = firstInsertedSlot > 0 ? firstInsertedSlot - 1 : firstInsertedSlot;
+
+    for (size_t i = first; i + 1 < mContainer.size(); ++i) {
+        const TimelineNode& current = mContainer[i];
+        TimelineNode& next = mContainer[i + 1];
+
+        if (next.start < current.end) {
+            int duration = next.end - next.start;
+            mSummary.remove(next.start, next.end);
+            next.start = current.end + 1;
+            next.end = next.start + duration;
+            mSummary.add(next.start, next.end);
+        } else if (i + 1 > lastInsertedSlot) {
+            break;
+        }
+    }
 }
 
 int VectorContainer::rebuild(const NodeInitDescriptor& descriptor)
@@ -141,10 +222,14 @@ int VectorContainer::delete_node(const NodeInitDescriptor& descriptor)
     int end = descriptor.end;
 
     int deleteCount = 0;
+    size_t firstErasedSlot = mContainer.size();
 
     for (auto it = mContainer.begin(); it != mContainer.end();) {
         if (it->start >= start && it->end <= end) {
             LOG_INFO_PRINTF("Deleted node ID %d in section %d (start %d)", (s32)it->GetID(), it->GetSection(), it->start);
+            firstErasedSlot = std::min(firstErasedSlot, static_cast<size_t>(it - mContainer.begin()));
+            mIDIndex.erase(it->GetID());
+            mSummary.remove(it->start, it->end);
             it = mContainer.erase(it);
             deleteCount++;
         } else {
@@ -152,6 +237,12 @@ int VectorContainer::delete_node(const NodeInitDescriptor& descriptor)
         }
     }
 
+    reindex(firstErasedSlot);
+
+    if (deleteCount > 0) {
+        mark_modified();
+    }
+
     if (deleteCount == 0) {
         // TODO rare chance that descriptor.section is not the actual section ID of this container?
         LOG_INFO_PRINTF("Trying to delete a node in section %d but no node was deleted...", descriptor.section);
@@ -160,16 +251,72 @@ int VectorContainer::delete_node(const NodeInitDescriptor& descriptor)
     return deleteCount;
 }
 
-TimelineNode* VectorContainer::get_node_id(const NodeInitDescriptor& descriptor)
+int VectorContainer::delete_nodes(const std::vector<NodeID>& ids)
 {
-    for (auto it = mContainer.begin(); it != mContainer.end(); ++it) {
-        if (it->GetID() == descriptor.ID) {
-            TimelineNode* node = &*it;
-            return node;
+    std::vector<bool> isDeleted(mContainer.size(), false);
+    size_t firstErasedSlot = mContainer.size();
+    int deleteCount = 0;
+
+    for (NodeID id : ids) {
+        auto itIndex = mIDIndex.find(id);
+        if (itIndex != mIDIndex.end()) {
+            isDeleted[itIndex->second] = true;
+            firstErasedSlot = std::min(firstErasedSlot, itIndex->second);
+            mIDIndex.erase(itIndex);
+            deleteCount++;
         }
     }
 
-    return nullptr;
+    if (deleteCount == 0) {
+        return 0;
+    }
+
+    // one compaction pass from the first erased slot
+    size_t write = firstErasedSlot;
+    for (size_t read = firstErasedSlot; read < mContainer.size(); ++read) {
+        if (isDeleted[read]) {
+            mSummary.remove(mContainer[read].start, mContainer[read].end);
+        } else {
+            if (write != read) {
+                mContainer[write] = std::move(mContainer[read]);
+            }
+            write++;
+        }
+    }
+    mContainer.erase(mContainer.begin() + write, mContainer.end());
+
+    reindex(firstErasedSlot);
+    mark_modified();
+
+    LOG_INFO_PRINTF("Deleted %d node(s) by ID", deleteCount);
+
+    return deleteCount;
+}
+
+TimelineNode* VectorContainer::get_node_id(const NodeInitDescriptor& descriptor)
+{
+    auto it = mIDIndex.find(descriptor.ID);
+    if (it == mIDIndex.end()) {
+        return nullptr;
+    }
+
+    TimelineNode* node = &mContainer[it->second];
+    IM_ASSERT(node->GetID() == descriptor.ID);
+    return node;
+}
+
+bool VectorContainer::get_contiguous_span(NodeSpan& outSpan)
+{
+    outSpan.mBegin = mContainer.data();
+    outSpan.mEnd = mContainer.data() + mContainer.size();
+    outSpan.mMaxDuration = mMaxDuration;
+    return true;
+}
+
+size_t VectorContainer::find_first_after(s32 timestamp)
+{
+    auto it = std::upper_bound(mContainer.begin(), mContainer.end(), timestamp, [](s32 value, const TimelineNode& node) { return value < node.start; });
+    return static_cast<size_t>(it - mContainer.begin());
 }
 
 std::vector<TimelineNode*> VectorContainer::get_node_range(const NodeInitDescriptor& descriptor)
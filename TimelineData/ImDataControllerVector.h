@@ -1,5 +1,7 @@
 #include "ImDataController.h"
+#include "ImDataSummaryPyramid.h"
 #include <vector>
+#include <unordered_map>
 
 // template <typename T>
 class VectorContainer : public ImDataController {
@@ -13,16 +15,29 @@ public:
 
     virtual void iterate(const std::function<void(TimelineNode&)>& func) override;
     int fix_overlap(const NodeInitDescriptor& notused);
+    void fix_overlap_from(size_t firstInsertedSlot, size_t lastInsertedSlot);
     TimelineNode& emplace_back_direct(TimelineNode& node, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
+    int emplace_bulk(std::vector<TimelineNode>& sortedNodes, const NodeInitDescriptor& descriptor = NodeInitDescriptor()) override;
     virtual int rebuild(const NodeInitDescriptor& descriptor) override;
     int delete_node(const NodeInitDescriptor& descriptor) override;
+    int delete_nodes(const std::vector<NodeID>& ids) override;
     TimelineNode* get_node_id(const NodeInitDescriptor& descriptor) override;
     std::vector<TimelineNode*> get_node_range(const NodeInitDescriptor& descriptor) override;
+    bool get_contiguous_span(NodeSpan& outSpan) override;
+    const NodeSummaryPyramid* get_summary() const override { return &mSummary; }
+    size_t node_count() override { return mContainer.size(); }
+    TimelineNode* get_node_at(size_t index) override { return index < mContainer.size() ? &mContainer[index] : nullptr; }
+    size_t find_first_after(s32 timestamp) override;
 
     virtual void PerformanceDebugUI() const override;
 
     virtual ~VectorContainer() override;
 
 private:
+    void reindex(size_t fromSlot);
+
     std::vector<TimelineNode> mContainer;
+    std::unordered_map<NodeID, size_t> mIDIndex; // NodeID -> slot in mContainer
+    s32 mMaxDuration = 0; // upper bound of end - start, bounds how far back an overlap scan has to look
+    NodeSummaryPyramid mSummary;
 };
\ No newline at end of file
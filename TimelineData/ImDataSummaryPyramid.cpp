@@ -0,0 +1,220 @@
+#include "ImDataSummaryPyramid.h"
+#include "../dependencies/imgui/imgui.h"
+#include <algorithm>
+
+NodeSummaryPyramid::NodeSummaryPyramid(s32 bucketFrames)
+    : mBucketFrames(bucketFrames > 0 ? bucketFrames : 1)
+{
+}
+
+void NodeSummaryPyramid::clear()
+{
+    mLevels.clear();
+    mbAttached = false;
+    mAttachedEntries = nullptr;
+    mAttachedEntryCount = 0;
+    mAttachedLevelCount = 0;
+    mNodeCount = 0;
+    mOccupiedFrames = 0;
+}
+
+void NodeSummaryPyramid::attach(s32 bucketFrames, s32 levelCount, const sEntry* entries, size_t entryCount, size_t nodeCount, int64_t occupiedFrames)
+{
+    IM_ASSERT(entries != nullptr || entryCount == 0);
+
+    clear();
+    mBucketFrames = bucketFrames > 0 ? bucketFrames : 1;
+    mbAttached = true;
+    mAttachedEntries = entries;
+    mAttachedEntryCount = entryCount;
+    mAttachedLevelCount = std::max(levelCount, 0);
+    mNodeCount = nodeCount;
+    mOccupiedFrames = occupiedFrames;
+}
+
+// Drops level 0, level 1 becomes the new one with buckets twice as wide. A tag lost with level 0 sits under a bucket
+// holding an end of its node, and that bucket carries the node's overlap already.
+void NodeSummaryPyramid::coarsen()
+{
+    if (mLevels.size() > 1) {
+        mLevels.erase(mLevels.begin());
+    } else if (mLevels.size() == 1) {
+        // the single bucket now reaches past the last frame, so every node only touches it
+        sBucket& top = mLevels[0][0];
+        top.mCount = static_cast<u32>(mNodeCount);
+        top.mCoveredCount = 0;
+        top.mOccupiedFrames = static_cast<uint64_t>(mOccupiedFrames);
+    }
+    mBucketFrames *= 2;
+}
+
+// Grows level 0 to the next power of two covering frame, coarsening first when the nodes don't justify that many buckets.
+// Parent indices don't change when a level grows, so existing buckets stay valid. Every node fits into the old top
+// bucket and none covers a new one entirely, so bucket 0 of each new level holds all nodes as overlaps.
+void NodeSummaryPyramid::ensureFrame(s32 frame)
+{
+    const size_t maxBuckets = std::max(kMinBuckets, mNodeCount / kNodesPerBucket + 1);
+    while (static_cast<size_t>(frame / mBucketFrames) + 1 > maxBuckets) {
+        coarsen();
+    }
+
+    size_t requiredBuckets = static_cast<size_t>(frame / mBucketFrames) + 1;
+    if (mLevels.empty() == false && mLevels[0].size() >= requiredBuckets) {
+        return;
+    }
+
+    size_t bucketCount = 1;
+    while (bucketCount < requiredBuckets) {
+        bucketCount <<= 1;
+    }
+
+    sBucket newTop;
+    newTop.mCount = static_cast<u32>(mNodeCount);
+    newTop.mOccupiedFrames = static_cast<uint64_t>(mOccupiedFrames);
+    size_t oldLevelCount = mLevels.size();
+
+    for (size_t level = 0; bucketCount > 0; ++level, bucketCount >>= 1) {
+        if (level < oldLevelCount) {
+            mLevels[level].resize(bucketCount);
+        } else {
+            mLevels.emplace_back(bucketCount);
+            mLevels[level][0] = newTop;
+        }
+    }
+}
+
+void NodeSummaryPyramid::apply(s32 start, s32 end, s32 sign)
+{
+    // frames before 0 are never displayed
+    start = std::max(start, 0);
+    if (end < start) {
+        return;
+    }
+
+    IM_ASSERT(is_attached() == false); // read-only
+
+    if (sign > 0) {
+        ensureFrame(end);
+    }
+
+    IM_ASSERT(mLevels.empty() == false && static_cast<size_t>(end / mBucketFrames) < mLevels[0].size());
+
+    // the buckets holding the first and last frame get the exact overlap, unless the node covers them entirely
+    for (s32 level = 0; level < static_cast<s32>(mLevels.size()); ++level) {
+        const int64_t width = get_bucket_frames(level);
+        const int64_t first = start / width;
+        const int64_t last = end / width;
+
+        for (int64_t bucketIndex : { first, last }) {
+            int64_t bucketStart = bucketIndex * width;
+            int64_t bucketEnd = bucketStart + width - 1;
+            if (start <= bucketStart && end >= bucketEnd) {
+                continue;
+            }
+
+            sBucket& bucket = mLevels[level][static_cast<size_t>(bucketIndex)];
+            bucket.mCount += sign;
+            bucket.mOccupiedFrames += static_cast<uint64_t>(sign * (std::min<int64_t>(end, bucketEnd) - std::max<int64_t>(start, bucketStart) + 1));
+
+            if (first == last) {
+                break;
+            }
+        }
+    }
+
+    // level 0 buckets inside the node, tagged on the highest levels that split the range exactly
+    int64_t left = (static_cast<int64_t>(start) + mBucketFrames - 1) / mBucketFrames;
+    int64_t right = (static_cast<int64_t>(end) + 1) / mBucketFrames;
+    for (size_t level = 0; left < right; ++level, left >>= 1, right >>= 1) {
+        if (left & 1) {
+            mLevels[level][static_cast<size_t>(left++)].mCoveredCount += sign;
+        }
+        if (right & 1) {
+            mLevels[level][static_cast<size_t>(--right)].mCoveredCount += sign;
+        }
+    }
+
+    mNodeCount += sign;
+    mOccupiedFrames += sign * (static_cast<int64_t>(end) - start + 1);
+}
+
+NodeSummaryPyramid::sBucket NodeSummaryPyramid::getStored(s32 level, int64_t index) const
+{
+    if (is_attached()) {
+        const uint64_t key = (static_cast<uint64_t>(level) << 32) | static_cast<uint64_t>(index);
+        const sEntry* end = mAttachedEntries + mAttachedEntryCount;
+        const sEntry* entry = std::lower_bound(mAttachedEntries, end, key, [](const sEntry& a, uint64_t b) { return a.mKey < b; });
+        return entry != end && entry->mKey == key ? entry->mBucket : sBucket();
+    }
+
+    const std::vector<sBucket>& buckets = mLevels[level];
+    return static_cast<size_t>(index) < buckets.size() ? buckets[static_cast<size_t>(index)] : sBucket();
+}
+
+NodeSummaryPyramid::sBucket NodeSummaryPyramid::resolve(s32 level, sBucket stored, u32 parentsCovered) const
+{
+    stored.mCoveredCount += parentsCovered;
+    stored.mCount += stored.mCoveredCount;
+    stored.mOccupiedFrames += static_cast<uint64_t>(stored.mCoveredCount) * static_cast<uint64_t>(get_bucket_frames(level));
+    return stored;
+}
+
+NodeSummaryPyramid::sBucket NodeSummaryPyramid::get_bucket(s32 level, int64_t index) const
+{
+    if (level < 0 || level >= get_level_count() || index < 0 || index >= get_bucket_count(level)) {
+        return sBucket();
+    }
+
+    u32 parentsCovered = 0;
+    for (s32 parent = level + 1; parent < get_level_count(); ++parent) {
+        parentsCovered += getStored(parent, index >> (parent - level)).mCoveredCount;
+    }
+    return resolve(level, getStored(level, index), parentsCovered);
+}
+
+void NodeSummaryPyramid::get_entries(std::vector<sEntry>& outEntries) const
+{
+    outEntries.clear();
+    if (is_attached()) {
+        outEntries.assign(mAttachedEntries, mAttachedEntries + mAttachedEntryCount);
+        return;
+    }
+
+    for (size_t level = 0; level < mLevels.size(); ++level) {
+        for (size_t index = 0; index < mLevels[level].size(); ++index) {
+            const sBucket& bucket = mLevels[level][index];
+            if (bucket.mCount > 0 || bucket.mCoveredCount > 0) {
+                sEntry entry;
+                entry.mKey = (static_cast<uint64_t>(level) << 32) | index;
+                entry.mBucket = bucket;
+                outEntries.push_back(entry);
+            }
+        }
+    }
+}
+
+s32 NodeSummaryPyramid::find_level(f32 pixelsPerFrame, f32 minBucketPixels) const
+{
+    s32 level = 0;
+    while (level + 1 < get_level_count() && get_bucket_frames(level) * pixelsPerFrame < minBucketPixels) {
+        level++;
+    }
+    return level;
+}
+
+f32 NodeSummaryPyramid::get_average_duration() const
+{
+    if (mNodeCount == 0) {
+        return 0.0f;
+    }
+    return static_cast<f32>(static_cast<double>(mOccupiedFrames) / mNodeCount);
+}
+
+size_t NodeSummaryPyramid::get_memory_size() const
+{
+    size_t bytes = sizeof(*this);
+    for (const auto& level : mLevels) {
+        bytes += level.capacity() * sizeof(sBucket);
+    }
+    return bytes;
+}
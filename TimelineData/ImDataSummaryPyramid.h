@@ -0,0 +1,115 @@
+#pragma once
+#include "../Core/CoreDefines.h"
+#include <vector>
+#include <cstdint>
+
+/******
+ NodeSummaryPyramid
+ =========================
+ - Multi-resolution summary of a section: level 0 splits the timeline into buckets of a few frames and every level above
+  merges two neighbouring buckets, up to a single bucket covering everything. A bucket tells how many nodes touch it
+  and how many of its frames they cover.
+  Views use it to draw a zoomed-out section with one bar per bucket instead of one quad per node.
+  A node is stored like a range update in a segment tree: the buckets holding its first and last frame get its exact
+  overlap, the buckets fully inside it are tagged on the highest level possible. Inserting or erasing a node touches a
+  few buckets per level whatever its duration, and get_bucket adds the tags of a bucket's parents.
+  Level 0 keeps to about one bucket per kNodesPerBucket nodes, kMinBuckets at least: once the frames outgrow that,
+  level 0 is dropped and the bucket width doubles, so memory follows the node count and not the time span.
+  A pyramid can also be a read-only view of entries stored elsewhere, such as a memory-mapped file, see attach.
+ */
+class NodeSummaryPyramid {
+public:
+    struct sBucket {
+        u32 mCount = 0; // nodes touching the bucket
+        u32 mCoveredCount = 0; // nodes covering the whole bucket
+        uint64_t mOccupiedFrames = 0; // frames covered by those nodes, overlapping nodes are counted twice
+    };
+
+    // Non-empty stored bucket, mKey is the level in the high 32 bits and the bucket index in the low ones
+    struct sEntry {
+        uint64_t mKey = 0;
+        sBucket mBucket;
+    };
+
+    static constexpr size_t kMinBuckets = 256;
+    static constexpr size_t kNodesPerBucket = 4;
+
+    explicit NodeSummaryPyramid(s32 bucketFrames = 8);
+
+    void add(s32 start, s32 end) { apply(start, end, 1); }
+    void remove(s32 start, s32 end) { apply(start, end, -1); }
+    void clear();
+
+    // Entries owned by someone else, sorted by key. They must outlive the pyramid, which can't be edited afterwards.
+    void attach(s32 bucketFrames, s32 levelCount, const sEntry* entries, size_t entryCount, size_t nodeCount, int64_t occupiedFrames);
+    bool is_attached() const { return mbAttached; }
+
+    s32 get_level_count() const { return is_attached() ? mAttachedLevelCount : static_cast<s32>(mLevels.size()); }
+    int64_t get_bucket_frames(s32 level) const { return static_cast<int64_t>(mBucketFrames) << level; }
+    int64_t get_bucket_count(s32 level) const { return level < get_level_count() ? int64_t(1) << (get_level_count() - 1 - level) : 0; }
+    // Nodes touching bucket index of level and the frames they cover there, tags of the parents included
+    sBucket get_bucket(s32 level, int64_t index) const;
+
+    // Calls visitor(index, bucket) for the buckets first..last of level that nodes touch. Walking neighbours this way
+    // looks each parent's tag up once instead of once per bucket.
+    template <typename F>
+    void for_each_bucket(s32 level, int64_t first, int64_t last, F&& visitor) const
+    {
+        const s32 levelCount = get_level_count();
+        if (level < 0 || level >= levelCount) {
+            return;
+        }
+
+        first = first < 0 ? 0 : first;
+        last = last < get_bucket_count(level) ? last : get_bucket_count(level) - 1;
+
+        // tags of the parents from level p up, for the parent index cached next to it
+        std::vector<int64_t> parentIndex(levelCount + 1, -1);
+        std::vector<u32> coveredAbove(levelCount + 1, 0);
+
+        for (int64_t index = first; index <= last; ++index) {
+            // a parent that didn't change means none above it did either
+            s32 changed = level + 1;
+            while (changed < levelCount && parentIndex[changed] != (index >> (changed - level))) {
+                changed++;
+            }
+            for (s32 parent = changed - 1; parent > level; --parent) {
+                parentIndex[parent] = index >> (parent - level);
+                coveredAbove[parent] = getStored(parent, parentIndex[parent]).mCoveredCount + coveredAbove[parent + 1];
+            }
+
+            sBucket bucket = resolve(level, getStored(level, index), coveredAbove[level + 1]);
+            if (bucket.mCount > 0) {
+                visitor(index, bucket);
+            }
+        }
+    }
+
+    // Non-empty stored buckets sorted by key, the layout attach takes back
+    void get_entries(std::vector<sEntry>& outEntries) const;
+
+    // Lowest level whose buckets are at least minBucketPixels wide, the top level if none is
+    s32 find_level(f32 pixelsPerFrame, f32 minBucketPixels) const;
+
+    size_t get_node_count() const { return mNodeCount; }
+    int64_t get_occupied_frames() const { return mOccupiedFrames; }
+    f32 get_average_duration() const;
+
+    size_t get_memory_size() const;
+
+private:
+    void apply(s32 start, s32 end, s32 sign);
+    void ensureFrame(s32 frame);
+    void coarsen();
+    sBucket getStored(s32 level, int64_t index) const;
+    sBucket resolve(s32 level, sBucket stored, u32 parentsCovered) const;
+
+    s32 mBucketFrames = 8;
+    std::vector<std::vector<sBucket>> mLevels; // level 0 size is a power of two, level n + 1 is half of level n
+    bool mbAttached = false;
+    const sEntry* mAttachedEntries = nullptr;
+    size_t mAttachedEntryCount = 0;
+    s32 mAttachedLevelCount = 0;
+    size_t mNodeCount = 0;
+    int64_t mOccupiedFrames = 0;
+};
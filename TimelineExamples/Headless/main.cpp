@@ -0,0 +1,20 @@
+/**
+ * @file   main.cpp
+ * @brief  Console entry point that runs the data layout benchmarks without a window, for CI or a quick check after
+ * changing a container. Build it with every .cpp file of the repository root, TimelineCore, TimelineData,
+ * TimelineViews and TimelineExamples folders plus the imgui*.cpp sources of dependencies/imgui, no backend is needed.
+ * Link with -lpthread on Linux.
+ * Usage: main [node count] [visible frames] [scans], exits with 1 when the layouts disagree.
+ */
+
+#include "../../TimelineExamples/TimelineBenchmark.h"
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    s32 nodeCount = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    s32 visibleFrames = argc > 2 ? std::atoi(argv[2]) : 200;
+    s32 scanCount = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    return ImTimeline::RunBenchmarksHeadless(nodeCount, visibleFrames, scanCount) ? 0 : 1;
+}
@@ -0,0 +1,472 @@
+#include "TimelineBenchmark.h"
+#include "../Timeline.h"
+#include "../TimelineData/ImDataControllerVector.h"
+#include "../TimelineData/ImDataControllerSoA.h"
+#include "../TimelineData/ImDataControllerChunked.h"
+#include "../TimelineData/ImDataSummaryPyramid.h"
+#include "../TimelineCore/TimelinePlayer.h"
+#include "../TimelineCore/ImTimeline_internal.h"
+#include "../TimelineCore/TimelineSerializer.h"
+#include "../TimelineCore/TimelineTraceImporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+    {
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        return duration.count();
+    }
+
+    void FillSequential(ImDataController& container, s32 nodeCount)
+    {
+        for (s32 i = 0; i < nodeCount; ++i) {
+            TimelineNode node;
+            node.Setup(0, i * 3, i * 3 + 2, "Benchmark Node");
+            container.emplace_back_direct(node);
+        }
+    }
+
+    ImTimeline::sBenchmarkResult ScanVisibleRange(const char* name, ImDataController& container, s32 nodeCount, s32 visibleFrames, s32 scanCount)
+    {
+        ImTimeline::sBenchmarkResult result;
+        result.mName = name;
+        result.mRunCount = scanCount;
+
+        std::mt19937 generator(1234); // same scroll positions for every layout
+        std::uniform_int_distribution<s32> distribution(0, ImMax(nodeCount * 3 - visibleFrames, 0));
+
+        auto start = std::chrono::steady_clock::now();
+        for (s32 i = 0; i < scanCount; ++i) {
+            NodeInitDescriptor viewport;
+            viewport.start = distribution(generator);
+            viewport.end = viewport.start + visibleFrames;
+            result.mItemCount += container.get_node_overlap(viewport).size();
+        }
+        result.mMilliseconds = ElapsedMilliseconds(start);
+
+        return result;
+    }
+
+    // Receives the event batches like a real view would, without drawing anything
+    class CountingPlayerView : public ITimelinePlayerView {
+    public:
+        void OnTimelinePlayStart(const sNodePlayProperties& /*properties*/ = sNodePlayProperties()) override { }
+        void OnNodeActivate(TimelineNode* /*node*/, const sNodePlayProperties& /*properties*/ = sNodePlayProperties()) override { mActivations++; }
+        void OnNodeDeactivate(TimelineNode* /*node*/, const sNodePlayProperties& /*properties*/ = sNodePlayProperties()) override { mDeactivations++; }
+        void Draw() override { }
+
+        size_t mActivations = 0;
+        size_t mDeactivations = 0;
+    };
+}
+
+void ImTimeline::RunVisibleRangeScanBenchmark(s32 nodeCount, s32 visibleFrames, s32 scanCount, std::vector<sBenchmarkResult>& outResults)
+{
+    {
+        VectorContainer arrayOfStructs(static_cast<size_t>(nodeCount));
+        FillSequential(arrayOfStructs, nodeCount);
+        outResults.push_back(ScanVisibleRange("VectorContainer (array of structs)", arrayOfStructs, nodeCount, visibleFrames, scanCount));
+    }
+
+    {
+        SoAContainer structOfArrays;
+        FillSequential(structOfArrays, nodeCount);
+        outResults.push_back(ScanVisibleRange("SoAContainer (hot/cold columns)", structOfArrays, nodeCount, visibleFrames, scanCount));
+    }
+}
+
+void ImTimeline::RunPlaybackSimulationBenchmark(s32 nodeCount, s32 frameStep, std::vector<sBenchmarkResult>& outResults)
+{
+    // nodes start every 2 frames and last 5, so up to three of them overlap at any frame
+    ChunkedContainer section(ImTimelineInternal::TIMELINE_CHUNK_NODE_COUNT);
+    for (s32 i = 0; i < nodeCount; ++i) {
+        TimelineNode node;
+        node.Setup(0, i * 2, i * 2 + 5, "Benchmark Node");
+        section.emplace_back_direct(node);
+    }
+
+    auto view = std::make_shared<CountingPlayerView>();
+    TimelinePlayer player;
+    player.Setup(&section, 0);
+    player.SetViewUI(view);
+    player.SetPlayMode(TimelinePlayer::ePlayMode::Concurrent);
+
+    TimelinePlayer::sSimulationStats stats = player.SimulateRange(0, nodeCount * 2 + 5, frameStep);
+    IM_ASSERT(view->mActivations + view->mDeactivations == stats.mEventCount);
+
+    sBenchmarkResult result;
+    result.mName = "SimulateRange (concurrent, " + std::to_string(static_cast<s32>(stats.GetEventsPerSecond() / 1000000.0)) + "M events/s)";
+    result.mMilliseconds = stats.mSeconds * 1000.0;
+    result.mRunCount = stats.mUpdateCount;
+    result.mItemCount = stats.mEventCount;
+    outResults.push_back(result);
+}
+
+void ImTimeline::RunScrubBenchmark(s32 nodeCount, s32 seekCount, std::vector<sBenchmarkResult>& outResults)
+{
+    const s32 sectionCount = 8;
+    const s32 nodesPerSection = ImMax(nodeCount / sectionCount, 1);
+    const s32 frameCount = nodesPerSection * 2 + 8;
+
+    for (TimelinePlayer::ePlayMode mode : { TimelinePlayer::ePlayMode::Concurrent, TimelinePlayer::ePlayMode::Sequential }) {
+        // every section starts a node every 2 frames lasting 7, so about four of them are under the playhead
+        std::vector<std::unique_ptr<ChunkedContainer>> sections;
+        auto view = std::make_shared<CountingPlayerView>();
+        auto root = std::make_shared<TimelinePlayer>();
+        root->Setup(nullptr, 0);
+
+        for (s32 s = 0; s < sectionCount; ++s) {
+            sections.push_back(std::make_unique<ChunkedContainer>(ImTimelineInternal::TIMELINE_CHUNK_NODE_COUNT));
+            for (s32 i = 0; i < nodesPerSection; ++i) {
+                TimelineNode node;
+                node.Setup(s, i * 2 + s % 2, i * 2 + s % 2 + 7, "Benchmark Node");
+                sections.back()->emplace_back_direct(node);
+            }
+
+            auto player = std::make_shared<TimelinePlayer>();
+            player->Setup(sections.back().get(), 0);
+            player->SetViewUI(view);
+            player->SetPlayMode(mode);
+            root->AddPlayer(player);
+        }
+
+        const char* modeName = mode == TimelinePlayer::ePlayMode::Concurrent ? "concurrent" : "sequential";
+        std::mt19937 generator(1234);
+
+        {
+            std::uniform_int_distribution<s32> distribution(0, frameCount);
+
+            sBenchmarkResult result;
+            result.mName = std::string("Scrub random seeks (") + modeName + ")";
+            result.mRunCount = seekCount;
+
+            size_t eventCount = root->GetEventCount();
+            auto start = std::chrono::steady_clock::now();
+            for (s32 i = 0; i < seekCount; ++i) {
+                root->Seek(distribution(generator));
+            }
+            result.mMilliseconds = ElapsedMilliseconds(start);
+            result.mItemCount = root->GetEventCount() - eventCount;
+            outResults.push_back(result);
+        }
+
+        {
+            // a drag moves the playhead a few frames per UI frame, back and forth
+            std::uniform_int_distribution<s32> distribution(-6, 8);
+
+            sBenchmarkResult result;
+            result.mName = std::string("Scrub drag (") + modeName + ")";
+            result.mRunCount = seekCount;
+
+            s32 timestamp = 0;
+            size_t eventCount = root->GetEventCount();
+            auto start = std::chrono::steady_clock::now();
+            for (s32 i = 0; i < seekCount; ++i) {
+                timestamp = ImClamp(timestamp + distribution(generator), 0, frameCount);
+                root->Seek(timestamp);
+            }
+            result.mMilliseconds = ElapsedMilliseconds(start);
+            result.mItemCount = root->GetEventCount() - eventCount;
+            outResults.push_back(result);
+        }
+    }
+}
+
+void ImTimeline::RunBulkInsertBenchmark(s32 nodeCount, std::vector<sBenchmarkResult>& outResults)
+{
+    const s32 sectionCount = 8;
+
+    // nodes of every section in random order, as an importer reading interleaved events would hand them over
+    std::vector<NodeInitDescriptor> descriptors;
+    descriptors.reserve(nodeCount);
+    for (s32 i = 0; i < nodeCount; ++i) {
+        s32 section = i % sectionCount;
+        s32 start = (i / sectionCount) * 3;
+        descriptors.emplace_back("Benchmark Node", section, start, start + 2, nullptr);
+    }
+    std::shuffle(descriptors.begin(), descriptors.end(), std::mt19937(1234));
+
+    {
+        Timeline timeline;
+
+        sBenchmarkResult result;
+        result.mName = "Insert one by one (AddNewNode)";
+        result.mRunCount = nodeCount;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const NodeInitDescriptor& descriptor : descriptors) {
+            timeline.AddNewNode(descriptor.section, descriptor.start, descriptor.end, descriptor.label);
+        }
+        result.mMilliseconds = ElapsedMilliseconds(start);
+        result.mItemCount = descriptors.size();
+        outResults.push_back(result);
+    }
+
+    {
+        Timeline timeline;
+
+        sBenchmarkResult result;
+        result.mName = "Insert bulk (AddNodesBulk)";
+        result.mRunCount = nodeCount;
+
+        auto start = std::chrono::steady_clock::now();
+        result.mItemCount = timeline.AddNodesBulk(descriptors);
+        result.mMilliseconds = ElapsedMilliseconds(start);
+        outResults.push_back(result);
+
+        sBenchmarkResult undoResult;
+        undoResult.mName = "Undo bulk insert";
+        undoResult.mRunCount = nodeCount;
+        undoResult.mItemCount = descriptors.size();
+
+        start = std::chrono::steady_clock::now();
+        timeline.Undo();
+        undoResult.mMilliseconds = ElapsedMilliseconds(start);
+        outResults.push_back(undoResult);
+    }
+}
+
+void ImTimeline::RunFileBenchmark(s32 nodeCount, s32 visibleFrames, s32 scanCount, std::vector<sBenchmarkResult>& outResults)
+{
+    const s32 sectionCount = 8;
+    const char* path = "ImTimelineBenchmark.imtl";
+
+    std::vector<NodeInitDescriptor> descriptors;
+    descriptors.reserve(nodeCount);
+    for (s32 i = 0; i < nodeCount; ++i) {
+        s32 section = i % sectionCount;
+        s32 start = (i / sectionCount) * 3;
+        descriptors.emplace_back("Benchmark Node " + std::to_string(i % 64), section, start, start + 2, nullptr);
+    }
+
+    {
+        Timeline timeline;
+        timeline.AddNodesBulk(descriptors);
+
+        sSerializerStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (TimelineSerializer::Save(timeline, path, &stats) == false) {
+            return;
+        }
+
+        sBenchmarkResult result;
+        result.mName = "Save (" + std::to_string(static_cast<s32>(stats.GetMegabytesPerSecond())) + " MB/s)";
+        result.mMilliseconds = ElapsedMilliseconds(start);
+        result.mItemCount = stats.mNodeCount;
+        outResults.push_back(result);
+    }
+
+    {
+        Timeline timeline;
+
+        sSerializerStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (TimelineSerializer::Load(timeline, path, &stats) == false) {
+            return;
+        }
+
+        sBenchmarkResult result;
+        result.mName = "Load mapped (" + std::to_string(static_cast<s32>(stats.mFileBytes / (1024 * 1024))) + " MB file)";
+        result.mMilliseconds = ElapsedMilliseconds(start);
+        result.mItemCount = stats.mNodeCount;
+        outResults.push_back(result);
+
+        // the first pass over a range reads the pages and builds its nodes, later passes find them built
+        s32 sectionNodeCount = nodeCount / sectionCount;
+        outResults.push_back(ScanVisibleRange("Visible range scan, mapped (first pass)", *timeline.GetTimelineSection(0).mNodeData, sectionNodeCount, visibleFrames, scanCount));
+        outResults.push_back(ScanVisibleRange("Visible range scan, mapped (second pass)", *timeline.GetTimelineSection(0).mNodeData, sectionNodeCount, visibleFrames, scanCount));
+    }
+
+    std::remove(path);
+}
+
+void ImTimeline::RunTraceImportBenchmark(s32 nodeCount, std::vector<sBenchmarkResult>& outResults)
+{
+    const s32 threadCount = 8;
+    const char* path = "ImTimelineBenchmark.json";
+
+    FILE* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return;
+    }
+
+    // every thread runs a parent slice as a begin/end pair with two complete events nested in it
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Benchmark\"}}");
+    for (s32 i = 0; i < nodeCount; i += 3) {
+        s32 tid = (i / 3) % threadCount;
+        long long ts = static_cast<long long>(i / 3 / threadCount) * 10;
+        std::fprintf(file, ",\n{\"name\":\"Frame\",\"cat\":\"benchmark\",\"ph\":\"B\",\"ts\":%lld,\"pid\":1,\"tid\":%d}", ts, tid);
+        std::fprintf(file, ",\n{\"name\":\"Update\",\"cat\":\"benchmark\",\"ph\":\"X\",\"ts\":%lld.5,\"dur\":4,\"pid\":1,\"tid\":%d,\"args\":{\"index\":%d}}", ts, tid, i);
+        std::fprintf(file, ",\n{\"name\":\"Render\",\"cat\":\"benchmark\",\"ph\":\"X\",\"ts\":%lld.5,\"dur\":3,\"pid\":1,\"tid\":%d,\"args\":{\"index\":%d}}", ts + 5, tid, i + 1);
+        std::fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%lld,\"pid\":1,\"tid\":%d}", ts + 9, tid);
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+
+    {
+        Timeline timeline;
+
+        sTraceImportStats stats;
+        auto start = std::chrono::steady_clock::now();
+        TimelineTraceImporter::Import(timeline, path, sTraceImportSettings(), &stats);
+
+        sBenchmarkResult result;
+        result.mName = "Chrome trace import (" + std::to_string(static_cast<s32>(stats.mBytesRead / (1024 * 1024))) + " MB, "
+            + std::to_string(static_cast<s32>(stats.GetMegabytesPerSecond())) + " MB/s)";
+        result.mMilliseconds = ElapsedMilliseconds(start);
+        result.mItemCount = stats.mNodeCount;
+        outResults.push_back(result);
+    }
+
+    // the same node count spread over ten minutes, a few slices per second per thread: the summaries of the sections
+    // have to follow the node count and not the time span
+    const long long spanMicroseconds = 600LL * 1000 * 1000;
+    const long long spacing = ImMax(spanMicroseconds / ImMax(nodeCount, 1), 1LL);
+
+    file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return;
+    }
+
+    std::fprintf(file, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Benchmark\"}}");
+    for (s32 i = 0; i < nodeCount; ++i) {
+        std::fprintf(file, ",\n{\"name\":\"Tick\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}", i * spacing, ImMax(spacing / 2, 1LL), i % threadCount);
+    }
+    std::fprintf(file, "\n]\n");
+    std::fclose(file);
+
+    {
+        Timeline timeline;
+
+        sTraceImportStats stats;
+        auto start = std::chrono::steady_clock::now();
+        TimelineTraceImporter::Import(timeline, path, sTraceImportSettings(), &stats);
+        double milliseconds = ElapsedMilliseconds(start);
+
+        size_t summaryBytes = 0;
+        for (s32 section = 0; section < static_cast<s32>(stats.mSectionCount); ++section) {
+            const NodeSummaryPyramid* summary = timeline.HasSection(section) ? timeline.GetTimelineSection(section).mNodeData->get_summary() : nullptr;
+            if (summary != nullptr) {
+                summaryBytes += summary->get_memory_size();
+            }
+        }
+
+        sBenchmarkResult result;
+        result.mName = "Chrome trace import, 10 minutes (" + std::to_string(static_cast<s32>(summaryBytes / 1024)) + " KB of summaries, "
+            + std::to_string(static_cast<s32>(summaryBytes / ImMax(stats.mNodeCount, static_cast<size_t>(1)))) + " bytes per node)";
+        result.mMilliseconds = milliseconds;
+        result.mItemCount = stats.mNodeCount;
+        outResults.push_back(result);
+    }
+
+    std::remove(path);
+}
+
+bool ImTimeline::RunBenchmarksHeadless(s32 nodeCount, s32 visibleFrames, s32 scanCount)
+{
+    nodeCount = ImMax(nodeCount, 1);
+    visibleFrames = ImMax(visibleFrames, 1);
+    scanCount = ImMax(scanCount, 1);
+
+    std::vector<sBenchmarkResult> results;
+    RunVisibleRangeScanBenchmark(nodeCount, visibleFrames, scanCount, results);
+
+    // every layout scans the same scroll positions over the same nodes
+    bool bIsConsistent = true;
+    for (const sBenchmarkResult& result : results) {
+        bIsConsistent &= result.mItemCount == results.front().mItemCount;
+    }
+
+    RunPlaybackSimulationBenchmark(nodeCount, 16, results);
+
+    std::printf("%-60s %12s %14s %10s\n", "Benchmark", "Total (ms)", "Per run (ms)", "Items");
+    for (const sBenchmarkResult& result : results) {
+        std::printf("%-60s %12.3f %14.4f %10d\n", result.mName.c_str(), result.mMilliseconds, result.mMilliseconds / ImMax(result.mRunCount, 1),
+            static_cast<s32>(result.mItemCount));
+    }
+
+    if (bIsConsistent == false) {
+        std::printf("Visible-range scans returned different node counts per layout\n");
+    }
+
+    return bIsConsistent;
+}
+
+void ImTimeline::ShowBenchmarkWindow()
+{
+    static s32 nodeCount = 1000000;
+    static s32 visibleFrames = 200;
+    static s32 scanCount = 100;
+    static s32 frameStep = 16;
+    static s32 seekCount = 100000;
+    static std::vector<sBenchmarkResult> results;
+
+    ImGui::Begin("Timeline Benchmarks");
+
+    ImGui::PushItemWidth(120);
+    ImGui::InputInt("Node Count", &nodeCount);
+    ImGui::InputInt("Visible Frames", &visibleFrames);
+    ImGui::InputInt("Scans", &scanCount);
+    ImGui::InputInt("Frames per Update", &frameStep);
+    ImGui::InputInt("Seeks", &seekCount);
+    ImGui::PopItemWidth();
+
+    if (ImGui::Button("Run visible-range scan")) {
+        results.clear();
+        RunVisibleRangeScanBenchmark(ImMax(nodeCount, 1), ImMax(visibleFrames, 1), ImMax(scanCount, 1), results);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Run playback simulation")) {
+        results.clear();
+        RunPlaybackSimulationBenchmark(ImMax(nodeCount, 1), ImMax(frameStep, 1), results);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Run scrub")) {
+        results.clear();
+        RunScrubBenchmark(ImMax(nodeCount, 1), ImMax(seekCount, 1), results);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Run bulk insert")) {
+        results.clear();
+        RunBulkInsertBenchmark(ImMax(nodeCount, 1), results);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Run save/load")) {
+        results.clear();
+        RunFileBenchmark(ImMax(nodeCount, 1), ImMax(visibleFrames, 1), ImMax(scanCount, 1), results);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Run trace import")) {
+        results.clear();
+        RunTraceImportBenchmark(ImMax(nodeCount, 1), results);
+    }
+
+    if (results.empty() == false && ImGui::BeginTable("BenchmarkResults", 4, ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("Benchmark");
+        ImGui::TableSetupColumn("Total (ms)");
+        ImGui::TableSetupColumn("Per run (ms)");
+        ImGui::TableSetupColumn("Items");
+        ImGui::TableHeadersRow();
+
+        for (const auto& result : results) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%s", result.mName.c_str());
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.3f", result.mMilliseconds);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.4f", result.mMilliseconds / ImMax(result.mRunCount, 1));
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%d", (s32)result.mItemCount);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
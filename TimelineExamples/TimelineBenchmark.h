@@ -0,0 +1,38 @@
+#pragma once
+#include "../Core/CoreDefines.h"
+
+namespace ImTimeline
+{
+    struct sBenchmarkResult {
+        std::string mName;
+        double mMilliseconds = 0.0;
+        s32 mRunCount = 1;
+        size_t mItemCount = 0; // nodes returned or events processed, depending on the benchmark
+    };
+
+    void ShowBenchmarkWindow();
+
+    // Runs the layout benchmarks without ImGui and prints the results to stdout. Returns false when the data layouts
+    // disagree on what a scan returns, so the numbers aren't comparing different work.
+    bool RunBenchmarksHeadless(s32 nodeCount, s32 visibleFrames, s32 scanCount);
+
+    // Scans the visible frame range of a section at random scroll positions, once per data layout
+    void RunVisibleRangeScanBenchmark(s32 nodeCount, s32 visibleFrames, s32 scanCount, std::vector<sBenchmarkResult>& outResults);
+
+    // Simulates a section of overlapping nodes headless in concurrent mode, every node fires an activation and a deactivation
+    void RunPlaybackSimulationBenchmark(s32 nodeCount, s32 frameStep, std::vector<sBenchmarkResult>& outResults);
+
+    // Seeks a timeline of several overlapping sections, at random positions and as a mouse drag over the header would
+    void RunScrubBenchmark(s32 nodeCount, s32 seekCount, std::vector<sBenchmarkResult>& outResults);
+
+    // Adds shuffled nodes over several sections one by one and with Timeline::AddNodesBulk, then undoes the bulk insert
+    void RunBulkInsertBenchmark(s32 nodeCount, std::vector<sBenchmarkResult>& outResults);
+
+    // Saves a timeline of several sections to the native binary format and loads it back memory-mapped, then scans the
+    // visible range of the loaded sections, which is where the nodes are first read from the file
+    void RunFileBenchmark(s32 nodeCount, s32 visibleFrames, s32 scanCount, std::vector<sBenchmarkResult>& outResults);
+
+    // Writes a Chrome trace of complete events and begin/end pairs over several threads and imports it, the result names the parse rate.
+    // A second trace spreads as many nodes over ten minutes, its result names the memory the section summaries take per node.
+    void RunTraceImportBenchmark(s32 nodeCount, std::vector<sBenchmarkResult>& outResults);
+}
@@ -1,4 +1,5 @@
 #include "TimelineExample.h"
+#include "TimelineBenchmark.h"
 #include "../ImTimeline.h"
 #include "../Timeline.h"
 #include "../TimelineViews/CustomNodeTest.h"
@@ -8,6 +9,7 @@ void ImTimeline::ShowDemoWindow()
     enum eExampleType {
         ExampleType_ObjectOriented = 0,
         ExampleType_Immediate,
+        ExampleType_Benchmark,
     };
 
     static int toggleValue = 0;
@@ -15,6 +17,8 @@ void ImTimeline::ShowDemoWindow()
     ImGui::SameLine();
     ImGui::RadioButton("Immediate (ImGui style)", &toggleValue, eExampleType::ExampleType_Immediate);
     ImGui::SameLine();
+    ImGui::RadioButton("Benchmarks", &toggleValue, eExampleType::ExampleType_Benchmark);
+    ImGui::SameLine();
 
     static bool imguiDemoWindow = false;
     ImGui::Checkbox("Show ImGUI demo window", &imguiDemoWindow);
@@ -26,6 +30,9 @@ void ImTimeline::ShowDemoWindow()
     case eExampleType::ExampleType_Immediate: {
         ShowDemoWindowImmediate();
     } break;
+    case eExampleType::ExampleType_Benchmark: {
+        ShowBenchmarkWindow();
+    } break;
     default:
         break;
     }
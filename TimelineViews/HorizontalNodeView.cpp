@@ -3,12 +3,17 @@
 #include "../Core/CoreDefines.h"
 #include "../Core/ImTimelineUtility.h"
 #include "../TimelineData/ImDataController.h"
+#include "../TimelineData/ImDataSummaryPyramid.h"
 #include "../Timeline.h"
 
 
 void HorizontalNodeView::PreDraw() 
 {
     mNodesDrawSkipped = 0;
+    mNodesVisited = 0;
+    mNodesDrawn = 0;
+    mSummaryBarsDrawn = 0;
+    mSummaryLevel = -1;
 }
 
 void HorizontalNodeView::DrawNodeView(const ImRect &area, const sTimelineSection& timeline, ImTimeline::Timeline* pContext)
@@ -61,52 +66,69 @@ void HorizontalNodeView::DrawNodeView(const ImRect &area, const sTimelineSection
     size_t sectionHeight = timeline.mProps.mDisplayProperties.mHeight;
 
     s32 index = 0;
+    s32 scale = pContext->GetScale();
 
-    item_list->iterate([&](TimelineNode& node) {
-        index++;
-        if (node.mFlags.test(eTimelineNodeFlags::TimelineNodeFlags_AutofitHeight) == false) {
-            sectionHeight = node.displayProperties.mHeight;
-        }
+    // only nodes overlapping the visible frames are visited, one frame of margin on each side covers the partially visible ones.
+    // The frame count comes from the same truncated scale the node rects are built with.
+    s32 visibleFrameCount = static_cast<s32>((canvas_size.x - pContext->mStyle.LegendWidth) / ImMax(scale, 1));
+    s32 firstVisibleFrame = static_cast<s32>(pContext->GetStartTimestamp()) - 1;
+    s32 lastVisibleFrame = static_cast<s32>(pContext->GetStartTimestamp()) + visibleFrameCount + 1;
 
-        if (pContext->IsDragging() && pContext->mDragData.DragNode.GetID() == node.GetID()) {
-            return;
-        }
+    // once nodes shrink to a few pixels, one density bar per summary bucket replaces the per-node quads and text
+    const NodeSummaryPyramid* summary = item_list->get_summary();
+    bool bDrawSummary = summary != nullptr && summary->get_node_count() > 0 && summary->get_average_duration() * scale < pContext->mStyle.LodNodePixelThreshold;
 
-        s32 scale = pContext->GetScale();
+    if (bDrawSummary) {
+        drawSummary(*summary, timelinePanelRect, static_cast<f32>(sectionHeight), firstVisibleFrame, lastVisibleFrame, scale, pContext);
+    } else {
+        item_list->for_each_in_range(firstVisibleFrame, lastVisibleFrame, [&](TimelineNode& node) {
+            index++;
+            mNodesVisited++;
+
+            size_t nodeHeight = sectionHeight;
+            if (node.mFlags.test(eTimelineNodeFlags::TimelineNodeFlags_AutofitHeight) == false) {
+                nodeHeight = node.displayProperties.mHeight;
+            }
 
-        ImVec2 slotP1(timelinePanelRect.Min.x + node.start * scale, timelinePanelRect.Min.y);
-        ImVec2 slotP2(timelinePanelRect.Min.x + node.end * scale + scale, slotP1.y + sectionHeight - node.displayProperties.AccentThickness);
+            if (pContext->IsDragging() && pContext->mDragData.DragNode.GetID() == node.GetID()) {
+                return;
+            }
 
-        ImRect nodeRect = ImRect(slotP1, slotP2);
+            ImVec2 slotP1(timelinePanelRect.Min.x + node.start * scale, timelinePanelRect.Min.y);
+            ImVec2 slotP2(timelinePanelRect.Min.x + node.end * scale + scale, slotP1.y + nodeHeight - node.displayProperties.AccentThickness);
 
-        bool canDraw = slotP1.x <= (canvas_size.x + contentMin.x) && slotP2.x >= (contentMin.x + pContext->mStyle.LegendWidth);
+            ImRect nodeRect = ImRect(slotP1, slotP2);
 
-        if (!canDraw) {
-            mNodesDrawSkipped++;
-            return;
-        }
+            bool canDraw = slotP1.x <= (canvas_size.x + contentMin.x) && slotP2.x >= (contentMin.x + pContext->mStyle.LegendWidth);
 
-        defaultNodeDraw(nodeRect, node, pContext);
+            if (!canDraw) {
+                mNodesDrawSkipped++;
+                return;
+            }
+
+            defaultNodeDraw(nodeRect, node, pContext);
+            mNodesDrawn++;
 
 #if defined IM_TIMELINE_DEBUG_INFO
-        std::string nodeDebugText = "";
-        ImTimelineUtility::sprint_f(nodeDebugText, "id: %d - index: %d", node.ID, index);
-        draw_list->AddText(nodeRect.Min + ImVec2(10, 20), node.displayProperties.mForegroundColor, nodeDebugText.c_str());
+            std::string nodeDebugText = "";
+            ImTimelineUtility::sprint_f(nodeDebugText, "id: %d - index: %d", node.ID, index);
+            draw_list->AddText(nodeRect.Min + ImVec2(10, 20), node.displayProperties.mForegroundColor, nodeDebugText.c_str());
 #endif
-        bool bIsSelected = ImRect(slotP1, slotP2).Contains(pContext->GetLastInputData().MousePos) && pContext->GetLastInputData().LeftMouseDown;
-        bool bInputDelay = (pContext->GetLastInputData().MouseDownDuration > 40.0f);
-
-        if (bIsSelected && pContext->mDragData.DragState == eDragState::None) {
-            pContext->SelectNode(&node);
-        }
-
-        if (bIsSelected && pContext->IsDragging() == false && bInputDelay) {
-            pContext->mDragData.DragState = eDragState::DragNode;
-            pContext->mDragData.DragNode = *pContext->GetSelectedNode();
-            pContext->mDragData.DragStartMouseDelta = pContext->GetLastInputData().MousePos - slotP1;
-            pContext->mDragData.DragRect = nodeRect;
-        }
-    });
+            bool bIsSelected = ImRect(slotP1, slotP2).Contains(pContext->GetLastInputData().MousePos) && pContext->GetLastInputData().LeftMouseDown;
+            bool bInputDelay = (pContext->GetLastInputData().MouseDownDuration > 40.0f);
+
+            if (bIsSelected && pContext->mDragData.DragState == eDragState::None) {
+                pContext->SelectNode(&node);
+            }
+
+            if (bIsSelected && pContext->IsDragging() == false && bInputDelay) {
+                pContext->mDragData.DragState = eDragState::DragNode;
+                pContext->mDragData.DragNode = *pContext->GetSelectedNode();
+                pContext->mDragData.DragStartMouseDelta = pContext->GetLastInputData().MousePos - slotP1;
+                pContext->mDragData.DragRect = nodeRect;
+            }
+        });
+    }
 
     draw_list->PopClipRect();
 
@@ -115,6 +137,26 @@ void HorizontalNodeView::DrawNodeView(const ImRect &area, const sTimelineSection
     }
 }
 
+void HorizontalNodeView::drawSummary(const NodeSummaryPyramid& summary, const ImRect& panelRect, f32 height, s32 firstFrame, s32 lastFrame, s32 scale, const ImTimeline::Timeline* pContext)
+{
+    auto* draw_list = ImGui::GetWindowDrawList();
+
+    s32 level = summary.find_level(static_cast<f32>(scale), pContext->mStyle.LodBarMinWidth);
+    int64_t bucketFrames = summary.get_bucket_frames(level);
+    f32 bucketWidth = static_cast<f32>(bucketFrames) * scale;
+
+    mSummaryLevel = ImMax(mSummaryLevel, level);
+
+    summary.for_each_bucket(level, ImMax(firstFrame, 0) / bucketFrames, lastFrame / bucketFrames, [&](int64_t bucketIndex, const NodeSummaryPyramid::sBucket& bucket) {
+        f32 density = ImMin(static_cast<f32>(bucket.mOccupiedFrames) / bucketFrames, 1.0f);
+        f32 barHeight = ImMax(height * density, 1.0f);
+        f32 x = panelRect.Min.x + bucketIndex * bucketWidth;
+
+        draw_list->AddRectFilled(ImVec2(x, panelRect.Min.y + height - barHeight), ImVec2(x + bucketWidth, panelRect.Min.y + height), pContext->mStyle.LodBarColor);
+        mSummaryBarsDrawn++;
+    });
+}
+
 void HorizontalNodeView::defaultNodeDraw(const ImRect& area, const TimelineNode& node, ImTimeline::Timeline* timeline)
 {
     bool bSelected = timeline->GetSelectedNode() == &node;
@@ -163,7 +205,20 @@ void HorizontalNodeView::defaultNodeDraw(const ImRect& area, const TimelineNode&
 
 void HorizontalNodeView::PerformanceDebugUI() const
 {
-    ImGui::Text("Nodes Draw Skipped: %d", mNodesDrawSkipped);
+    f32 visitedPerDrawn = mNodesDrawn > 0 ? static_cast<f32>(mNodesVisited) / mNodesDrawn : 0.0f;
+
+    ImGui::Text("Nodes Visited: %d", mNodesVisited);
+    ImGui::SameLine();
+    ImGui::Text("Drawn: %d", mNodesDrawn);
+    ImGui::SameLine();
+    ImGui::Text("Draw Skipped: %d", mNodesDrawSkipped);
+    ImGui::SameLine();
+    ImGui::Text("Visited/Drawn: %.2f", visitedPerDrawn);
+
+    if (mSummaryLevel >= 0) {
+        ImGui::SameLine();
+        ImGui::Text("Summary Bars: %d (level %d)", mSummaryBarsDrawn, mSummaryLevel);
+    }
 }
 
 void HorizontalNodeView::DrawLegendArea(const sTimelineSection& timeline, ImTimeline::Timeline* pContext, const ImRect& area)
@@ -1,6 +1,8 @@
 #pragma once
 #include "../TimelineViews/INodeView.h"
 
+class NodeSummaryPyramid;
+
 class HorizontalNodeView : public INodeView 
 {
 public:
@@ -16,5 +18,11 @@ public:
     virtual void DrawLegendArea(const sTimelineSection& timeline, ImTimeline::Timeline* pContext, const ImRect& area);
 
 private:
-    int mNodesDrawSkipped = 0;
+    void drawSummary(const NodeSummaryPyramid& summary, const ImRect& panelRect, f32 height, s32 firstFrame, s32 lastFrame, s32 scale, const ImTimeline::Timeline* pContext);
+
+    int mNodesDrawSkipped = 0; // visited, but outside of the content area after all
+    int mNodesVisited = 0;
+    int mNodesDrawn = 0;
+    int mSummaryBarsDrawn = 0;
+    int mSummaryLevel = -1; // -1 when every section was drawn node by node
 };
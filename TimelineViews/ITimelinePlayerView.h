@@ -10,6 +10,18 @@ public:
     virtual void OnTimelinePlayStart(const sNodePlayProperties& properties = sNodePlayProperties()) = 0; // timeline play
     virtual void OnNodeActivate(TimelineNode* node, const sNodePlayProperties& properties = sNodePlayProperties()) = 0; // node play
     virtual void OnNodeDeactivate(TimelineNode* node, const sNodePlayProperties& properties = sNodePlayProperties()) = 0; // node stop play
+
+    // Every activation and deactivation of one player update, ordered by timestamp. Forwards to the single-node callbacks by default.
+    virtual void OnNodeEvents(const sNodePlayEvent* events, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            if (events[i].mType == eNodePlayEventType::Activate) {
+                OnNodeActivate(events[i].mNode, events[i].mProperties);
+            } else {
+                OnNodeDeactivate(events[i].mNode, events[i].mProperties);
+            }
+        }
+    }
     virtual void Draw() = 0;
     virtual void OnFinalize() {}
 